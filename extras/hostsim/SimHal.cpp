@@ -0,0 +1,787 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#include "Arduino.h"
+#include <stdarg.h>
+#include <chrono>
+#include "SimHal.hpp"
+
+#define SIM_TX_QUEUE 8              // packets sendData() holds per session
+#define SIM_RX_TIMEOUT 0x21         // measurement status: no response
+#define SIM_TX_OK 0x00              // DATA_TRANSMIT_NTF status
+#define SIM_TX_ERROR 0x02
+
+static uint64_t hostMicros(void)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+SimHal &SimHal::instance()
+{
+    static SimHal hal;
+    return hal;
+}
+
+uwb::UwbHal &uwb::UwbHal::getInstance()
+{
+    return SimHal::instance();
+}
+
+uwb::UwbHal &UWBHAL = uwb::UwbHal::getInstance();
+
+SimHal::SimHal()
+    : rng(1), nextOrder(0), nextHandle(0x1000), nearbyMs(120), sessionLimit(5),
+      deviceState(uwb::DeviceState::NOT_INITIALIZED), logLevel(uwb::LogLevel::UWB_INFO_LEVEL), clock(0),
+      target(0), busy(false), quit(false)
+{
+    userNotificationCallback = nullptr;
+    mPrintCallback = nullptr;
+    resetReport();
+}
+
+SimHal::~SimHal()
+{
+    {
+        std::lock_guard<std::mutex> g(mtx);
+        quit = true;
+    }
+    wake.notify_all();
+    if (thread.joinable())
+        thread.join();
+}
+
+void SimHal::seed(uint32_t s)
+{
+    std::lock_guard<std::mutex> g(mtx);
+    rng.seed(s);
+}
+
+int SimHal::addPeer(const SimPeer &peer)
+{
+    std::lock_guard<std::mutex> g(mtx);
+    peerList.push_back(peer);
+    return peerList.size() - 1;
+}
+
+void SimHal::resetReport(void)
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+void SimHal::printReport(void) const
+{
+    SimHal *self = const_cast<SimHal *>(this);
+    double speedup = stats.wallUs ? (double)stats.simUs / stats.wallUs : 0;
+    self->Log_I("Simulation: %.1f s simulated in %.3f s (x%.1f)", stats.simUs / 1e6, stats.wallUs / 1e6, speedup);
+    self->Log_I("  notifications %llu, callbacks %llu us (max %llu us)", (unsigned long long)stats.notifications,
+                (unsigned long long)stats.callbackUs, (unsigned long long)stats.maxCallbackUs);
+    self->Log_I("  rounds %llu, measurements %llu, lost %llu, nlos %llu", (unsigned long long)stats.rounds,
+                (unsigned long long)stats.measurements, (unsigned long long)stats.lost, (unsigned long long)stats.nlos);
+    self->Log_I("  data sent %llu, failed %llu, received %llu", (unsigned long long)stats.dataSent,
+                (unsigned long long)stats.dataFailed, (unsigned long long)stats.dataReceived);
+}
+
+void SimHal::advance(uint64_t us)
+{
+    if (std::this_thread::get_id() == thread.get_id())
+        return;
+    uint64_t start = hostMicros();
+    std::unique_lock<std::mutex> lk(mtx);
+    target = clock + us;
+    // nothing due: no round trip through the simulation thread
+    if (events.empty() || events.top().time > target) {
+        clock = target;
+    } else {
+        if (!thread.joinable())
+            thread = std::thread(&SimHal::run, this);
+        busy = true;
+        wake.notify_all();
+        done.wait(lk, [this] { return !busy; });
+    }
+    stats.simUs += us;
+    stats.wallUs += hostMicros() - start;
+}
+
+void SimHal::run(void)
+{
+    std::unique_lock<std::mutex> lk(mtx);
+    while (true) {
+        wake.wait(lk, [this] { return quit || busy; });
+        if (quit)
+            return;
+        while (!events.empty() && events.top().time <= target) {
+            Event ev = events.top();
+            events.pop();
+            clock = ev.time;
+            process(lk, ev);
+        }
+        clock = target;
+        busy = false;
+        done.notify_all();
+    }
+}
+
+void SimHal::schedule(Event ev)
+{
+    ev.order = nextOrder++;
+    events.push(ev);
+}
+
+void SimHal::notifyStatus(uint32_t handle, uwb::SessionStatus status)
+{
+    Event ev;
+    ev.time = clock;
+    ev.kind = STATUS;
+    ev.handle = handle;
+    ev.generation = 0;
+    ev.status = status;
+    ev.peer = -1;
+    schedule(ev);
+}
+
+void SimHal::process(std::unique_lock<std::mutex> &lk, const Event &ev)
+{
+    switch (ev.kind) {
+    case STATUS: {
+        uwb::SessionInfo info;
+        info.sessionHandle = ev.handle;
+        info.state = (uint8_t)ev.status;
+        info.reason_code = 0;
+        deliver(lk, uwb::NotificationType::SESSION_DATA, &info);
+        break;
+    }
+    case ROUND:
+        round(lk, ev);
+        break;
+    case DATA_RX:
+        receive(lk, ev);
+        break;
+    }
+}
+
+void SimHal::round(std::unique_lock<std::mutex> &lk, const Event &ev)
+{
+    Session *s = find(ev.handle);
+    if (!s || s->state != uwb::SessionStatus::ACTIVE || s->generation != ev.generation)
+        return;
+
+    stats.rounds++;
+    s->seq++;
+    uwb::RangingResult result;
+    memset(&result, 0, sizeof(result));
+    result.ranging_measure_type = (uint8_t)uwb::MeasurementType::TWO_WAY;
+    result.mac_addr_mode_indicator = 0;
+    result.sequence_number = s->seq;
+    result.session_handle = s->handle;
+    result.range_interval_ms = s->intervalMs;
+
+    // the whole round is drawn before the first callback, which may change the session
+    bool report = s->ntf == 1;
+    uint8_t n = 0;
+    for (size_t i = 0; i < s->peers.size() && n < uwb::MAX_RESPONDERS; i++) {
+        uwb::twr_mesr &m = result.measurements.twr[n++];
+        measure(*s, s->peers[i], m, ev.time / 1e6);
+        if (s->ntf == 2 && m.status == 0 && m.distance >= s->near && m.distance <= s->far)
+            report = true;
+    }
+    result.no_of_measurements = n;
+
+    bool sending = !s->tx.empty();
+    Packet packet;
+    bool sent = false;
+    int echo = -1;
+    if (sending) {
+        packet = s->tx.front();
+        s->tx.pop();
+        int peer = findPeer(packet.dst);
+        std::uniform_real_distribution<double> u(0, 1);
+        sent = peer >= 0 && u(rng) >= peerList[peer].lossRate;
+        if (sent && peerList[peer].echo)
+            echo = peer;
+    }
+
+    Event next;
+    next.time = ev.time + (uint64_t)s->intervalMs * 1000;
+    next.kind = ROUND;
+    next.handle = s->handle;
+    next.generation = s->generation;
+    next.status = uwb::SessionStatus::ACTIVE;
+    next.peer = -1;
+    if (echo >= 0) {
+        Event rx = next;
+        rx.kind = DATA_RX;
+        rx.peer = echo;
+        rx.data = packet.data;
+        schedule(rx);
+    }
+    schedule(next);
+
+    if (report && n)
+        deliver(lk, uwb::NotificationType::RANGING_DATA, &result);
+    if (sending) {
+        uwb::DataTransmit transmit;
+        transmit.transmitNtf_sessionHandle = ev.handle;
+        transmit.transmitNtf_sequence_number = packet.seq;
+        transmit.transmitNtf_status = sent ? SIM_TX_OK : SIM_TX_ERROR;
+        transmit.transmitNtf_txcount = 1;
+        if (sent)
+            stats.dataSent++;
+        else
+            stats.dataFailed++;
+        deliver(lk, uwb::NotificationType::DATA_TRANSMIT_NTF, &transmit);
+    }
+}
+
+void SimHal::receive(std::unique_lock<std::mutex> &lk, const Event &ev)
+{
+    Session *s = find(ev.handle);
+    if (!s || s->state != uwb::SessionStatus::ACTIVE || ev.peer < 0 || ev.peer >= (int)peerList.size())
+        return;
+
+    std::vector<uint8_t> data = ev.data;
+    uwb::DataPacket packet;
+    packet.session_handle = ev.handle;
+    memset(packet.mac_address, 0, sizeof(packet.mac_address));
+    packet.mac_address[0] = peerList[ev.peer].mac[0];
+    packet.mac_address[1] = peerList[ev.peer].mac[1];
+    packet.sequence_number = s->rxSeq++;
+    packet.data_size = data.size();
+    packet.data = data.data();
+    stats.dataReceived++;
+    deliver(lk, uwb::NotificationType::DATA_RCV_NTF, &packet);
+}
+
+void SimHal::measure(Session &s, int peerIndex, uwb::twr_mesr &m, double t)
+{
+    (void)s;
+    SimPeer &p = peerList[peerIndex];
+    SimVector pos = p.at(t, rng);
+    double d = pos.norm();
+    std::uniform_real_distribution<double> u(0, 1);
+    std::normal_distribution<double> noise(0, 1);
+
+    memset(&m, 0, sizeof(m));
+    m.peer_addr[0] = p.mac[0];
+    m.peer_addr[1] = p.mac[1];
+
+    // the channel evolves whether or not the round gets through
+    p.nlos = u(rng) < (p.nlos ? p.nlosStay : p.nlosRate);
+    if (u(rng) < p.lossRate || d > p.maxRangeM) {
+        m.status = SIM_RX_TIMEOUT;
+        m.distance = 0xFFFF;
+        stats.lost++;
+        return;
+    }
+
+    double cm = d * 100 + noise(rng) * p.distanceSigmaCm;
+    double angleSigma = p.angleSigmaDeg;
+    if (p.nlos) {
+        std::exponential_distribution<double> excess(1.0 / p.nlosBiasCm);
+        cm += excess(rng);
+        angleSigma *= 3;
+        m.nlos = 1;
+        stats.nlos++;
+    }
+    double azimuth = atan2(pos.y, pos.x) * 180 / M_PI + noise(rng) * angleSigma;
+    double elevation = atan2(pos.z, hypot(pos.x, pos.y)) * 180 / M_PI + noise(rng) * angleSigma;
+    while (azimuth >= 180)
+        azimuth -= 360;
+    while (azimuth < -180)
+        azimuth += 360;
+    elevation = elevation > 90 ? 90 : (elevation < -90 ? -90 : elevation);
+
+    m.status = 0;
+    m.distance = cm < 0 ? 0 : (cm > 0xFFFE ? 0xFFFE : (uint16_t)lround(cm));
+    m.aoa_azimuth = (int16_t)lround(azimuth * 128);      // Q9.7
+    m.aoa_elevation = (int16_t)lround(elevation * 128);
+    m.aoa_azimuth_fom = m.aoa_elevation_fom = p.nlos ? 50 : 100;
+    m.rssi_rx1 = m.rssi_rx2 = (int16_t)lround(-(40 + 20 * log10(d < 0.1 ? 0.1 : d)) * 128);
+    stats.measurements++;
+}
+
+void SimHal::deliver(std::unique_lock<std::mutex> &lk, uwb::NotificationType type, void *data)
+{
+    uwb::SystemNotificationCallback callback = userNotificationCallback;
+    if (!callback)
+        return;
+    stats.notifications++;
+    lk.unlock();
+    uint64_t start = hostMicros();
+    callback(type, data);
+    uint64_t elapsed = hostMicros() - start;
+    lk.lock();
+    stats.callbackUs += elapsed;
+    if (elapsed > stats.maxCallbackUs)
+        stats.maxCallbackUs = elapsed;
+}
+
+int SimHal::findPeer(const uint8_t mac[2]) const
+{
+    for (size_t i = 0; i < peerList.size(); i++)
+        if (peerList[i].mac[0] == mac[0] && peerList[i].mac[1] == mac[1])
+            return i;
+    return -1;
+}
+
+SimHal::Session *SimHal::find(uint32_t handle)
+{
+    std::map<uint32_t, Session>::iterator it = sessions.find(handle);
+    return it == sessions.end() ? nullptr : &it->second;
+}
+
+uint32_t SimHal::macAddress(void)
+{
+    uint32_t mac;
+    do {
+        mac = rng() & 0xFFFF;
+    } while (mac == 0 || mac == 0xFFFF);
+    return mac;
+}
+
+bool SimHal::inject(uint32_t sessionHandle, int peerIndex, const uint8_t *data, uint16_t len)
+{
+    std::lock_guard<std::mutex> g(mtx);
+    Session *s = find(sessionHandle);
+    if (!s || s->state != uwb::SessionStatus::ACTIVE || peerIndex < 0 || peerIndex >= (int)peerList.size())
+        return false;
+    Event ev;
+    ev.time = clock;
+    ev.kind = DATA_RX;
+    ev.handle = sessionHandle;
+    ev.generation = s->generation;
+    ev.status = s->state;
+    ev.peer = peerIndex;
+    ev.data.assign(data, data + len);
+    schedule(ev);
+    return true;
+}
+
+uwb::Status SimHal::initialize(uwb::SystemNotificationCallback callback)
+{
+    std::lock_guard<std::mutex> g(mtx);
+    userNotificationCallback = callback;
+    deviceState = uwb::DeviceState::ACTIVE;
+    return uwb::Status::SUCCESS;
+}
+
+uwb::Status SimHal::deinitialize()
+{
+    std::lock_guard<std::mutex> g(mtx);
+    sessions.clear();
+    events = decltype(events)();
+    deviceState = uwb::DeviceState::NOT_INITIALIZED;
+    return uwb::Status::SUCCESS;
+}
+
+uwb::Status SimHal::reset()
+{
+    std::lock_guard<std::mutex> g(mtx);
+    sessions.clear();
+    events = decltype(events)();
+    return uwb::Status::SUCCESS;
+}
+
+uwb::Status SimHal::shutdown()
+{
+    return deinitialize();
+}
+
+uwb::Status SimHal::getDeviceCapability(uwb::DeviceCapabilities &capabilities)
+{
+    memset(&capabilities, 0, sizeof(capabilities));
+    capabilities.firaPhyLowerRangeMajorVersion = 1;
+    capabilities.firaPhyHigherRangeMajorVersion = 2;
+    capabilities.firaMacLowerRangeMajorVersion = 1;
+    capabilities.firaMacHigherRangeMajorVersion = 2;
+    capabilities.deviceTypes = 0x03;
+    capabilities.channels = 0x09;           // 5 and 9
+    capabilities.aoaSupport = 1;
+    capabilities.extendedMacAddress = 1;
+    capabilities.maxDataPacketPayloadSize = uwb::MAX_APP_DATA_SIZE;
+    return uwb::Status::SUCCESS;
+}
+
+uwb::Status SimHal::getDeviceState(uwb::DeviceState &state)
+{
+    state = deviceState;
+    return uwb::Status::SUCCESS;
+}
+
+uwb::Status SimHal::getUwbConfigData_Android(uwb::DeviceConfig &config)
+{
+    std::lock_guard<std::mutex> g(mtx);
+    memset(&config, 0, sizeof(config));
+    config.spec_version_major[0] = 1;
+    config.spec_version_minor[0] = 0;
+    config.chip_id[0] = 0x00;
+    config.chip_id[1] = 0x04;
+    config.chip_fw_version[0] = 1;
+    config.mw_version[0] = 1;
+    config.supported_profiles = 1;
+    config.ranging_role = 1;
+    uint32_t mac = macAddress();
+    config.device_mac_addr[0] = mac & 0xFF;
+    config.device_mac_addr[1] = mac >> 8;
+    return uwb::Status::SUCCESS;
+}
+
+uwb::Status SimHal::getUwbConfigData_iOS(uwb::DeviceRole device_role, uwb::AccessoryConfigData &config)
+{
+    std::lock_guard<std::mutex> g(mtx);
+    memset(&config, 0, sizeof(config));
+    config.length = sizeof(config) - 1;
+    config.spec_version_major[0] = 1;
+    config.spec_version_minor[0] = 0;
+    config.manufacturer_id[0] = 'T';
+    config.manufacturer_id[1] = 'S';
+    config.model_id[0] = 0x01;
+    config.mw_version[0] = 1;
+    config.ranging_role = device_role;
+    uint32_t mac = macAddress();
+    config.device_mac_addr[0] = mac & 0xFF;
+    config.device_mac_addr[1] = mac >> 8;
+    return uwb::Status::SUCCESS;
+}
+
+uwb::Status SimHal::nearbySession(uint32_t &handle)
+{
+    if (sessions.size() >= sessionLimit)
+        return uwb::Status::MAX_SESSIONS_EXCEEDED;
+    handle = nextHandle++;
+    Session &s = sessions[handle];
+    s = Session(handle, uwb::SessionType::RANGING);
+    s.nearby = true;
+    s.intervalMs = nearbyMs;
+
+    // the first phone no other Nearby session ranges with
+    for (size_t i = 0; i < peerList.size() && s.peers.empty(); i++) {
+        if (!peerList[i].phone)
+            continue;
+        bool used = false;
+        for (std::map<uint32_t, Session>::iterator it = sessions.begin(); it != sessions.end(); ++it)
+            if (it->first != handle && it->second.nearby && !it->second.peers.empty() && it->second.peers[0] == (int)i)
+                used = true;
+        if (!used)
+            s.peers.push_back(i);
+    }
+
+    notifyStatus(handle, uwb::SessionStatus::INIT);
+    notifyStatus(handle, uwb::SessionStatus::IDLE);
+    s.state = uwb::SessionStatus::ACTIVE;
+    s.generation++;
+    notifyStatus(handle, uwb::SessionStatus::ACTIVE);
+
+    Event ev;
+    ev.time = clock + (uint64_t)s.intervalMs * 1000;
+    ev.kind = ROUND;
+    ev.handle = handle;
+    ev.generation = s.generation;
+    ev.status = s.state;
+    ev.peer = -1;
+    schedule(ev);
+    return uwb::Status::SUCCESS;
+}
+
+uwb::Status SimHal::configureDevice_Android(uwb::AndroidDeviceConfig &config)
+{
+    std::lock_guard<std::mutex> g(mtx);
+    if (!config.config_data || !config.config_data_length)
+        return uwb::Status::INVALID_PARAM;
+    uint32_t handle;
+    uwb::Status status = nearbySession(handle);
+    if (status == uwb::Status::SUCCESS)
+        config.profile_info.session_handle = handle;
+    return status;
+}
+
+uwb::Status SimHal::configureDevice_iOS(uwb::ProfileConfig &config)
+{
+    std::lock_guard<std::mutex> g(mtx);
+    if (config.sharable_data.empty())
+        return uwb::Status::INVALID_PARAM;
+    uint32_t handle;
+    uwb::Status status = nearbySession(handle);
+    if (status == uwb::Status::SUCCESS)
+        config.profile_info.session_handle = handle;
+    return status;
+}
+
+uwb::Status SimHal::sessionInit(uint32_t session_id, uwb::SessionType type)
+{
+    std::lock_guard<std::mutex> g(mtx);
+    if (find(session_id))
+        return uwb::Status::REJECTED;
+    if (sessions.size() >= sessionLimit)
+        return uwb::Status::MAX_SESSIONS_EXCEEDED;
+    sessions[session_id] = Session(session_id, type);
+    notifyStatus(session_id, uwb::SessionStatus::INIT);
+    return uwb::Status::SUCCESS;
+}
+
+uwb::Status SimHal::sessionDeinit(uint32_t session_handle)
+{
+    std::lock_guard<std::mutex> g(mtx);
+    if (!sessions.erase(session_handle))
+        return uwb::Status::SESSION_NOT_EXIST;
+    notifyStatus(session_handle, uwb::SessionStatus::DEINIT);
+    return uwb::Status::SUCCESS;
+}
+
+uwb::Status SimHal::getSessionState(uint32_t session_handle, uint8_t &state)
+{
+    std::lock_guard<std::mutex> g(mtx);
+    Session *s = find(session_handle);
+    if (!s) {
+        state = (uint8_t)uwb::SessionStatus::UNKNOWN;
+        return uwb::Status::SESSION_NOT_EXIST;
+    }
+    state = (uint8_t)s->state;
+    return uwb::Status::SUCCESS;
+}
+
+void SimHal::configured(Session &s)
+{
+    if (s.state != uwb::SessionStatus::INIT)
+        return;
+    s.state = uwb::SessionStatus::IDLE;
+    notifyStatus(s.handle, uwb::SessionStatus::IDLE);
+}
+
+uwb::Status SimHal::setRangingParams(uint32_t session_handle, UWBRangingParams &params)
+{
+    std::lock_guard<std::mutex> g(mtx);
+    Session *s = find(session_handle);
+    if (!s)
+        return uwb::Status::SESSION_NOT_EXIST;
+    if (s->state == uwb::SessionStatus::ACTIVE)
+        return uwb::Status::SESSION_ACTIVE;
+
+    // the peers are the destinations: short addresses, or the first two bytes of the extended ones
+    const uint8_t *dst = params.destinationMacAddr();
+    size_t stride = params.macAddrMode() == 0 ? 2 : MAC_EXT_ADD_LEN;
+    size_t count = params.noOfControlees() ? params.noOfControlees() : 1;
+    if (count > uwb::MAX_RESPONDERS)
+        count = uwb::MAX_RESPONDERS;
+    s->peers.clear();
+    for (size_t k = 0; k < count; k++) {
+        int peer = findPeer(dst + k * stride);
+        if (peer >= 0)
+            s->peers.push_back(peer);
+    }
+    configured(*s);
+    return uwb::Status::SUCCESS;
+}
+
+uwb::Status SimHal::setAppConfig(uint32_t session_handle, uwb::AppConfigId param_id, uint32_t value)
+{
+    std::lock_guard<std::mutex> g(mtx);
+    Session *s = find(session_handle);
+    if (!s)
+        return uwb::Status::SESSION_NOT_EXIST;
+    if (param_id == uwb::AppConfigId::RangingDuration && value)
+        s->intervalMs = value;
+    configured(*s);
+    return uwb::Status::SUCCESS;
+}
+
+uwb::Status SimHal::setAppConfigMultiple(uint32_t session_handle, UWBAppParamList configs)
+{
+    std::lock_guard<std::mutex> g(mtx);
+    Session *s = find(session_handle);
+    if (!s)
+        return uwb::Status::SESSION_NOT_EXIST;
+    uwb::AppConfig *duration = configs.findParam(uwb::AppConfigId::RangingDuration);
+    if (duration && duration->param_value.vu32)
+        s->intervalMs = duration->param_value.vu32;
+    configured(*s);
+    return uwb::Status::SUCCESS;
+}
+
+uwb::Status SimHal::startRanging(uint32_t session_handle)
+{
+    std::lock_guard<std::mutex> g(mtx);
+    Session *s = find(session_handle);
+    if (!s)
+        return uwb::Status::SESSION_NOT_EXIST;
+    if (s->state == uwb::SessionStatus::INIT)
+        return uwb::Status::SESSION_NOT_CONFIGURED;
+    if (s->state == uwb::SessionStatus::ACTIVE)
+        return uwb::Status::SESSION_ACTIVE;
+    s->state = uwb::SessionStatus::ACTIVE;
+    s->generation++;
+    notifyStatus(session_handle, uwb::SessionStatus::ACTIVE);
+
+    Event ev;
+    ev.time = clock + (uint64_t)s->intervalMs * 1000;
+    ev.kind = ROUND;
+    ev.handle = session_handle;
+    ev.generation = s->generation;
+    ev.status = s->state;
+    ev.peer = -1;
+    schedule(ev);
+    return uwb::Status::SUCCESS;
+}
+
+uwb::Status SimHal::stopRanging(uint32_t session_handle)
+{
+    std::lock_guard<std::mutex> g(mtx);
+    Session *s = find(session_handle);
+    if (!s)
+        return uwb::Status::SESSION_NOT_EXIST;
+    if (s->state != uwb::SessionStatus::ACTIVE)
+        return uwb::Status::REJECTED;
+    s->state = uwb::SessionStatus::IDLE;
+    s->generation++;
+    s->tx = std::queue<Packet>();
+    notifyStatus(session_handle, uwb::SessionStatus::IDLE);
+    return uwb::Status::SUCCESS;
+}
+
+uwb::Status SimHal::enableRangingNotifications(uint32_t session_handle, uint8_t enableRangingDataNtf, uint16_t proximityNear, uint16_t proximityFar)
+{
+    std::lock_guard<std::mutex> g(mtx);
+    Session *s = find(session_handle);
+    if (!s)
+        return uwb::Status::SESSION_NOT_EXIST;
+    if (enableRangingDataNtf > 2)
+        return uwb::Status::INVALID_PARAM;
+    s->ntf = enableRangingDataNtf;
+    s->near = proximityNear;
+    s->far = proximityFar;
+    return uwb::Status::SUCCESS;
+}
+
+uwb::Status SimHal::sendData(uwb::DataPacket &packet)
+{
+    std::lock_guard<std::mutex> g(mtx);
+    Session *s = find(packet.session_handle);
+    if (!s)
+        return uwb::Status::SESSION_NOT_EXIST;
+    if (s->state != uwb::SessionStatus::ACTIVE)
+        return uwb::Status::REJECTED;
+    if (!packet.data || packet.data_size > uwb::MAX_APP_DATA_SIZE)
+        return uwb::Status::INVALID_PARAM;
+    if (s->tx.size() >= SIM_TX_QUEUE)
+        return uwb::Status::BUFFER_OVERFLOW;
+    Packet p;
+    p.data.assign(packet.data, packet.data + packet.data_size);
+    p.seq = packet.sequence_number;
+    p.dst[0] = packet.mac_address[0];
+    p.dst[1] = packet.mac_address[1];
+    s->tx.push(p);
+    return uwb::Status::SUCCESS;
+}
+
+uwb::Status SimHal::setStaticSts(uint32_t session_handle, uint16_t vendor_id, const std::vector<uint8_t> &sts_iv)
+{
+    (void)vendor_id;
+    (void)sts_iv;
+    std::lock_guard<std::mutex> g(mtx);
+    return find(session_handle) ? uwb::Status::SUCCESS : uwb::Status::SESSION_NOT_EXIST;
+}
+
+uint16_t SimHal::serializeDeviceConfigData(uint8_t *out_buffer, const uwb::DeviceConfig &config)
+{
+    uint16_t n = 0;
+    memcpy(out_buffer + n, config.spec_version_major, 2);
+    n += 2;
+    memcpy(out_buffer + n, config.spec_version_minor, 2);
+    n += 2;
+    memcpy(out_buffer + n, config.chip_id, 2);
+    n += 2;
+    memcpy(out_buffer + n, config.chip_fw_version, 2);
+    n += 2;
+    memcpy(out_buffer + n, config.mw_version, 3);
+    n += 3;
+    for (int i = 0; i < 4; i++)
+        out_buffer[n++] = (config.supported_profiles >> (8 * i)) & 0xFF;
+    out_buffer[n++] = config.ranging_role;
+    memcpy(out_buffer + n, config.device_mac_addr, 2);
+    n += 2;
+    return n;
+}
+
+void SimHal::setPrintCallback(uwb::PrintCallback logCB)
+{
+    mPrintCallback = logCB;
+}
+
+void SimHal::setLogLevel(uwb::LogLevel level)
+{
+    logLevel = level;
+}
+
+void SimHal::log(uwb::LogLevel level, char tag, const char *format, va_list args)
+{
+    if (level > logLevel)
+        return;
+    char line[512];
+    uint64_t t = clock;
+    int n = snprintf(line, sizeof(line), "%6lu.%03lu %c: ", (unsigned long)(t / 1000000),
+                     (unsigned long)(t / 1000 % 1000), tag);
+    n += vsnprintf(line + n, sizeof(line) - n, format, args);
+    if (n > (int)sizeof(line) - 3)
+        n = sizeof(line) - 3;
+    strcpy(line + n, "\r\n");
+    if (mPrintCallback)
+        mPrintCallback(line);
+    else
+        fputs(line, stdout);
+}
+
+void SimHal::logf(uwb::LogLevel level, char tag, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    log(level, tag, format, args);
+    va_end(args);
+}
+
+void SimHal::logArray(uwb::LogLevel level, char tag, const char *message, const unsigned char *array, size_t len)
+{
+    if (level > logLevel)
+        return;
+    std::string hex;
+    char byte[4];
+    for (size_t i = 0; i < len; i++) {
+        snprintf(byte, sizeof(byte), "%02X ", array[i]);
+        hex += byte;
+    }
+    logf(level, tag, "%s: %s", message, hex.c_str());
+}
+
+#define SIM_LOG(name, level, tag)                       \
+    void SimHal::name(const char *format, ...)          \
+    {                                                   \
+        va_list args;                                   \
+        va_start(args, format);                         \
+        log(uwb::LogLevel::level, tag, format, args);   \
+        va_end(args);                                   \
+    }
+
+SIM_LOG(Log_D, UWB_DEBUG_LEVEL, 'D')
+SIM_LOG(Log_I, UWB_INFO_LEVEL, 'I')
+SIM_LOG(Log_W, UWB_WARN_LEVEL, 'W')
+SIM_LOG(Log_E, UWB_ERROR_LEVEL, 'E')
+
+void SimHal::Log_Array_D(const char *message, const unsigned char *array, size_t array_len)
+{
+    logArray(uwb::LogLevel::UWB_DEBUG_LEVEL, 'D', message, array, array_len);
+}
+
+void SimHal::Log_Array_I(const char *message, const unsigned char *array, size_t array_len)
+{
+    logArray(uwb::LogLevel::UWB_INFO_LEVEL, 'I', message, array, array_len);
+}
+
+void SimHal::Log_Array_W(const char *message, const unsigned char *array, size_t array_len)
+{
+    logArray(uwb::LogLevel::UWB_WARN_LEVEL, 'W', message, array, array_len);
+}
+
+void SimHal::Log_Array_E(const char *message, const unsigned char *array, size_t array_len)
+{
+    logArray(uwb::LogLevel::UWB_ERROR_LEVEL, 'E', message, array, array_len);
+}
@@ -0,0 +1,244 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#ifndef SIMHAL_HPP
+#define SIMHAL_HPP
+
+#include <stdint.h>
+#include <stdarg.h>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <thread>
+#include <vector>
+#include "hal/uwb_hal.hpp"
+#include "SimPeer.hpp"
+
+/**
+ * @brief host (Linux) implementation of uwb::UwbHal: a simulated UWB chip
+ *
+ * Sessions follow the chip's state machine (INIT, IDLE once configured,
+ * ACTIVE while ranging) and notify each change. An active session ranges
+ * once per ranging duration with the peers it is configured with (the
+ * destination addresses, or the peers flagged phone for the Nearby
+ * sessions), each measurement drawn from the peer's motion model with
+ * noise, NLOS bias and losses. In-band data goes one packet per round,
+ * confirmed by a DATA_TRANSMIT_NTF; echo peers send it back.
+ *
+ * Time is simulated: millis()/micros() read the simulation clock and only
+ * advance() (or delay()) moves it. The notifications are delivered through
+ * the callback given to initialize(), the library's SystemCallback, from a
+ * simulation thread, in time order, while advance() waits: a run is
+ * deterministic for a given seed, and runs as fast as the host executes
+ * the callbacks.
+ *
+ *     SimHal &sim = SimHal::instance();
+ *     SimPeer tag(0x2222);
+ *     tag.motion = SimPeer::CIRCLE;
+ *     tag.radius = 3;
+ *     sim.addPeer(tag);
+ *     UWB.begin();
+ *     ... configure and start sessions as on the device ...
+ *     for (int i = 0; i < 60000; i++) {
+ *         loop();
+ *         delay(1);           // one simulated millisecond
+ *     }
+ *     sim.printReport();
+ */
+class SimHal : public uwb::UwbHal {
+public:
+    /**
+     * @brief statistics since the last resetReport()
+     *
+     */
+    struct Report {
+        uint64_t notifications;
+        uint64_t rounds;
+        uint64_t measurements;
+        uint64_t lost;              // RX timeouts and out of range
+        uint64_t nlos;
+        uint64_t dataSent;
+        uint64_t dataFailed;
+        uint64_t dataReceived;
+        uint64_t simUs;             // simulated time advanced
+        uint64_t wallUs;            // host time spent in advance()
+        uint64_t callbackUs;        // host time spent in the notification callback
+        uint64_t maxCallbackUs;
+    };
+
+    static SimHal &instance();
+
+    /**
+     * @brief seed of the noise and of the events drawn at random
+     */
+    void seed(uint32_t s);
+
+    /**
+     * @brief add a remote device
+     *
+     * @return its index
+     */
+    int addPeer(const SimPeer &peer);
+    SimPeer &peer(int i) { return peerList[i]; }
+    int peers(void) const { return peerList.size(); }
+
+    /**
+     * @brief ranging duration of the Nearby sessions, in ms
+     */
+    void nearbyInterval(uint32_t ms) { nearbyMs = ms; }
+    /**
+     * @brief sessions the chip holds at once
+     */
+    void maxSessions(uint8_t n) { sessionLimit = n; }
+
+    /**
+     * @brief simulated time, in microseconds
+     */
+    uint64_t now(void) const { return clock; }
+
+    /**
+     * @brief run the simulation for us microseconds, the notifications due
+     * are delivered before it returns
+     *
+     * Called from a notification callback it does nothing: the simulation
+     * is at that callback's time.
+     */
+    void advance(uint64_t us);
+
+    /**
+     * @brief deliver data from a peer, as a DATA_RCV_NTF of the session
+     *
+     * @return false if the session is not ranging
+     */
+    bool inject(uint32_t sessionHandle, int peerIndex, const uint8_t *data, uint16_t len);
+
+    const Report &report(void) const { return stats; }
+    void resetReport(void);
+    void printReport(void) const;
+
+    // uwb::UwbHal
+    uwb::Status initialize(uwb::SystemNotificationCallback callback) override;
+    uwb::Status deinitialize() override;
+    uwb::Status reset() override;
+    uwb::Status shutdown() override;
+    void initSemaphores() override {}
+    void deInitSemaphores() override {}
+    uwb::Status getDeviceCapability(uwb::DeviceCapabilities &capabilities) override;
+    uwb::Status getDeviceState(uwb::DeviceState &state) override;
+    uwb::Status getUwbConfigData_Android(uwb::DeviceConfig &config) override;
+    uwb::Status getUwbConfigData_iOS(uwb::DeviceRole device_role, uwb::AccessoryConfigData &config) override;
+    uwb::Status configureDevice_Android(uwb::AndroidDeviceConfig &config) override;
+    uwb::Status configureDevice_iOS(uwb::ProfileConfig &config) override;
+    uwb::Status sessionInit(uint32_t session_id, uwb::SessionType type) override;
+    uwb::Status sessionDeinit(uint32_t session_handle) override;
+    uwb::Status getSessionState(uint32_t session_handle, uint8_t &state) override;
+    uwb::Status setRangingParams(uint32_t session_handle, UWBRangingParams &params) override;
+    uwb::Status setAppConfig(uint32_t session_handle, uwb::AppConfigId param_id, uint32_t value) override;
+    uwb::Status setAppConfigMultiple(uint32_t session_handle, UWBAppParamList configs) override;
+    uwb::Status startRanging(uint32_t session_handle) override;
+    uwb::Status stopRanging(uint32_t session_handle) override;
+    uwb::Status enableRangingNotifications(uint32_t session_handle, uint8_t enableRangingDataNtf, uint16_t proximityNear, uint16_t proximityFar) override;
+    uwb::Status sendData(uwb::DataPacket &packet) override;
+    uwb::Status setStaticSts(uint32_t session_handle, uint16_t vendor_id, const std::vector<uint8_t> &sts_iv) override;
+    void setPrintCallback(uwb::PrintCallback logCB) override;
+    void setLogLevel(uwb::LogLevel logLevel) override;
+    void Log_D(const char *format, ...) override;
+    void Log_E(const char *format, ...) override;
+    void Log_I(const char *format, ...) override;
+    void Log_W(const char *format, ...) override;
+    void Log_Array_D(const char *message, const unsigned char *array, size_t array_len) override;
+    void Log_Array_E(const char *message, const unsigned char *array, size_t array_len) override;
+    void Log_Array_I(const char *message, const unsigned char *array, size_t array_len) override;
+    void Log_Array_W(const char *message, const unsigned char *array, size_t array_len) override;
+    uint16_t serializeDeviceConfigData(uint8_t *out_buffer, const uwb::DeviceConfig &config) override;
+    uwb::Status setDefaultCoreConfigs(void) override { return uwb::Status::SUCCESS; }
+
+private:
+    SimHal();
+    ~SimHal();
+    SimHal(SimHal const &) = delete;
+    void operator=(SimHal const &) = delete;
+
+    struct Packet {
+        std::vector<uint8_t> data;
+        uint16_t seq;
+        uint8_t dst[2];
+    };
+
+    struct Session {
+        uint32_t handle;
+        uwb::SessionType type;
+        uwb::SessionStatus state;
+        uint32_t intervalMs;
+        uint32_t generation;        // rounds of an older start are dropped
+        uint32_t seq;
+        uint16_t rxSeq;
+        uint8_t ntf;                // enableRangingNotifications() mode
+        uint16_t near, far;         // cm, ntf mode 2
+        bool nearby;
+        std::vector<int> peers;
+        std::queue<Packet> tx;
+
+        Session(uint32_t h = 0, uwb::SessionType t = uwb::SessionType::RANGING)
+            : handle(h), type(t), state(uwb::SessionStatus::INIT), intervalMs(200), generation(0), seq(0), rxSeq(0),
+              ntf(1), near(0), far(0xFFFF), nearby(false) {}
+    };
+
+    enum EventKind : uint8_t { STATUS, ROUND, DATA_RX };
+
+    struct Event {
+        uint64_t time;
+        uint64_t order;             // ties in the order they were queued
+        EventKind kind;
+        uint32_t handle;
+        uint32_t generation;
+        uwb::SessionStatus status;
+        int peer;
+        std::vector<uint8_t> data;
+
+        Event() : time(0), order(0), kind(STATUS), handle(0), generation(0), status(uwb::SessionStatus::UNKNOWN), peer(-1) {}
+        bool operator>(const Event &o) const { return time != o.time ? time > o.time : order > o.order; }
+    };
+
+    void run(void);
+    void schedule(Event ev);
+    void notifyStatus(uint32_t handle, uwb::SessionStatus status);
+    void configured(Session &s);
+    uwb::Status nearbySession(uint32_t &handle);
+    void process(std::unique_lock<std::mutex> &lk, const Event &ev);
+    void round(std::unique_lock<std::mutex> &lk, const Event &ev);
+    void receive(std::unique_lock<std::mutex> &lk, const Event &ev);
+    void measure(Session &s, int peerIndex, uwb::twr_mesr &m, double t);
+    void deliver(std::unique_lock<std::mutex> &lk, uwb::NotificationType type, void *data);
+    int findPeer(const uint8_t mac[2]) const;
+    void log(uwb::LogLevel level, char tag, const char *format, va_list args);
+    void logf(uwb::LogLevel level, char tag, const char *format, ...);
+    void logArray(uwb::LogLevel level, char tag, const char *message, const unsigned char *array, size_t len);
+    Session *find(uint32_t handle);
+    uint32_t macAddress(void);
+
+    std::vector<SimPeer> peerList;
+    std::map<uint32_t, Session> sessions;
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+    std::mt19937 rng;
+    uint64_t nextOrder;
+    uint32_t nextHandle;
+    uint32_t nearbyMs;
+    uint8_t sessionLimit;
+    uwb::DeviceState deviceState;
+    uwb::LogLevel logLevel;
+
+    std::thread thread;
+    std::mutex mtx;
+    std::condition_variable wake;
+    std::condition_variable done;
+    volatile uint64_t clock;
+    uint64_t target;
+    bool busy;
+    bool quit;
+    Report stats;
+};
+
+#endif /* SIMHAL_HPP */
@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#ifndef SIMPEER_HPP
+#define SIMPEER_HPP
+
+#include <stdint.h>
+#include <math.h>
+#include <random>
+
+/**
+ * @brief a point or a velocity, in meters (per second)
+ *
+ * The simulated device sits at the origin, its antenna boresight along +x,
+ * +y to its left and +z up.
+ */
+struct SimVector {
+    double x, y, z;
+
+    SimVector(double x = 0, double y = 0, double z = 0) : x(x), y(y), z(z) {}
+    SimVector operator+(const SimVector &o) const { return SimVector(x + o.x, y + o.y, z + o.z); }
+    SimVector operator*(double k) const { return SimVector(x * k, y * k, z * k); }
+    double norm() const { return sqrt(x * x + y * y + z * z); }
+};
+
+/**
+ * @brief a remote UWB device: where it is, and how its measurements degrade
+ *
+ */
+struct SimPeer {
+    enum Motion : uint8_t {
+        STATIC,         // stays at position
+        LINEAR,         // position + velocity * t
+        CIRCLE,         // around position at radius, angularSpeed rad/s, in the horizontal plane
+        RANDOM_WALK     // velocity drifts by walkSigma m/s per sqrt(s), capped at maxSpeed
+    };
+
+    uint8_t mac[2];             // short address, as in the measurements
+    bool phone;                 // ranges with the Nearby sessions (configureDevice_iOS/_Android)
+    bool echo;                  // sends back the data it receives
+
+    Motion motion;
+    SimVector position;
+    SimVector velocity;
+    double radius;
+    double angularSpeed;
+    double walkSigma;
+    double maxSpeed;
+
+    double distanceSigmaCm;     // Gaussian noise
+    double angleSigmaDeg;
+    double lossRate;            // measurement missing (RX timeout), 0..1
+    double nlosRate;            // line of sight lost, per round
+    double nlosStay;            // probability to stay NLOS in the next round
+    double nlosBiasCm;          // mean of the exponential excess path when NLOS
+    double maxRangeM;           // no measurement beyond
+
+    SimPeer(uint16_t address = 0)
+        : phone(false), echo(false), motion(STATIC), radius(0), angularSpeed(0), walkSigma(0.3), maxSpeed(1.5),
+          distanceSigmaCm(5), angleSigmaDeg(3), lossRate(0), nlosRate(0), nlosStay(0.8), nlosBiasCm(60),
+          maxRangeM(60), nlos(false), walking(false), walkTime(0), walkPos(), walkVel() {
+        mac[0] = address & 0xFF;
+        mac[1] = address >> 8;
+        position = SimVector(2, 0, 0);
+    }
+
+    uint16_t address() const { return mac[0] | (mac[1] << 8); }
+
+    /**
+     * @brief true position at time t (s), without moving the peer
+     *
+     * RANDOM_WALK gives where the last at() left it, no randomness is drawn.
+     */
+    SimVector positionAt(double t) const {
+        switch (motion) {
+        case LINEAR:
+            return position + velocity * t;
+        case CIRCLE: {
+            double a = angularSpeed * t;
+            return position + SimVector(radius * cos(a), radius * sin(a), 0);
+        }
+        case RANDOM_WALK:
+            return walking ? walkPos : position;
+        default:
+            return position;
+        }
+    }
+
+    /**
+     * @brief true position at time t (s)
+     *
+     * RANDOM_WALK integrates from the last call, so the times are to be
+     * increasing, as the simulation queries them.
+     */
+    SimVector at(double t, std::mt19937 &rng) {
+        if (motion != RANDOM_WALK)
+            return positionAt(t);
+
+        if (!walking) {
+            walking = true;
+            walkTime = t;
+            walkPos = position;
+            walkVel = velocity;
+        }
+        double dt = t - walkTime;
+        if (dt > 0) {
+            std::normal_distribution<double> n(0, walkSigma * sqrt(dt));
+            walkVel = walkVel + SimVector(n(rng), n(rng), 0);
+            double speed = walkVel.norm();
+            if (speed > maxSpeed)
+                walkVel = walkVel * (maxSpeed / speed);
+            walkPos = walkPos + walkVel * dt;
+            walkTime = t;
+        }
+        return walkPos;
+    }
+
+    /* simulation state */
+    bool nlos;
+    bool walking;
+    double walkTime;
+    SimVector walkPos;
+    SimVector walkVel;
+};
+
+#endif /* SIMPEER_HPP */
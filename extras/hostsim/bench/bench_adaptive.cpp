@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+// Replays a recorded ranging trace (walk_trace.csv by default) through
+// UWBAdaptiveRanging::replay() and through the same controller pinned to
+// fixed intervals. Prints, for each, the ranging rounds, the mean interval
+// and the radio energy relative to the 200 ms presets, taking the ranging
+// rounds as the cost. No chip and no simulated clock are involved.
+//
+// With the default tuning, the adaptive controller must save at least
+// BENCH_MIN_SAVING of the rounds of the 200 ms preset on the whole trace,
+// and BENCH_MIN_STATIC_SAVING on peer 0 alone, the static tag of
+// walk_trace.csv. Exits with 1 if it does not. The walks of walk_trace.csv
+// are ranged every 100 ms, which caps the saving on the whole trace near 30%.
+
+#include <stdio.h>
+#include <vector>
+
+#include "StellaUWB.h"
+
+#define BENCH_TRACE "extras/hostsim/bench/walk_trace.csv"
+#define BENCH_BASELINE 200
+#define BENCH_MIN_SAVING 0.2f
+#define BENCH_MIN_STATIC_SAVING 0.5f
+
+static bool loadTrace(const char *path, std::vector<UWBAdaptiveRanging::Sample> &trace)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return false;
+
+    char line[80];
+    unsigned long ts;
+    unsigned int peer, distance;
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#')
+            continue;
+        if (sscanf(line, "%lu,%u,%u", &ts, &peer, &distance) != 3)
+            continue;
+        UWBAdaptiveRanging::Sample s;
+        s.timestamp = ts;
+        s.peer = peer;
+        s.distance = distance;
+        trace.push_back(s);
+    }
+    fclose(f);
+    return !trace.empty();
+}
+
+static void printRow(const char *name, const UWBAdaptiveRanging::Report &rep, uint32_t baselineRounds)
+{
+    char row[120];
+    snprintf(row, sizeof(row), "  %-10s rounds %5lu, mean interval %4lu ms, %2u changes, energy %3d%%",
+             name, (unsigned long)rep.rounds,
+             rep.rounds > 1 ? (unsigned long)(rep.elapsedMs / (rep.rounds - 1)) : 0UL,
+             rep.changes, baselineRounds ? (int)(rep.rounds * 100 / baselineRounds) : 0);
+    Serial.println(row);
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = argc > 1 ? argv[1] : BENCH_TRACE;
+    std::vector<UWBAdaptiveRanging::Sample> trace;
+    if (!loadTrace(path, trace)) {
+        Serial.print("cannot read ");
+        Serial.println(path);
+        return 1;
+    }
+
+    uint8_t controllerAddr[] = {0x22, 0x22};
+    uint8_t tagAddr[] = {0x11, 0x11};
+    UWBTracker tracker(0x11223344, UWBMacAddress(UWBMacAddress::Size::SHORT, controllerAddr),
+                       UWBMacAddress(UWBMacAddress::Size::SHORT, tagAddr));
+    tracker.appParams.rangingDuration(BENCH_BASELINE);
+
+    Serial.print("Trace ");
+    Serial.print(path);
+    Serial.print(": ");
+    Serial.print((unsigned long)trace.size());
+    Serial.print(" samples over ");
+    Serial.print((trace.back().timestamp - trace.front().timestamp) / 1000.0, 1);
+    Serial.println(" s");
+
+    // the controller with minInterval == maxInterval never changes the interval
+    static const uint16_t fixed[] = {100, BENCH_BASELINE, 500, 1000};
+    UWBAdaptiveRanging::Report reps[sizeof(fixed) / sizeof(fixed[0])];
+    uint32_t baselineRounds = 0;
+    for (size_t i = 0; i < sizeof(fixed) / sizeof(fixed[0]); i++) {
+        UWBAdaptiveRanging::Config cfg;
+        cfg.minInterval = fixed[i];
+        cfg.maxInterval = fixed[i];
+        UWBAdaptiveRanging pinned(tracker, cfg);
+        reps[i] = pinned.replay(trace.data(), trace.size());
+        if (fixed[i] == BENCH_BASELINE)
+            baselineRounds = reps[i].rounds;
+    }
+
+    UWBAdaptiveRanging adaptive(tracker);
+    UWBAdaptiveRanging::Report rep = adaptive.replay(trace.data(), trace.size());
+
+    for (size_t i = 0; i < sizeof(fixed) / sizeof(fixed[0]); i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "%u ms", fixed[i]);
+        printRow(name, reps[i], baselineRounds);
+    }
+    printRow("adaptive", rep, baselineRounds);
+
+    std::vector<UWBAdaptiveRanging::Sample> still;
+    for (size_t i = 0; i < trace.size(); i++) {
+        if (trace[i].peer == 0)
+            still.push_back(trace[i]);
+    }
+    UWBAdaptiveRanging::Report stillRep = adaptive.replay(still.data(), still.size());
+    Serial.println("Peer 0 alone:");
+    printRow("adaptive", stillRep, baselineRounds);
+    if (rep.airtimeSavings < BENCH_MIN_SAVING || stillRep.airtimeSavings < BENCH_MIN_STATIC_SAVING) {
+        Serial.println("FAILED: the adaptive ranging does not save enough air time");
+        return 1;
+    }
+    return 0;
+}
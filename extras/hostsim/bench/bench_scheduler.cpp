@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+// One simulated minute of six UWBTracker sessions time-sliced by a
+// ROUND_ROBIN UWBSessionScheduler on five hardware sessions. Prints the
+// scheduler report and checks that the rotation is fair: the lowest duty
+// cycle must be close to the highest. Exits with 1 if it is not.
+
+#include "StellaUWB.h"
+#include "UWBSessionScheduler.hpp"
+#include "SimHal.hpp"
+
+#define BENCH_SECONDS 60
+#define BENCH_TRACKERS 6
+#define BENCH_SLOTS 5
+#define BENCH_MIN_FAIRNESS 0.9f     // lowest duty cycle / highest duty cycle
+
+static SimHal &sim = SimHal::instance();
+static UWBSessionScheduler *scheduler;
+
+static void rangingHandler(UWBRangingData &data)
+{
+    scheduler->rangingNotified(data.sessionHandle());
+}
+
+static void sessionInfoHandler(uwb::SessionInfo &info)
+{
+    (void)info;
+}
+
+int main()
+{
+    sim.seed(42);
+    for (int i = 0; i < BENCH_TRACKERS; i++) {
+        SimPeer tag(0x1001 + i);
+        tag.position = SimVector(1 + i, 0, 0.5);
+        sim.addPeer(tag);
+    }
+
+    UWB.registerRangingCallback(rangingHandler);
+    UWB.registerSessionInfoCallback(sessionInfoHandler);
+    UWB.begin(Serial, uwb::LogLevel::UWB_WARN_LEVEL);
+    UWBHAL.setLogLevel(uwb::LogLevel::UWB_INFO_LEVEL);
+
+    uint8_t controllerAddr[] = {0x22, 0x22};
+    UWBSessionScheduler sched(BENCH_SLOTS, 1000, UWBSessionScheduler::ROUND_ROBIN);
+    scheduler = &sched;
+
+    for (int i = 0; i < BENCH_TRACKERS; i++) {
+        uint8_t mac[] = {sim.peer(i).mac[0], sim.peer(i).mac[1]};
+        UWBTracker tracker(0x100 + i, UWBMacAddress(UWBMacAddress::Size::SHORT, controllerAddr),
+                           UWBMacAddress(UWBMacAddress::Size::SHORT, mac));
+        sched.addSession(tracker);
+    }
+
+    sched.begin();
+    for (uint32_t ms = 0; ms < BENCH_SECONDS * 1000UL; ms++) {
+        sched.poll();
+        delay(1);
+    }
+    sched.printReport();
+
+    float lowest = 1, highest = 0;
+    UWBSessionScheduler::Stats st;
+    for (int i = 0; i < sched.size(); i++) {
+        sched.stats(i, st);
+        if (st.dutyCycle < lowest)
+            lowest = st.dutyCycle;
+        if (st.dutyCycle > highest)
+            highest = st.dutyCycle;
+    }
+    sched.end();
+
+    float fairness = highest > 0 ? lowest / highest : 0;
+    Serial.print("fairness (lowest / highest duty cycle): ");
+    Serial.println(fairness);
+    if (fairness < BENCH_MIN_FAIRNESS) {
+        Serial.println("FAILED: some sessions do not rotate");
+        return 1;
+    }
+    return 0;
+}
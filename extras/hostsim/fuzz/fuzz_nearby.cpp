@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+// libFuzzer target for what a phone can write to the Nearby RX
+// characteristic. Every input goes through the NearbyMessage decoders,
+// then is cut into messages that one simulated phone writes in turn,
+// through handleTLV() and the command table, with the session manager
+// polled after each one. The phone goes away at the end of every input,
+// so the next one starts from no session.
+//
+// Input: [length][message]... A length of 0 makes the phone disconnect
+// and connect again, to reach the resume paths.
+
+#include <stdlib.h>
+#include <vector>
+
+#include "StellaUWB.h"
+#include "SimHal.hpp"
+
+#define FUZZ_POLLS_AFTER_DISCONNECT 100
+
+static SimHal &sim = SimHal::instance();
+static BLEDevice phone("0a:0b:0c:0d:0e:0f");
+
+// a decoded view must lie within the message it was taken from
+static void checkWithin(NearbySpan msg, NearbySpan view)
+{
+    if (view.empty())
+        return;
+    if (view.data < msg.data || view.len > msg.len || view.data + view.len > msg.data + msg.len)
+        abort();
+}
+
+static void decode(const uint8_t *data, size_t size)
+{
+    NearbySpan msg(data, size);
+    NearbySpan view;
+    if (NearbyMessage::shareableIOS(msg, view))
+        checkWithin(msg, view);
+    view = NearbySpan();
+    if (NearbyMessage::configAndroid(msg, view))
+        checkWithin(msg, view);
+}
+
+static void rangingHandler(UWBRangingData &data)
+{
+    (void)data;
+}
+
+static void sessionInfoHandler(uwb::SessionInfo &info)
+{
+    (void)info;
+}
+
+static void step(void)
+{
+    UWBNearbySessionManager.poll();
+    delay(10);
+}
+
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv)
+{
+    (void)argc;
+    (void)argv;
+    SimPeer iphone(0x3001);
+    iphone.phone = true;
+    sim.seed(1);
+    sim.addPeer(iphone);
+    UWB.registerRangingCallback(rangingHandler);
+    UWB.registerSessionInfoCallback(sessionInfoHandler);
+    UWB.begin(Serial, uwb::LogLevel::UWB_SILENT_LEVEL);
+    UWBNearbySessionManager.begin("fuzz");
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    decode(data, size);
+
+    BLE.connect(phone);
+    size_t o = 0;
+    while (o < size) {
+        size_t len = data[o++];
+        if (len == 0) {
+            BLE.disconnect(phone);
+            step();
+            BLE.connect(phone);
+            continue;
+        }
+        if (len > size - o)
+            len = size - o;
+        // exactly the bytes written, so that reading past them is caught
+        std::vector<uint8_t> msg(data + o, data + o + len);
+        o += len;
+        decode(msg.data(), msg.size());
+        UWBNearbySessionManager.handleTLV(phone, msg.data(), msg.size());
+        step();
+    }
+
+    BLE.disconnect(phone);
+    for (int i = 0; i < FUZZ_POLLS_AFTER_DISCONNECT && UWBNearbySessionManager.find(phone); i++)
+        step();
+    return 0;
+}
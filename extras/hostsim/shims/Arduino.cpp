@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#include "Arduino.h"
+#include "ArduinoBLE.h"
+#include "SimHal.hpp"
+
+HardwareSerial Serial;
+BLELocalDevice BLE;
+
+size_t Print::print(long v, int base)
+{
+    if (base == DEC) {
+        char s[24];
+        snprintf(s, sizeof(s), "%ld", v);
+        return print(s);
+    }
+    return print((unsigned long)v, base);
+}
+
+size_t Print::print(unsigned long v, int base)
+{
+    char s[24];
+    snprintf(s, sizeof(s), base == HEX ? "%lX" : "%lu", v);
+    return print(s);
+}
+
+size_t Print::print(double v, int digits)
+{
+    char s[48];
+    snprintf(s, sizeof(s), "%.*f", digits, v);
+    return print(s);
+}
+
+unsigned long millis(void)
+{
+    return SimHal::instance().now() / 1000;
+}
+
+unsigned long micros(void)
+{
+    return SimHal::instance().now();
+}
+
+void delay(unsigned long ms)
+{
+    SimHal::instance().advance((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    SimHal::instance().advance(us);
+}
+
+void yield(void)
+{
+}
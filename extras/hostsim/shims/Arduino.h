@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+// Host (Linux) stand-in for the parts of the Arduino core the library uses.
+// millis(), micros() and delay() run on the simulated clock of SimHal.
+
+#ifndef HOSTSIM_ARDUINO_H
+#define HOSTSIM_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define DEC 10
+#define HEX 16
+#define F(s) (s)
+
+class String {
+public:
+    String(const char *s = "") : str(s ? s : "") {}
+    String(const std::string &s) : str(s) {}
+    const char *c_str() const { return str.c_str(); }
+    unsigned int length() const { return str.size(); }
+    char operator[](unsigned int i) const { return i < str.size() ? str[i] : 0; }
+    bool operator==(const String &other) const { return str == other.str; }
+    bool operator!=(const String &other) const { return str != other.str; }
+
+private:
+    std::string str;
+};
+
+/**
+ * @brief prints to stdout
+ *
+ */
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(const char *s, size_t n) { return fwrite(s, 1, n, stdout); }
+
+    size_t print(const char *s) { return write(s, strlen(s)); }
+    size_t print(const String &s) { return print(s.c_str()); }
+    size_t print(char c) { return write(&c, 1); }
+    size_t print(long v, int base = DEC);
+    size_t print(int v, int base = DEC) { return print((long)v, base); }
+    size_t print(unsigned long v, int base = DEC);
+    size_t print(unsigned int v, int base = DEC) { return print((unsigned long)v, base); }
+    size_t print(double v, int digits = 2);
+
+    size_t println(void) { return print("\r\n"); }
+    template <typename T>
+    size_t println(T v) { return print(v) + println(); }
+    template <typename T>
+    size_t println(T v, int format) { return print(v, format) + println(); }
+};
+
+class Stream : public Print {
+public:
+    virtual int available(void) { return 0; }
+    virtual int read(void) { return -1; }
+};
+
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield(void);
+
+// the notification callbacks never run while loop() does, see SimHal
+inline void noInterrupts(void) {}
+inline void interrupts(void) {}
+
+#endif /* HOSTSIM_ARDUINO_H */
@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+// Host stand-in for the parts of ArduinoBLE NearbySessionManager uses. No
+// radio: a simulation plays the phones with BLE.connect(), write() on the
+// RX characteristic and BLE.disconnect(), and reads what the accessory
+// notified with lastValue().
+
+#ifndef HOSTSIM_ARDUINOBLE_H
+#define HOSTSIM_ARDUINOBLE_H
+
+#include <memory>
+#include <vector>
+#include "Arduino.h"
+
+enum BLEDeviceEvent { BLEConnected = 0, BLEDisconnected, BLEDeviceLastEvent };
+enum BLECharacteristicEvent { BLESubscribed = 0, BLEUnsubscribed, BLERead_, BLEWritten, BLECharacteristicEventLast };
+enum BLEProperty { BLEBroadcast = 0x01, BLERead = 0x02, BLEWriteWithoutResponse = 0x04, BLEWrite = 0x08, BLENotify = 0x10, BLEIndicate = 0x20 };
+
+class BLEDevice {
+public:
+    BLEDevice(const char *addr = "00:00:00:00:00:00") : addr(addr) {}
+    String address() const { return addr; }
+    bool connected() const { return true; }
+    bool disconnect();
+    operator bool() const { return true; }
+
+private:
+    String addr;
+};
+
+class BLECharacteristic;
+typedef void (*BLEDeviceEventHandler)(BLEDevice device);
+typedef void (*BLECharacteristicEventHandler)(BLEDevice device, BLECharacteristic characteristic);
+
+/**
+ * @brief copies share the value and the handler, as ArduinoBLE handles do
+ *
+ */
+class BLECharacteristic {
+public:
+    BLECharacteristic() : impl(std::make_shared<Impl>()) {}
+    BLECharacteristic(const char *uuid, uint8_t properties, int valueSize) : impl(std::make_shared<Impl>()) {
+        (void)uuid;
+        (void)properties;
+        impl->size = valueSize;
+    }
+
+    int writeValue(const uint8_t *value, int length) {
+        if (length > impl->size)
+            length = impl->size;
+        impl->value.assign(value, value + length);
+        impl->writes++;
+        return 1;
+    }
+    int writeValue(const void *value, int length) { return writeValue((const uint8_t *)value, length); }
+    const uint8_t *value() const { return impl->value.data(); }
+    int valueLength() const { return impl->value.size(); }
+    int valueSize() const { return impl->size; }
+    bool subscribed() const { return true; }
+    void setEventHandler(int event, BLECharacteristicEventHandler handler) {
+        if (event == BLEWritten)
+            impl->written = handler;
+    }
+
+    /**
+     * @brief simulation: a phone writes the characteristic
+     */
+    void write(BLEDevice central, const uint8_t *value, int length) {
+        impl->value.assign(value, value + length);
+        if (impl->written)
+            impl->written(central, *this);
+    }
+    /**
+     * @brief simulation: values written by the accessory (notifications)
+     */
+    const std::vector<uint8_t> &lastValue() const { return impl->value; }
+    unsigned long writes() const { return impl->writes; }
+
+private:
+    struct Impl {
+        std::vector<uint8_t> value;
+        int size = 0;
+        unsigned long writes = 0;
+        BLECharacteristicEventHandler written = nullptr;
+    };
+    std::shared_ptr<Impl> impl;
+};
+
+class BLEService {
+public:
+    BLEService() {}
+    BLEService(const char *uuid) { (void)uuid; }
+    void addCharacteristic(BLECharacteristic &characteristic) { characteristics.push_back(characteristic); }
+
+    std::vector<BLECharacteristic> characteristics;
+};
+
+class BLELocalDevice {
+public:
+    int begin(void) { return 1; }
+    void end(void) {}
+    void poll(unsigned long timeout = 0) { (void)timeout; }
+    int advertise(void) { return 1; }
+    void stopAdvertise(void) {}
+    void setAdvertisedService(const BLEService &service) { (void)service; }
+    void addService(BLEService &service) { services.push_back(service); }
+    void setLocalName(const char *name) { (void)name; }
+    void setDeviceName(const char *name) { (void)name; }
+    void setEventHandler(BLEDeviceEvent event, BLEDeviceEventHandler handler) {
+        if (event < BLEDeviceLastEvent)
+            handlers[event] = handler;
+    }
+
+    /**
+     * @brief simulation: a phone connects or goes away
+     */
+    void connect(BLEDevice central) {
+        if (handlers[BLEConnected])
+            handlers[BLEConnected](central);
+    }
+    void disconnect(BLEDevice central) {
+        if (handlers[BLEDisconnected])
+            handlers[BLEDisconnected](central);
+    }
+
+    std::vector<BLEService> services;
+
+private:
+    BLEDeviceEventHandler handlers[BLEDeviceLastEvent] = {nullptr, nullptr};
+};
+
+extern BLELocalDevice BLE;
+
+inline bool BLEDevice::disconnect()
+{
+    BLE.disconnect(*this);
+    return true;
+}
+
+#endif /* HOSTSIM_ARDUINOBLE_H */
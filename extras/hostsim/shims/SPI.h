@@ -0,0 +1,11 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+// Host stand-in: the simulated UWB chip has no bus.
+
+#ifndef HOSTSIM_SPI_H
+#define HOSTSIM_SPI_H
+
+#include "Arduino.h"
+
+#endif /* HOSTSIM_SPI_H */
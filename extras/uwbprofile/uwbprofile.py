@@ -0,0 +1,268 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025 Truesense Srl
+"""Build binary UWB session profiles, see src/uwbapps/UWBProfile.hpp
+
+A profile is described by a text file of key = value lines, '#' starts a
+comment. Enum values and parameter IDs use the names of src/hal/uwb_types.hpp,
+numbers can be given instead:
+
+    session_id = 0x1234
+    session_type = RANGING
+    role = INITIATOR
+    device_type = CONTROLLER
+    node_mode = UNICAST
+    method = DS_TWR
+    scheduled = TIME_SCHEDULED
+    mac_mode = 0
+    device_mac = 11:11
+    dst_mac = 22:22, 33:33          # the number of controlees follows
+    sts_iv = 0x0708 01:02:03:04:05:06
+
+    app.Channel = 9
+    app.PreambleCodeIndex = 10
+    app.SessionKey = 00:11:22:33:44:55:66:77:88:99:aa:bb:cc:dd:ee:ff
+    vendor.ANTENNAE_CONFIGURATION_TX = 01
+
+Usage:
+
+    uwbprofile.py tag.txt -o tag.bin
+    uwbprofile.py tag.txt --c-array tagProfile -o tag.h
+    uwbprofile.py --dump tag.bin
+
+The C array can be handed to UWBSession::loadProfile() as is.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+VERSION = 1
+MAGIC = b"UWBP"
+SECTION_RANGING = 0x01
+SECTION_APP = 0x02
+SECTION_VENDOR = 0x03
+SECTION_STS_IV = 0x04
+
+# IDs whose value is a byte array, as isArrayParam() in UWBAppParamsList.hpp
+APP_ARRAYS = {"LocalAddress", "PeerAddress", "StaticStsIv", "UlTdoaDeviceId",
+              "SessionKey", "SubSessionKey"}
+VENDOR_ARRAYS = {"ANTENNAE_CONFIGURATION_TX", "ANTENNAE_CONFIGURATION_RX"}
+
+DEFAULT_TYPES = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                             "..", "..", "src", "hal", "uwb_types.hpp")
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE, as UWBProfile::crc16()"""
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021 if crc & 0x8000 else crc << 1) & 0xFFFF
+    return crc
+
+
+def read_enums(path):
+    """name -> {entry: value} for every enum of the header"""
+    text = re.sub(r"//[^\n]*", "", open(path).read())
+    enums = {}
+    for m in re.finditer(r"enum\s+(?:class\s+)?(\w+)\s*(?::\s*\w+)?\s*\{(.*?)\}", text, re.S):
+        entries = {}
+        for e in re.finditer(r"(\w+)\s*=\s*(0x[0-9A-Fa-f]+|\d+)", m.group(2)):
+            entries[e.group(1)] = int(e.group(2), 0)
+        enums[m.group(1)] = entries
+    return enums
+
+
+class Error(Exception):
+    pass
+
+
+def number(text, names=None):
+    text = text.strip()
+    if names and text in names:
+        return names[text]
+    try:
+        return int(text, 0)
+    except ValueError:
+        raise Error("unknown value '%s'" % text)
+
+
+def octets(text):
+    text = text.strip().replace(":", "").replace(" ", "")
+    if text.startswith("0x"):
+        text = text[2:]
+    try:
+        return bytes.fromhex(text)
+    except ValueError:
+        raise Error("bad byte string '%s'" % text)
+
+
+def tlv(id_, value, array):
+    if array:
+        data = value
+    else:
+        data = struct.pack("<I", value)
+        data = data[:4 if value > 0xFFFF else 2 if value > 0xFF else 1]
+    if len(data) > 0xFF:
+        raise Error("value of 0x%02X too long" % id_)
+    return bytes([id_, len(data)]) + data
+
+
+def build(lines, enums):
+    fields = {"session_id": 0, "session_type": 0, "role": 0, "device_type": 0,
+              "node_mode": 0, "method": 1, "scheduled": 0, "mac_mode": 0}
+    names = {"session_type": "SessionType", "role": "DeviceRole",
+             "device_type": "DeviceType", "node_mode": "MultiNodeMode",
+             "method": "RangingMethod", "scheduled": "ScheduledMode"}
+    device_mac = b""
+    dst = []
+    sts_iv = None
+    app = bytearray()
+    vendor = bytearray()
+    app_ids = enums["AppConfigId"]
+    vendor_ids = enums["VendorAppConfigId"]
+
+    for n, line in enumerate(lines, 1):
+        line = line.split("#", 1)[0].strip()
+        if not line:
+            continue
+        try:
+            if "=" not in line:
+                raise Error("expected key = value")
+            key, value = (s.strip() for s in line.split("=", 1))
+            if key in fields:
+                fields[key] = number(value, enums.get(names.get(key), {}))
+            elif key == "device_mac":
+                device_mac = octets(value)
+            elif key == "dst_mac":
+                dst = [octets(v) for v in value.split(",")]
+            elif key == "sts_iv":
+                vendor_id, iv = value.split(None, 1)
+                sts_iv = struct.pack("<H", number(vendor_id)) + octets(iv)
+                if len(sts_iv) != 8:
+                    raise Error("the STS IV is 6 bytes")
+            elif key.startswith("app."):
+                name = key[4:]
+                array = name in APP_ARRAYS
+                app += tlv(number(name, app_ids), octets(value) if array else number(value), array)
+            elif key.startswith("vendor."):
+                name = key[7:]
+                array = name in VENDOR_ARRAYS
+                vendor += tlv(number(name, vendor_ids), octets(value) if array else number(value), array)
+            else:
+                raise Error("unknown key '%s'" % key)
+        except Error as e:
+            raise Error("line %d: %s" % (n, e))
+
+    addr_len = 2 if fields["mac_mode"] == 0 else 8
+    if device_mac and len(device_mac) != addr_len:
+        raise Error("device_mac must be %d bytes with mac_mode %d" % (addr_len, fields["mac_mode"]))
+    if any(len(a) != addr_len for a in dst):
+        raise Error("dst_mac addresses must be %d bytes" % addr_len)
+    if len(dst) > 12:
+        raise Error("at most 12 controlees")
+
+    ranging = bytes([fields["role"], fields["device_type"], fields["node_mode"],
+                     fields["method"], fields["scheduled"], fields["mac_mode"], len(dst)])
+    ranging += device_mac.ljust(8, b"\0") + b"".join(dst)
+
+    body = section(SECTION_RANGING, ranging) + section(SECTION_APP, app)
+    if vendor:
+        body += section(SECTION_VENDOR, vendor)
+    if sts_iv:
+        body += section(SECTION_STS_IV, sts_iv)
+
+    total = 13 + len(body) + 2
+    if total > 0xFFFF:
+        raise Error("profile too large")
+    out = MAGIC + struct.pack("<BBHIB", VERSION, 0, total, fields["session_id"],
+                              fields["session_type"]) + body
+    return out + struct.pack("<H", crc16(out))
+
+
+def section(id_, payload):
+    return struct.pack("<BH", id_, len(payload)) + bytes(payload)
+
+
+def dump(data, enums):
+    if data[:4] != MAGIC or len(data) < 15:
+        raise Error("not a profile")
+    version, _, total, session_id, session_type = struct.unpack_from("<BBHIB", data, 4)
+    if version != VERSION or total > len(data):
+        raise Error("unsupported version or truncated profile")
+    if crc16(data[:total - 2]) != struct.unpack_from("<H", data, total - 2)[0]:
+        raise Error("bad CRC")
+    print("session_id = 0x%X" % session_id)
+    print("session_type = %d" % session_type)
+    by_value = {k: {v: n for n, v in e.items()} for k, e in enums.items()}
+    o = 13
+    while o < total - 2:
+        id_, size = struct.unpack_from("<BH", data, o)
+        p = data[o + 3:o + 3 + size]
+        o += 3 + size
+        if id_ == SECTION_RANGING:
+            print("ranging = %s" % p[:7].hex(" "))
+            print("device_mac = %s" % p[7:15].hex(":"))
+            if len(p) > 15:
+                print("dst_mac = %s" % p[15:].hex(":"))
+        elif id_ in (SECTION_APP, SECTION_VENDOR):
+            prefix, table = ("app", "AppConfigId") if id_ == SECTION_APP else ("vendor", "VendorAppConfigId")
+            i = 0
+            while i + 2 <= len(p):
+                pid, plen = p[i], p[i + 1]
+                name = by_value[table].get(pid, "0x%02X" % pid)
+                print("%s.%s = %s" % (prefix, name, p[i + 2:i + 2 + plen].hex(":")))
+                i += 2 + plen
+        elif id_ == SECTION_STS_IV:
+            print("sts_iv = 0x%04X %s" % (struct.unpack_from("<H", p)[0], p[2:].hex(":")))
+        else:
+            print("# unknown section 0x%02X, %d bytes" % (id_, size))
+
+
+def c_array(name, data):
+    lines = ["// generated by extras/uwbprofile/uwbprofile.py",
+             "const uint8_t %s[%d] = {" % (name, len(data))]
+    for i in range(0, len(data), 12):
+        lines.append("    " + " ".join("0x%02X," % b for b in data[i:i + 12]))
+    lines.append("};")
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    ap = argparse.ArgumentParser(description="build binary UWB session profiles")
+    ap.add_argument("input", help="text description, or a binary profile with --dump")
+    ap.add_argument("-o", "--output", help="output file, stdout if omitted")
+    ap.add_argument("--c-array", metavar="NAME", help="write a C array instead of binary")
+    ap.add_argument("--dump", action="store_true", help="print a binary profile")
+    ap.add_argument("--types", default=DEFAULT_TYPES, help="path of uwb_types.hpp")
+    args = ap.parse_args()
+
+    try:
+        enums = read_enums(args.types)
+        if args.dump:
+            dump(open(args.input, "rb").read(), enums)
+            return 0
+        data = build(open(args.input).read().splitlines(), enums)
+    except (Error, OSError) as e:
+        print("uwbprofile: %s" % e, file=sys.stderr)
+        return 1
+
+    if args.c_array:
+        text = c_array(args.c_array, data)
+        if args.output:
+            open(args.output, "w").write(text)
+        else:
+            sys.stdout.write(text)
+    elif args.output:
+        open(args.output, "wb").write(data)
+    else:
+        sys.stdout.buffer.write(data)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
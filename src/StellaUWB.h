@@ -5,6 +5,18 @@
 #include "uwbapps/UWB.hpp"
 #include "uwbapps/UWBUltdoaTag.hpp"
 #include "uwbapps/UWBTracker.hpp"
+#include "uwbapps/UWBMultiTracker.hpp"
+#include "uwbapps/UWBSessionScheduler.hpp"
+#include "uwbapps/UWBAdaptiveRanging.hpp"
+#include "uwbapps/UWBPreset.hpp"
+#include "uwbapps/UWBSlotPlanner.hpp"
+#include "uwbapps/UWBChannelAllocator.hpp"
+#include "uwbapps/UWBParamValidator.hpp"
+#include "uwbapps/UWBProfile.hpp"
+#include "uwbapps/UWBPeerTable.hpp"
+#include "uwbapps/UWBDataStream.hpp"
+#include "uwbapps/UWBReliableChannel.hpp"
+#include "uwbapps/UWBCompressedData.hpp"
 #include "uwbapps/NearbySession.hpp"
 #include "uwbapps/NearbySessionManager.hpp"
 
@@ -615,6 +615,15 @@ struct SessionConfig {
     uint32_t ranging_interval_ms;
 };
 
+// Session states reported in SessionInfo::state
+enum class SessionStatus : uint8_t {
+    INIT = 0x00,              // Session initialized
+    DEINIT = 0x01,            // Session de-initialized
+    ACTIVE = 0x02,            // Ranging ongoing
+    IDLE = 0x03,              // Configured, not ranging
+    UNKNOWN = 0xFF            // No notification received yet
+};
+
 struct SessionInfo {
     uint32_t sessionHandle;  // Session Handle
     uint8_t state;          // Session state
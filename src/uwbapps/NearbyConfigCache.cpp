@@ -0,0 +1,157 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#include "Arduino.h"
+#include "hal/uwb_hal.hpp"
+#include "NearbyConfigCache.hpp"
+
+NearbyConfigCache::NearbyConfigCache()
+    : iosValid(false), androidValid(false), hit(false), state(0), nextRecent(0)
+{
+    memset(recent, 0, sizeof(recent));
+    resetReport();
+}
+
+void NearbyConfigCache::invalidate(void)
+{
+    iosValid = false;
+    androidValid = false;
+}
+
+uwb::Status NearbyConfigCache::iOS(uwb::AccessoryConfigData &config)
+{
+    hit = iosValid;
+    if (!iosValid)
+    {
+        uwb::Status status = readIOS();
+        if (status != uwb::Status::SUCCESS)
+            return status;
+    }
+    else
+        stats.hits++;
+
+    config = iosConfig;
+    shortMac(config.device_mac_addr);
+    return uwb::Status::SUCCESS;
+}
+
+uwb::Status NearbyConfigCache::android(uwb::DeviceConfig &config)
+{
+    hit = androidValid;
+    if (!androidValid)
+    {
+        uwb::Status status = readAndroid();
+        if (status != uwb::Status::SUCCESS)
+            return status;
+    }
+    else
+        stats.hits++;
+
+    config = androidConfig;
+    shortMac(config.device_mac_addr);
+    return uwb::Status::SUCCESS;
+}
+
+uwb::Status NearbyConfigCache::readIOS(void)
+{
+    stats.misses++;
+    uint32_t t0 = micros();
+    uwb::Status status = UWBHAL.getUwbConfigData_iOS(uwb::DeviceRole::INITIATOR, iosConfig);
+    /* If the status if HPD wake up then try to do it one more time */
+    if (status == uwb::Status::HPDWKUP)
+    {
+        UWBHAL.Log_W("Device woke up from HPD");
+        UWBHAL.setDefaultCoreConfigs();
+        status = UWBHAL.getUwbConfigData_iOS(uwb::DeviceRole::INITIATOR, iosConfig);
+    }
+    uint32_t elapsed = micros() - t0;
+    if (elapsed > stats.readUs)
+        stats.readUs = elapsed;
+
+    if (status != uwb::Status::SUCCESS)
+    {
+        UWBHAL.Log_E("GetUwbConfigData configuration failed");
+        stats.failures++;
+        return status;
+    }
+    seed(iosConfig.device_mac_addr);
+    iosValid = true;
+    return status;
+}
+
+uwb::Status NearbyConfigCache::readAndroid(void)
+{
+    stats.misses++;
+    uint32_t t0 = micros();
+    uwb::Status status = UWBHAL.getUwbConfigData_Android(androidConfig);
+    if (status == uwb::Status::HPDWKUP)
+    {
+        UWBHAL.Log_W("Device woke up from HPD");
+        UWBHAL.setDefaultCoreConfigs();
+        status = UWBHAL.getUwbConfigData_Android(androidConfig);
+    }
+    uint32_t elapsed = micros() - t0;
+    if (elapsed > stats.readUs)
+        stats.readUs = elapsed;
+
+    if (status != uwb::Status::SUCCESS)
+    {
+        UWBHAL.Log_E("GetUwbConfigData configuration failed");
+        stats.failures++;
+        return status;
+    }
+    seed(androidConfig.device_mac_addr);
+    androidValid = true;
+    return status;
+}
+
+void NearbyConfigCache::seed(const uint8_t mac[2])
+{
+    // the chip draws its address at random, mix it with the time of the read
+    state ^= ((uint32_t)mac[0] << 24) | ((uint32_t)mac[1] << 16) | (micros() & 0xFFFF);
+    if (state == 0)
+        state = 0x2545F491;
+
+    // the chip's address is in use until the phone forgets it
+    recent[nextRecent] = mac[0] | (mac[1] << 8);
+    nextRecent = (nextRecent + 1) % NEARBY_RECENT_MACS;
+}
+
+uint32_t NearbyConfigCache::random(void)
+{
+    // xorshift32
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+void NearbyConfigCache::shortMac(uint8_t mac[2])
+{
+    uint16_t addr;
+    bool used;
+    do
+    {
+        addr = random() >> 16;
+        // 0x0000 and the broadcast address are not valid device addresses
+        used = addr == 0 || addr == 0xFFFF;
+        for (uint8_t i = 0; i < NEARBY_RECENT_MACS && !used; i++)
+            used = recent[i] == addr;
+    } while (used);
+
+    recent[nextRecent] = addr;
+    nextRecent = (nextRecent + 1) % NEARBY_RECENT_MACS;
+    mac[0] = addr & 0xFF;
+    mac[1] = addr >> 8;
+}
+
+void NearbyConfigCache::resetReport(void)
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+void NearbyConfigCache::printReport(void) const
+{
+    UWBHAL.Log_I("nearby config: %lu hits, %lu chip reads (%lu failed), longest read %lu us",
+                 stats.hits, stats.misses, stats.failures, stats.readUs);
+}
@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#ifndef NEARBYCONFIGCACHE_HPP
+#define NEARBYCONFIGCACHE_HPP
+
+#include <stdint.h>
+#include "hal/uwb_types.hpp"
+
+/* short MAC addresses remembered to keep the sessions of different phones apart */
+#ifndef NEARBY_RECENT_MACS
+#define NEARBY_RECENT_MACS 8
+#endif
+
+/**
+ * @brief accessory configuration sent to the phones in answer to Initialize
+ *
+ * Versions, manufacturer, model, chip and middleware versions and clock
+ * drift are the same for every phone: the chip is asked once per platform
+ * (getUwbConfigData_iOS(), getUwbConfigData_Android()), later requests
+ * are served from RAM. Only the short MAC address is per session, it is
+ * drawn here for each request and never repeats one of the last
+ * NEARBY_RECENT_MACS handed out.
+ *
+ * invalidate() makes the next request read the chip again, after a
+ * firmware update or a change of the clock calibration.
+ */
+class NearbyConfigCache {
+public:
+    /**
+     * @brief statistics since the last resetReport()
+     *
+     */
+    struct Report {
+        uint32_t hits;
+        uint32_t misses;        // chip reads
+        uint32_t failures;      // chip reads that failed
+        uint32_t readUs;        // longest chip read
+    };
+
+    NearbyConfigCache();
+
+    /**
+     * @brief iOS accessory configuration with a fresh short MAC address
+     *
+     * @return the status of the chip read on a miss, SUCCESS on a hit
+     */
+    uwb::Status iOS(uwb::AccessoryConfigData &config);
+
+    /**
+     * @brief Android device configuration with a fresh short MAC address
+     *
+     * @return the status of the chip read on a miss, SUCCESS on a hit
+     */
+    uwb::Status android(uwb::DeviceConfig &config);
+
+    /**
+     * @brief true if the last iOS()/android() call did not read the chip
+     *
+     */
+    bool lastHit(void) const { return hit; }
+
+    void invalidate(void);
+
+    const Report &report(void) const { return stats; }
+    void resetReport(void);
+    void printReport(void) const;
+
+private:
+    uwb::Status readIOS(void);
+    uwb::Status readAndroid(void);
+    void seed(const uint8_t mac[2]);
+    void shortMac(uint8_t mac[2]);
+    uint32_t random(void);
+
+    uwb::AccessoryConfigData iosConfig;
+    uwb::DeviceConfig androidConfig;
+    bool iosValid;
+    bool androidValid;
+    bool hit;
+    uint32_t state;
+    uint16_t recent[NEARBY_RECENT_MACS];
+    uint8_t nextRecent;
+    Report stats;
+};
+
+#endif /* NEARBYCONFIGCACHE_HPP */
@@ -0,0 +1,18 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#include "NearbyMessage.hpp"
+
+bool NearbyMessage::shareableIOS(NearbySpan msg, NearbySpan& shareable)
+{
+    if (msg.len <= IOS_LENGTH_OFFSET)
+        return false;
+    shareable = msg.sub(0, (size_t)msg.data[IOS_LENGTH_OFFSET] + IOS_HEADER_LENGTH);
+    return !shareable.empty();
+}
+
+bool NearbyMessage::configAndroid(NearbySpan msg, NearbySpan& config)
+{
+    config = msg.sub(1, ANDROID_CONFIG_LENGTH);
+    return !config.empty();
+}
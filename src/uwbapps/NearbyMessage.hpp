@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#ifndef NEARBYMESSAGE_HPP
+#define NEARBYMESSAGE_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* size of the BLE characteristics, the longest message or response */
+#define NEARBY_MESSAGE_SIZE 128
+
+/**
+ * @brief bytes of a message, not owned
+ *
+ */
+struct NearbySpan {
+    const uint8_t* data;
+    size_t len;
+
+    NearbySpan() : data(nullptr), len(0) {}
+    NearbySpan(const uint8_t* d, size_t l) : data(d), len(d ? l : 0) {}
+
+    bool empty() const { return len == 0; }
+
+    /**
+     * @brief n bytes from offset, an empty span if they are not all there
+     *
+     */
+    NearbySpan sub(size_t offset, size_t n) const {
+        if (offset > len || n > len - offset)
+            return NearbySpan();
+        return NearbySpan(data + offset, n);
+    }
+};
+
+/**
+ * @brief decoding of the messages a phone writes to the Nearby RX characteristic
+ *
+ * The first byte is the message ID (MessageId_t), the rest depends on it.
+ * Decoders check every length against the bytes received and return views
+ * into the message, nothing is copied. They depend on nothing else, so that
+ * they build and can be fuzzed on a host.
+ */
+struct NearbyMessage {
+    /* ConfigureAndStart from iOS: byte 5 holds the length of the shareable
+       data following the 5 byte header, the message ID included */
+    static const uint8_t IOS_LENGTH_OFFSET = 5;
+    static const uint8_t IOS_HEADER_LENGTH = 5;
+    /* ConfigureAndStart from Android: fixed configuration after the ID */
+    static const uint8_t ANDROID_CONFIG_LENGTH = 14;
+
+    /**
+     * @brief shareable data of an iOS ConfigureAndStart, as configureDevice_iOS() takes it
+     *
+     * @return false if the message is shorter than its length byte says
+     */
+    static bool shareableIOS(NearbySpan msg, NearbySpan& shareable);
+
+    /**
+     * @brief configuration of an Android ConfigureAndStart
+     *
+     * @return false if the message is too short
+     */
+    static bool configAndroid(NearbySpan msg, NearbySpan& config);
+};
+
+/**
+ * @brief builds a response in a preallocated buffer
+ *
+ * Writes past the end are dropped and make overflow() true, the response is
+ * then not to be sent.
+ */
+class NearbyWriter {
+public:
+    NearbyWriter(uint8_t* buffer, size_t size) : buf(buffer), cap(size), pos(0), over(false) {}
+
+    void put(uint8_t b) {
+        if (pos < cap)
+            buf[pos++] = b;
+        else
+            over = true;
+    }
+
+    void put(const uint8_t* p, size_t n) {
+        if (n > cap - pos || (!p && n)) {
+            over = true;
+            return;
+        }
+        for (size_t i = 0; i < n; ++i)
+            buf[pos++] = p[i];
+    }
+
+    const uint8_t* data() const { return buf; }
+    size_t length() const { return pos; }
+    bool overflow() const { return over; }
+
+private:
+    uint8_t* buf;
+    size_t cap;
+    size_t pos;
+    bool over;
+};
+
+#endif /* NEARBYMESSAGE_HPP */
@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#include "Arduino.h"
+#include <ArduinoBLE.h>
+#include "hal/uwb_hal.hpp"
+#include "NearbyRangingRelay.hpp"
+#include "NearbySession.hpp"
+
+static void put16(NearbyWriter &w, uint16_t v)
+{
+    w.put(v & 0xFF);
+    w.put(v >> 8);
+}
+
+NearbyRangingRelay::NearbyRangingRelay()
+    : enabled(false), intervalMs(NEARBY_RELAY_INTERVAL_MS), maxSize(NEARBY_MESSAGE_SIZE),
+      lastSent(0), count(0), writer(buffer, sizeof(buffer))
+{
+    resetReport();
+}
+
+void NearbyRangingRelay::size(size_t bytes)
+{
+    if (bytes > NEARBY_MESSAGE_SIZE)
+        bytes = NEARBY_MESSAGE_SIZE;
+    if (bytes < HEADER_LENGTH + RECORD_LENGTH)
+        bytes = HEADER_LENGTH + RECORD_LENGTH;
+    maxSize = bytes;
+}
+
+bool NearbyRangingRelay::begin(uint32_t now)
+{
+    if (!enabled || now - lastSent < intervalMs)
+        return false;
+    writer = NearbyWriter(buffer, sizeof(buffer));
+    writer.put(kRsp_RangingData);
+    writer.put(0);      // count, set by add()
+    count = 0;
+    return true;
+}
+
+void NearbyRangingRelay::add(const uint8_t mac[2], const NearbyRangeSample &sample)
+{
+    if (!room())
+        return;
+    writer.put(mac, 2);
+    put16(writer, sample.seq);
+    put16(writer, sample.distance);
+    put16(writer, (uint16_t)sample.azimuth);
+    put16(writer, (uint16_t)sample.elevation);
+    buffer[1] = ++count;
+}
+
+void NearbyRangingRelay::sent(uint32_t now)
+{
+    lastSent = now;
+    stats.notifications++;
+    stats.samples += count;
+    stats.bytes += writer.length();
+    if (count > stats.maxRecords)
+        stats.maxRecords = count;
+    count = 0;
+}
+
+void NearbyRangingRelay::resetReport(void)
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+void NearbyRangingRelay::printReport(void) const
+{
+    UWBHAL.Log_I("nearby relay: %lu notifications, %lu samples (up to %d per notification), %lu conflated, %lu bytes",
+                 stats.notifications, stats.samples, stats.maxRecords, stats.conflated, stats.bytes);
+}
@@ -0,0 +1,175 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#ifndef NEARBYRANGINGRELAY_HPP
+#define NEARBYRANGINGRELAY_HPP
+
+#include <stdint.h>
+#include "hal/uwb_types.hpp"
+#include "NearbyMessage.hpp"
+
+/* minimum time between two relay notifications */
+#ifndef NEARBY_RELAY_INTERVAL_MS
+#define NEARBY_RELAY_INTERVAL_MS 100
+#endif
+
+/**
+ * @brief one measurement of the accessory, as relayed to the phone
+ *
+ */
+struct NearbyRangeSample {
+    uint16_t seq;           // low bits of the ranging sequence number
+    uint16_t distance;      // cm
+    int16_t azimuth;        // degrees, Q9.7 as the UWB stack gives it
+    int16_t elevation;      // degrees, Q9.7
+};
+
+/**
+ * @brief latest measurement of a session
+ *
+ * put() is called from the UWB notification context, take() from poll():
+ * a newer measurement replaces one not taken yet (latest wins). The version
+ * is odd while put() writes, take() copies again if it changed meanwhile.
+ */
+class NearbyRangeSlot {
+public:
+    NearbyRangeSlot() : version(0), taken(0), conflated(0) {}
+
+    void put(const NearbyRangeSample &s) {
+        version = version + 1;
+        seq = s.seq;
+        distance = s.distance;
+        azimuth = s.azimuth;
+        elevation = s.elevation;
+        version = version + 1;
+    }
+
+    /**
+     * @brief the measurement received since the last take()
+     *
+     * @return false if there's none
+     */
+    bool take(NearbyRangeSample &s) {
+        uint32_t v;
+        do {
+            v = version;
+            s.seq = seq;
+            s.distance = distance;
+            s.azimuth = azimuth;
+            s.elevation = elevation;
+        } while ((v & 1) || v != version);
+        if (v == taken)
+            return false;
+        // the ones in between were replaced before being sent
+        conflated += (v - taken) / 2 - 1;
+        taken = v;
+        return true;
+    }
+
+    /**
+     * @brief measurements replaced by a newer one, returned once
+     */
+    uint32_t takeConflated(void) {
+        uint32_t n = conflated;
+        conflated = 0;
+        return n;
+    }
+
+private:
+    volatile uint32_t version;
+    volatile uint16_t seq;
+    volatile uint16_t distance;
+    volatile int16_t azimuth;
+    volatile int16_t elevation;
+    uint32_t taken;
+    uint32_t conflated;
+};
+
+/**
+ * @brief packs the accessory's measurements in BLE notifications
+ *
+ * At most one notification per interval, carrying the latest measurement
+ * of every ranging phone:
+ *
+ *     [kRsp_RangingData][count] count x [mac 2][seq 2][distance 2][azimuth 2][elevation 2]
+ *
+ * little endian, mac being the short address the accessory uses with that
+ * phone (sent in the Initialize response): the notification reaches every
+ * subscribed phone, each keeps its own record. Records that do not fit
+ * wait for the next notification, the sessions are taken in turn.
+ *
+ * The size defaults to the 128 byte characteristic; the BLE stack truncates
+ * notifications to the ATT MTU - 3 of each phone, lower it with size() for
+ * phones that do not negotiate a large MTU.
+ */
+class NearbyRangingRelay {
+public:
+    static const uint8_t HEADER_LENGTH = 2;
+    static const uint8_t RECORD_LENGTH = 10;
+
+    /**
+     * @brief statistics since the last resetReport()
+     *
+     */
+    struct Report {
+        uint32_t notifications;
+        uint32_t samples;       // relayed
+        uint32_t conflated;     // replaced by a newer one before being relayed
+        uint32_t bytes;
+        uint8_t maxRecords;     // in one notification
+    };
+
+    NearbyRangingRelay();
+
+    void enable(bool on) { enabled = on; }
+    bool isEnabled(void) const { return enabled; }
+
+    void interval(uint16_t ms) { intervalMs = ms; }
+    uint16_t interval(void) const { return intervalMs; }
+
+    /**
+     * @brief notification size, clamped to the characteristic and to one record
+     *
+     */
+    void size(size_t bytes);
+    size_t size(void) const { return maxSize; }
+
+    /**
+     * @brief start a notification if enabled and the interval elapsed
+     *
+     * @return false if nothing is to be sent now
+     */
+    bool begin(uint32_t now);
+
+    /**
+     * @brief true if one more record fits the notification
+     */
+    bool room(void) const { return writer.length() + RECORD_LENGTH <= maxSize; }
+
+    void add(const uint8_t mac[2], const NearbyRangeSample &sample);
+    void conflated(uint32_t n) { stats.conflated += n; }
+
+    /**
+     * @brief the notification built, empty if there was nothing to relay;
+     * sent, the interval starts over
+     */
+    bool ready(void) const { return count > 0; }
+    const NearbyWriter &message(void) const { return writer; }
+    void sent(uint32_t now);
+
+    const Report &report(void) const { return stats; }
+    void resetReport(void);
+    void printReport(void) const;
+
+private:
+    bool enabled;
+    uint16_t intervalMs;
+    size_t maxSize;
+    uint32_t lastSent;
+    uint8_t count;
+    uint8_t buffer[NEARBY_MESSAGE_SIZE];
+    NearbyWriter writer;
+    Report stats;
+};
+
+#endif /* NEARBYRANGINGRELAY_HPP */
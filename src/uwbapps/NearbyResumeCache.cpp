@@ -0,0 +1,148 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#include "Arduino.h"
+#include "hal/uwb_hal.hpp"
+#include "NearbyResumeCache.hpp"
+
+NearbyResumeCache::NearbyResumeCache() : numEntries(0)
+{
+    resetReport();
+}
+
+int NearbyResumeCache::find(const UWBMacKey &bleKey) const
+{
+    for (int i = 0; i < numEntries; i++)
+    {
+        if (entries[i].bleKey == bleKey)
+            return i;
+    }
+    return -1;
+}
+
+void NearbyResumeCache::drop(int i, bool deinit)
+{
+    if (deinit)
+    {
+        uwb::Status status = UWBHAL.sessionDeinit(entries[i].sessionHandle);
+        if (status != uwb::Status::SUCCESS && status != uwb::Status::SESSION_NOT_EXIST)
+            UWBHAL.Log_W("Parked session %04X deinit failed: %d", entries[i].sessionHandle, status);
+    }
+    // order does not matter, the age is in parkedAt
+    entries[i] = entries[numEntries - 1];
+    numEntries--;
+}
+
+bool NearbyResumeCache::park(const UWBMacKey &bleKey, uint8_t platform, const uint8_t mac[2], uint32_t sessionHandle, NearbySpan params)
+{
+    int i = find(bleKey);
+    if (i >= 0)
+        drop(i, true);
+
+    if (params.empty() || params.len > sizeof(entries[0].params))
+    {
+        UWBHAL.sessionDeinit(sessionHandle);
+        return false;
+    }
+    if (numEntries == NEARBY_RESUME_ENTRIES)
+        evictOldest();
+
+    Entry &entry = entries[numEntries++];
+    entry.bleKey = bleKey;
+    entry.platform = platform;
+    entry.mac[0] = mac[0];
+    entry.mac[1] = mac[1];
+    entry.sessionHandle = sessionHandle;
+    entry.parkedAt = millis();
+    entry.paramsLen = params.len;
+    memcpy(entry.params, params.data, params.len);
+    stats.parked++;
+    UWBHAL.Log_D("Session %04X parked", sessionHandle);
+    return true;
+}
+
+bool NearbyResumeCache::mac(const UWBMacKey &bleKey, uint8_t platform, uint8_t mac[2]) const
+{
+    int i = find(bleKey);
+    if (i < 0 || entries[i].platform != platform)
+        return false;
+    mac[0] = entries[i].mac[0];
+    mac[1] = entries[i].mac[1];
+    return true;
+}
+
+bool NearbyResumeCache::resume(const UWBMacKey &bleKey, uint8_t platform, const uint8_t mac[2], NearbySpan params, uint32_t &sessionHandle)
+{
+    int i = find(bleKey);
+    if (i < 0)
+        return false;
+
+    const Entry &entry = entries[i];
+    if (entry.platform != platform || entry.mac[0] != mac[0] || entry.mac[1] != mac[1] ||
+        entry.paramsLen != params.len || memcmp(entry.params, params.data, params.len) != 0)
+    {
+        UWBHAL.Log_I("Session %04X not resumed, parameters changed", entry.sessionHandle);
+        stats.mismatched++;
+        drop(i, true);
+        return false;
+    }
+
+    // the stack may have dropped it meanwhile (reset, HPD wake up)
+    uint8_t state;
+    if (UWBHAL.getSessionState(entry.sessionHandle, state) != uwb::Status::SUCCESS ||
+        state != (uint8_t)uwb::SessionStatus::IDLE)
+    {
+        UWBHAL.Log_I("Session %04X not resumed, no longer idle", entry.sessionHandle);
+        stats.stale++;
+        drop(i, true);
+        return false;
+    }
+
+    sessionHandle = entry.sessionHandle;
+    stats.resumed++;
+    drop(i, false);
+    return true;
+}
+
+bool NearbyResumeCache::evictOldest(void)
+{
+    if (!numEntries)
+        return false;
+
+    int oldest = 0;
+    uint32_t now = millis();
+    for (int i = 1; i < numEntries; i++)
+    {
+        if (now - entries[i].parkedAt > now - entries[oldest].parkedAt)
+            oldest = i;
+    }
+    UWBHAL.Log_D("Parked session %04X evicted", entries[oldest].sessionHandle);
+    stats.evicted++;
+    drop(oldest, true);
+    return true;
+}
+
+void NearbyResumeCache::expire(void)
+{
+    uint32_t now = millis();
+    for (int i = numEntries - 1; i >= 0; i--)
+    {
+        if (now - entries[i].parkedAt >= NEARBY_RESUME_TTL_MS)
+        {
+            UWBHAL.Log_D("Parked session %04X expired", entries[i].sessionHandle);
+            stats.expired++;
+            drop(i, true);
+        }
+    }
+}
+
+void NearbyResumeCache::resetReport(void)
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+void NearbyResumeCache::printReport(void) const
+{
+    UWBHAL.Log_I("nearby resume: %d parked now, %lu parked, %lu resumed, %lu changed, %lu stale, %lu expired, %lu evicted",
+                 numEntries, stats.parked, stats.resumed, stats.mismatched, stats.stale, stats.expired, stats.evicted);
+}
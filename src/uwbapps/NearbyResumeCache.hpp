@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#ifndef NEARBYRESUMECACHE_HPP
+#define NEARBYRESUMECACHE_HPP
+
+#include <stdint.h>
+#include "UWBPeerTable.hpp"
+#include "NearbyMessage.hpp"
+
+/* phones whose UWB session is kept configured after they disconnect, each
+   holds one session of the UWB stack */
+#ifndef NEARBY_RESUME_ENTRIES
+#define NEARBY_RESUME_ENTRIES 2
+#endif
+/* a phone that does not come back within this time is forgotten */
+#ifndef NEARBY_RESUME_TTL_MS
+#define NEARBY_RESUME_TTL_MS 120000
+#endif
+
+/**
+ * @brief UWB sessions of the phones that went away, kept to resume them
+ *
+ * Phones drop the BLE link all the time (screen lock, app in background)
+ * and come back with the same parameters. When a ranging phone disconnects,
+ * NearbySessionManager stops its session but does not deinit it: the
+ * session is parked here with the phone's MAC address and the parameters
+ * of its last ConfigureAndStart. When the phone reconnects, Initialize
+ * hands out the same MAC address and, if ConfigureAndStart carries the same
+ * parameters and the stack still has the session idle, ranging restarts
+ * with a single start command instead of a new configureDevice.
+ *
+ * Parked sessions are deinit'ed when evicted: least recently parked first
+ * when the cache or the UWB stack is full, after NEARBY_RESUME_TTL_MS, or
+ * as soon as the phone comes back with different parameters.
+ */
+class NearbyResumeCache {
+public:
+    /**
+     * @brief statistics since the last resetReport()
+     *
+     */
+    struct Report {
+        uint32_t parked;
+        uint32_t resumed;
+        uint32_t mismatched;    // came back with other parameters
+        uint32_t stale;         // session gone from the stack
+        uint32_t expired;       // not back within NEARBY_RESUME_TTL_MS
+        uint32_t evicted;       // made room for another session
+    };
+
+    NearbyResumeCache();
+
+    /**
+     * @brief keep the stopped session of a phone, evicting the least recently
+     * parked one if the cache is full
+     *
+     * @param bleKey binary BLE address of the phone
+     * @param platform NearbySession DeviceType
+     * @param mac short MAC address given to the phone
+     * @param sessionHandle stopped, still initialized session
+     * @param params accepted ConfigureAndStart parameters
+     * @return false if the parameters do not fit, the session is then deinit'ed
+     */
+    bool park(const UWBMacKey &bleKey, uint8_t platform, const uint8_t mac[2], uint32_t sessionHandle, NearbySpan params);
+
+    /**
+     * @brief MAC address last given to a phone with a parked session
+     *
+     * @return false if the phone has none
+     */
+    bool mac(const UWBMacKey &bleKey, uint8_t platform, uint8_t mac[2]) const;
+
+    /**
+     * @brief take the parked session of a phone if it can restart as is
+     *
+     * The entry leaves the cache either way; a session that does not match,
+     * or that the stack no longer holds idle, is deinit'ed.
+     *
+     * @param sessionHandle the session to start, when true is returned
+     * @return true if the platform, MAC address and parameters match
+     */
+    bool resume(const UWBMacKey &bleKey, uint8_t platform, const uint8_t mac[2], NearbySpan params, uint32_t &sessionHandle);
+
+    /**
+     * @brief deinit the least recently parked session
+     *
+     * @return false if there's none
+     */
+    bool evictOldest(void);
+
+    /**
+     * @brief deinit the sessions parked for longer than NEARBY_RESUME_TTL_MS,
+     * called by NearbySessionManager::poll()
+     */
+    void expire(void);
+
+    uint8_t count(void) const { return numEntries; }
+
+    const Report &report(void) const { return stats; }
+    void resetReport(void);
+    void printReport(void) const;
+
+private:
+    struct Entry {
+        UWBMacKey bleKey;
+        uint8_t platform;
+        uint8_t mac[2];
+        uint32_t sessionHandle;
+        uint32_t parkedAt;
+        uint8_t paramsLen;
+        uint8_t params[NEARBY_MESSAGE_SIZE];
+    };
+
+    int find(const UWBMacKey &bleKey) const;
+    void drop(int i, bool deinit);
+
+    Entry entries[NEARBY_RESUME_ENTRIES];
+    uint8_t numEntries;
+    Report stats;
+};
+
+#endif /* NEARBYRESUMECACHE_HPP */
@@ -4,6 +4,10 @@
 #ifndef NEARBYSESSION_HPP
 #define NEARBYSESSION_HPP
 #include "UWBSession.hpp"
+#include "UWBPeerTable.hpp"
+#include "NearbyMessage.hpp"
+#include "NearbyConfigCache.hpp"
+#include "NearbyRangingRelay.hpp"
 #include "hal/uwb_types.hpp"
 
 /* Define for App developer */
@@ -22,12 +26,18 @@
 
 #define SHAREABLE_DATA_HEADER_LENGTH_ANDROID 14
 
+/* time allowed to the UWB stack to report the session as idle after a stop */
+#define NEARBY_STOP_TIMEOUT_MS 500
+/* stop commands issued before the session is torn down anyway */
+#define NEARBY_STOP_MAX_ATTEMPTS 3
+
 // Enumerations for session state and device type
 enum SessionState
 {
     notCreated,
     notStarted,
-    Started
+    Started,
+    Stopping
 };
 
 enum DeviceType
@@ -51,6 +61,7 @@ typedef enum
     kRsp_InitializedData = 0x01,
     kRsp_UwbDidStart = 0x02,
     kRsp_UwbDidStop = 0x03,
+    kRsp_RangingData = 0x04,    /* accessory measurements, see NearbyRangingRelay */
 } ResponseId_t;
 
 /**
@@ -65,75 +76,219 @@ class NearbySession : public UWBSession
 {
 
 public:
+    /**
+     * @brief duration of the handshake steps of the session
+     *
+     * The ...Ms fields count from the BLE connection, 0 until the step is
+     * reached.
+     */
+    struct Handshake {
+        uint32_t connectedMs;   // millis() at the connection
+        uint32_t configUs;      // Initialize: accessory configuration built
+        bool configCached;      // ... without reading the chip
+        uint32_t configuredMs;  // accessory configuration sent
+        uint32_t startUs;       // ConfigureAndStart: configureDevice call
+        uint32_t startedMs;     // session configured and started
+        uint32_t activeMs;      // first ACTIVE notification of the UWB stack
+        uint32_t firstRangeMs;  // first ranging notification
+        bool resumed;           // restarted from NearbyResumeCache, no configureDevice
+    };
+
     NearbySession()
     {
         devType = deviceUnknown;
         sessState = notCreated;
+        sessStatus = uwb::SessionStatus::UNKNOWN;
+        stopDeadline = 0;
+        stopTries = 0;
+        stopAccepted = false;
+        release = false;
+        rxLen = 0;
+        queuedAt = 0;
+        acceptedLen = 0;
+        ranged = false;
+        rangedAt = 0;
+        memset(&times, 0, sizeof(times));
+        times.connectedMs = millis();
     }
-    NearbySession(BLEDevice dev)
+    NearbySession(BLEDevice dev) : NearbySession()
     {
-        devType = deviceUnknown;
-        sessState = notCreated;
-        bleDev = dev;
+        bleDevice(dev);
     }
 
-    void bleDevice(BLEDevice dev) { bleDev = dev; }
+    void bleDevice(BLEDevice dev)
+    {
+        bleDev = dev;
+        bleAddr = bleKey(dev);
+    }
     BLEDevice bleDevice(void) { return bleDev; }
     String bleAddress() { return bleDev.address(); }
+
+    /**
+     * @brief binary BLE address of the phone, the session's key in
+     * NearbySessionManager
+     */
+    const UWBMacKey& bleKey(void) const { return bleAddr; }
+
+    /**
+     * @brief binary BLE address of a device
+     *
+     * ArduinoBLE only gives the address as text ("aa:bb:cc:dd:ee:ff"), so
+     * this builds a String: convert once per BLE event and look up with the key.
+     */
+    static UWBMacKey bleKey(const BLEDevice& dev)
+    {
+        String text = dev.address();
+        uint8_t addr[6] = {0};
+        uint8_t digits = 0;
+        for (const char* s = text.c_str(); *s && digits < 12; s++)
+        {
+            char c = *s | 0x20;
+            uint8_t v;
+            if (c >= '0' && c <= '9')
+                v = c - '0';
+            else if (c >= 'a' && c <= 'f')
+                v = c - 'a' + 10;
+            else
+                continue;
+            addr[digits / 2] = (addr[digits / 2] << 4) | v;
+            digits++;
+        }
+        return UWBMacKey(addr, sizeof(addr));
+    }
     void macAddress(UWBMacAddress addr) { macAddr = addr; }
     UWBMacAddress macAddress(void) { return macAddr; }
     void sessionState(SessionState state) { sessState = state; }
     SessionState sessionState(void) { return sessState; }
+
+    /**
+     * @brief last session state notified by the UWB stack, written from the
+     * notification context and consumed by NearbySessionManager::poll()
+     */
+    void sessionStatus(uwb::SessionStatus status) { sessStatus = status; }
+    uwb::SessionStatus sessionStatus(void) { return sessStatus; }
+
+    /**
+     * @brief issue a stop command and move to the Stopping state, the session
+     * is torn down by stopExpired()/deInit once the stack reports it idle
+     *
+     * @return the status of the stop command
+     */
+    uwb::Status beginStop(void)
+    {
+        sessStatus = uwb::SessionStatus::UNKNOWN;
+        uwb::Status operation = stop();
+        stopTries++;
+        stopAccepted = (operation == uwb::Status::SUCCESS || operation == uwb::Status::SESSION_NOT_EXIST);
+        stopDeadline = millis() + NEARBY_STOP_TIMEOUT_MS;
+        sessionState(Stopping);
+        return operation;
+    }
+
+    /**
+     * @brief true when the pending stop has been confirmed by a notification
+     */
+    bool stopConfirmed(void)
+    {
+        return stopAccepted && (sessStatus == uwb::SessionStatus::IDLE || sessStatus == uwb::SessionStatus::DEINIT);
+    }
+
+    /**
+     * @brief true when the pending stop waited longer than NEARBY_STOP_TIMEOUT_MS
+     */
+    bool stopExpired(void) { return (int32_t)(millis() - stopDeadline) >= 0; }
+    bool stopAcknowledged(void) { return stopAccepted; }
+    uint8_t stopAttempts(void) { return stopTries; }
+    void resetStop(void)
+    {
+        stopTries = 0;
+        stopAccepted = false;
+    }
+
+    /**
+     * @brief mark the session to be released once it reaches notCreated
+     * (the BLE link went away while it was still ranging)
+     */
+    void releaseOnStop(bool rel) { release = rel; }
+    bool releaseOnStop(void) { return release; }
+
+    /**
+     * @brief keep a command written by the phone, NearbySessionManager::poll()
+     * executes it later so that the BLE callback never waits for the UWB stack
+     *
+     * @return false if a command is already waiting, only a Stop replaces it
+     */
+    bool queueCommand(NearbySpan msg)
+    {
+        if (msg.empty() || msg.len > sizeof(rxMessage))
+            return false;
+        if (rxLen && msg.data[0] != kMsg_Stop)
+            return false;
+        memcpy(rxMessage, msg.data, msg.len);
+        rxLen = msg.len;
+        queuedAt = millis();
+        return true;
+    }
+    bool commandPending(void) { return rxLen != 0; }
+    NearbySpan pendingCommand(void) { return NearbySpan(rxMessage, rxLen); }
+    uint32_t commandQueuedAt(void) { return queuedAt; }
+    void commandDone(void) { rxLen = 0; }
     void deviceType(DeviceType type)
     {
         devType = type;
     }
     DeviceType deviceType(void) { return devType; }
 
-    uint8_t startAndroid(uint8_t* uwb_data_content)
+    /**
+     * @brief configure the session with the phone's data
+     *
+     * @param config from NearbyMessage::configAndroid()
+     */
+    uint8_t startAndroid(NearbySpan config)
     {
         profileInfo.mac_addr[0] = macAddress().get(0);
         profileInfo.mac_addr[1] = macAddress().get(1);
         //profileInfo.profile_id = 1;//uwb::ProfileId::Profile_1;
         //UWBHAL.Log_MAU8_I("mac addr :", profileInfo.mac_addr, 2);
         uwb::AndroidDeviceConfig andConfig;
-        andConfig.config_data = uwb_data_content + 1;
-        andConfig.config_data_length = ( SHAREABLE_DATA_HEADER_LENGTH_ANDROID);
+        andConfig.config_data = (uint8_t *)config.data;
+        andConfig.config_data_length = config.len;
         andConfig.profile_info = profileInfo;
         andConfig.vendor_configs = {};  
         andConfig.debug_configs = {};
         
 
         uwb_status = UWBHAL.configureDevice_Android(andConfig);
+        /* If the status if HPD wake up then try to do it one more time */
+        if (uwb::Status::HPDWKUP == uwb_status) {
+            UWBHAL.Log_W("Device woke up from HPD");
+            UWBHAL.setDefaultCoreConfigs();
+            uwb_status = UWBHAL.configureDevice_Android(andConfig);
+        }
         if (uwb_status != uwb::Status::SUCCESS) {
             UWBHAL.Log_E("Phone data not configured");
-            /* If the status if HPD wake up then try to do it one more time */
-            if (uwb::Status::HPDWKUP == uwb_status) {
-                UWBHAL.Log_W("Device woke up from HPD");
-                UWBHAL.setDefaultCoreConfigs();
-                uwb_status = UWBHAL.configureDevice_Android(andConfig);
-                if (uwb_status != uwb::Status::SUCCESS) {
-                    UWBHAL.Log_E("Shareable data not configured");
-                    return uwb_status;
-                }
-            } else
-            {
-                UWBHAL.Log_E("Shareable data not configured");
-                return uwb_status;
-            }
-        } else
-        {
-            UWBHAL.Log_I("Phone data configured");
-            //sessionHandle(profileInfo.session_handle);
-            sessionID(profileInfo.session_handle);
-            sessionState(Started);
-            return uwb::Status::SUCCESS;
+            return uwb_status;
         }
-        return uwb::Status::FAILED;
+
+        UWBHAL.Log_I("Phone data configured");
+        // the HAL returns the handle in its copy of the profile info
+        profileInfo.session_handle = andConfig.profile_info.session_handle;
+        //sessionHandle(profileInfo.session_handle);
+        sessionID(profileInfo.session_handle);
+        sessionState(Started);
+        acceptParams(config);
+        return uwb::Status::SUCCESS;
     }
 
-    uint8_t configIOS()
+    /**
+     * @brief build the Initialize response for an iPhone
+     *
+     * @param cache accessory configuration, the chip is only read on a miss
+     * @param resumeMac MAC address to give again to a returning phone
+     */
+    uint8_t configIOS(NearbyConfigCache &cache, const uint8_t *resumeMac = nullptr)
     {
+        uint32_t t0 = micros();
         /* Application related definitions */
         uint8_t SpecMajorVersion[] = SPEC_VERSION_MAJOR;
         uint8_t SpecMinorVersion[] = SPEC_VERSION_MINOR;
@@ -144,30 +299,12 @@ public:
 
         deviceType(iOS);
 
-        /* UWB related definitions */
-        //uwb::AccessoryConfigData cfgIos; 
-        //UserConfigData_iOS.uwb_config_data.spec_version_major
-        //cfgIos.spec_version_major= SPEC_VERSION_MAJOR;
-        //cfgIos.spec_version_major[0] = SPEC_VERSION_MAJOR[0];
-        //cfgIos.spec_version_minor[1] = SPEC_VERSION_MAJOR[1];
-        
-        uwb_status = UWBHAL.getUwbConfigData_iOS(uwb::DeviceRole::INITIATOR, UserConfigData_iOS.uwb_config_data);
+        uwb_status = cache.iOS(UserConfigData_iOS.uwb_config_data);
         if (uwb_status != uwb::Status::SUCCESS)
-        {
-            UWBHAL.Log_E("GetUwbConfigData configuration failed");
-            /* If the status if HPD wake up then try to do it one more time */
-            if (uwb::Status::HPDWKUP == uwb_status)
-            {
-                UWBHAL.Log_W("Device woke up from HPD");
-                UWBHAL.setDefaultCoreConfigs();
-
-                uwb_status = UWBHAL.getUwbConfigData_iOS(uwb::DeviceRole::INITIATOR, UserConfigData_iOS.uwb_config_data);                
-            }
-        }
-        if (uwb_status != uwb::Status::SUCCESS)
-        {
-            UWBHAL.Log_E("GetUwbConfigData configuration failed");
-        }
+            return uwb_status;
+        if (resumeMac)
+            memcpy(UserConfigData_iOS.uwb_config_data.device_mac_addr, resumeMac, 2);
+
         /* Build BLE Message, to be build depending on the iOS application message stream
          * In example application, it contains Message ID + Accessory configuration data */
         BLEmessage_iOS[0] = kRsp_InitializedData; /* Response ID */
@@ -190,15 +327,19 @@ public:
         {
             dataLen = 36;
         }
+        times.configUs = micros() - t0;
+        times.configCached = cache.lastHit();
         return uwb::Status::SUCCESS;
     }
 
-    uint8_t startIOS(uint8_t *data)
+    /**
+     * @brief configure the session with the phone's shareable data
+     *
+     * @param shareable from NearbyMessage::shareableIOS(), length checked
+     */
+    uint8_t startIOS(NearbySpan shareable)
     {
-#define SHAREABLE_DATA_LENGTH_OFFSET 5
-#define SHAREABLE_DATA_HEADER_LENGTH 5
         uwb::ProfileInfo profInfo;
-        uint8_t dataLen = *(data + SHAREABLE_DATA_LENGTH_OFFSET) + SHAREABLE_DATA_HEADER_LENGTH;
         profInfo.device_role = uwb::DeviceRole::INITIATOR;
         profInfo.device_type = uwb::DeviceType::CONTROLLER;
         profInfo.mac_addr[0] = macAddress().get(0);
@@ -207,7 +348,7 @@ public:
         //Serial.println("data len:");
         //Serial.println(dataLen);
         //UWBHAL.Log_D("incoming shareable data len: %hhu", dataLen);
-        std::vector<uint8_t> shareData(data, data+dataLen);
+        std::vector<uint8_t> shareData(shareable.data, shareable.data + shareable.len);
         
         uwb::ProfileConfig profileCfg;
         profileCfg.sharable_data = shareData;
@@ -223,50 +364,46 @@ public:
         //profileCfg.debug_configs = {};
         //UWBHAL.Log_MAU8_I("mac addr :", profileInfo.mac_addr, 2);
         uwb_status=UWBHAL.configureDevice_iOS(profileCfg);
-        if (uwb_status != uwb::Status::SUCCESS)
+        /* If the status if HPD wake up then try to do it one more time */
+        if (uwb::Status::HPDWKUP == uwb_status)
         {
-            UWBHAL.Log_E("Shareable data not configured");
-            /* If the status if HPD wake up then try to do it one more time */
-            if (uwb::Status::HPDWKUP == uwb_status)
-            {
-                UWBHAL.Log_W("Device woke up from HPD");
-                UWBHAL.setDefaultCoreConfigs();
-                //uwb_status = UWBHAL.configIOSData(data + 1, *(data + SHAREABLE_DATA_LENGTH_OFFSET) + SHAREABLE_DATA_HEADER_LENGTH, &profileInfo, 0, NULL, 0, NULL);
-                uwb_status=UWBHAL.configureDevice_iOS(profileCfg);
-                
-                if (uwb_status != uwb::Status::SUCCESS)
-                {
-                    UWBHAL.Log_E("Shareable data not configured");
-                    return uwb::Status::FAILED;
-                }
-            }
-            else
-            {
-                UWBHAL.Log_E("Shareable data not configured");
-            }
+            UWBHAL.Log_W("Device woke up from HPD");
+            UWBHAL.setDefaultCoreConfigs();
+            //uwb_status = UWBHAL.configIOSData(data + 1, *(data + SHAREABLE_DATA_LENGTH_OFFSET) + SHAREABLE_DATA_HEADER_LENGTH, &profileInfo, 0, NULL, 0, NULL);
+            uwb_status=UWBHAL.configureDevice_iOS(profileCfg);
         }
-        else
+        if (uwb_status != uwb::Status::SUCCESS)
         {
-            UWBHAL.Log_D("Shareable data configured");
-            UWBHAL.Log_D("session handle: %d", profileCfg.profile_info.session_handle);
-            //sessionHandle(profileCfg.profile_info.session_handle);
-            sessionID(profileCfg.profile_info.session_handle);
-            sessionState(Started);
+            UWBHAL.Log_E("Shareable data not configured");
+            return uwb::Status::FAILED;
         }
+
+        UWBHAL.Log_D("Shareable data configured");
+        UWBHAL.Log_D("session handle: %d", profileCfg.profile_info.session_handle);
+        //sessionHandle(profileCfg.profile_info.session_handle);
+        sessionID(profileCfg.profile_info.session_handle);
+        sessionState(Started);
+        acceptParams(shareable);
         return uwb::Status::SUCCESS;
     }
 
-    uint8_t configAndroid(void)
+    /**
+     * @brief build the Initialize response for an Android phone
+     *
+     * @param cache device configuration, the chip is only read on a miss
+     * @param resumeMac MAC address to give again to a returning phone
+     */
+    uint8_t configAndroid(NearbyConfigCache &cache, const uint8_t *resumeMac = nullptr)
     {
+        uint32_t t0 = micros();
         deviceType(Android);
         uwb::DeviceConfig cfgAndroid;
         /* UWB related definitions */
-        uwb_status = UWBHAL.getUwbConfigData_Android(cfgAndroid);
+        uwb_status = cache.android(cfgAndroid);
         if (uwb_status != uwb::Status::SUCCESS)
-        {
-            UWBHAL.Log_E("GetUwbConfigData configuration failed");
             return uwb_status;
-        }
+        if (resumeMac)
+            memcpy(cfgAndroid.device_mac_addr, resumeMac, 2);
     
         /* Store generated own device UWB MAC address */
         UWBMacAddress uMac;
@@ -276,8 +413,40 @@ public:
         dataLen = UWBHAL.serializeDeviceConfigData(&BLEmessage_Android[1],cfgAndroid);
         BLEmessage_Android[0] = kRsp_InitializedData; /* Response ID */
         dataLen = (uint16_t)(dataLen + 1);
+        times.configUs = micros() - t0;
+        times.configCached = cache.lastHit();
         return uwb_status;
     }
+    /**
+     * @brief restart a session parked in NearbyResumeCache, configured with
+     * the same parameters
+     *
+     * @param handle session handle returned by NearbyResumeCache::resume()
+     * @param params the phone's ConfigureAndStart parameters
+     */
+    uint8_t resume(uint32_t handle, NearbySpan params)
+    {
+        sessionID(handle);
+        uwb_status = start();
+        if (uwb_status != uwb::Status::SUCCESS)
+        {
+            UWBHAL.Log_E("Session %04X not restarted: %d", handle, uwb_status);
+            // nobody else knows about it anymore
+            deInit();
+            sessionID(0);
+            return uwb_status;
+        }
+        UWBHAL.Log_I("Session %04X resumed", handle);
+        sessionState(Started);
+        acceptParams(params);
+        return uwb::Status::SUCCESS;
+    }
+
+    /**
+     * @brief parameters of the last ConfigureAndStart the session started with
+     */
+    NearbySpan acceptedParams(void) { return NearbySpan(accepted, acceptedLen); }
+
     bool shouldUpdateAccessory(void)
     {
         return (UserConfigData_iOS.uwb_config_data.spec_version_minor[0] == 0x01) && (UserConfigData_iOS.uwb_config_data.spec_version_minor[1] == 0x00);
@@ -298,10 +467,73 @@ public:
         return nullptr;
     }
 
+    /**
+     * @brief handshake timing, the manager records the steps it drives
+     *
+     */
+    const Handshake &handshake(void) const { return times; }
+    uint32_t sinceConnected(void) const { return millis() - times.connectedMs; }
+    void configSent(void) { times.configuredMs = sinceConnected(); }
+    void startTimed(uint32_t us) { times.startUs = us; }
+    void starting(void)
+    {
+        times.activeMs = 0;
+        times.firstRangeMs = 0;
+        ranged = false;
+    }
+    void started(bool resumed = false)
+    {
+        times.startedMs = sinceConnected();
+        times.resumed = resumed;
+    }
+    void activated(void) { times.activeMs = sinceConnected(); }
+
+    /**
+     * @brief note a ranging notification, called from the UWB notification
+     * context: only the first one is timed, by firstRange()
+     */
+    void rangeReceived(void)
+    {
+        if (!ranged)
+        {
+            rangedAt = millis();
+            ranged = true;
+        }
+    }
+    /**
+     * @brief latest measurement, for NearbyRangingRelay
+     */
+    NearbyRangeSlot &rangeSlot(void) { return slot; }
+
+    bool firstRange(void)
+    {
+        if (!ranged || times.firstRangeMs)
+            return false;
+        times.firstRangeMs = rangedAt - times.connectedMs;
+        if (!times.firstRangeMs)
+            times.firstRangeMs = 1;
+        return true;
+    }
+
 private:
     BLEDevice bleDev;
+    UWBMacKey bleAddr;
     DeviceType devType;
     SessionState sessState;
+    volatile uwb::SessionStatus sessStatus;
+    uint32_t stopDeadline;
+    uint8_t stopTries;
+    bool stopAccepted;
+    bool release;
+    uint8_t rxMessage[NEARBY_MESSAGE_SIZE];
+    uint8_t rxLen;
+    uint32_t queuedAt;
+    Handshake times;
+    volatile bool ranged;
+    volatile uint32_t rangedAt;
+    NearbyRangeSlot slot;
+    uint8_t accepted[NEARBY_MESSAGE_SIZE];
+    uint8_t acceptedLen;
     UWBMacAddress macAddr;
     
     struct uwb::ProfileInfo profileInfo;
@@ -310,6 +542,12 @@ private:
     //UwbDeviceConfigData_t UwbDeviceConfigData = { 0 };
     uint8_t BLEmessage_iOS[1 + 37];
     uint8_t BLEmessage_Android[1 + 18];
+
+    void acceptParams(NearbySpan params)
+    {
+        acceptedLen = params.len <= sizeof(accepted) ? params.len : 0;
+        memcpy(accepted, params.data, acceptedLen);
+    }
     uint16_t dataLen;
     uwb::Status uwb_status;
    
@@ -4,19 +4,31 @@
 #include "UWBAppParamList.hpp"
 #include "NearbySessionManager.hpp"
 
-NearbySessionManager::NearbySessionManager() {
+NearbySessionManager::NearbySessionManager()
+    : handshaking(nullptr), handshakeSince(0), nextRelay(0), bleInitialized(false), nextCommand(0) {
    // SEMAPHORE_CREATE();
+   resetReport();
 }
 
 void NearbySessionManager::blePeripheralConnectHandler(BLEDevice central)
 {
     // central connected event handler
+    NearbySessionManager &manager = NearbySessionManager::instance();
 
     NearbySession newSession(central);
-    NearbySessionManager::instance().addSession(newSession);
-    if (NearbySessionManager::instance().clientConnectionHandler)
+    if (!manager.addSession(newSession))
+    {
+        UWBHAL.Log_W("No room for another phone (%d max), disconnecting", manager.limits().phones);
+        manager.stats.refused++;
+        central.disconnect();
+        return;
+    }
+    manager.stats.phones++;
+    if (manager.stats.phones > manager.stats.peakPhones)
+        manager.stats.peakPhones = manager.stats.phones;
 
-        NearbySessionManager::instance().clientConnectionHandler(central);
+    if (manager.clientConnectionHandler)
+        manager.clientConnectionHandler(central);
 }
 
 void NearbySessionManager::onConnect(BLEDeviceEventHandler connectHandler)
@@ -50,212 +62,548 @@ void NearbySessionManager::blePeripheralDisconnectHandler(BLEDevice central)
     
     if (NearbySessionManager::instance().clientDisconnectionHandler)
         NearbySessionManager::instance().clientDisconnectionHandler(central);
-    
-    NearbySessionManager::instance().deleteSession(NearbySessionManager::instance().find(central).sessionID());
+
+    NearbySession *nearbySession = NearbySessionManager::instance().find(central);
+    if (nearbySession == nullptr)
+        return;
+    NearbySessionManager::instance().stats.phones--;
+    // whatever the phone asked last does not matter anymore
+    nearbySession->commandDone();
+    NearbySessionManager::instance().releaseHandshake(*nearbySession);
+    if (nearbySession->sessionState() == Started || nearbySession->sessionState() == Stopping)
+    {
+        // stop in the background, poll() releases the session when done
+        nearbySession->releaseOnStop(true);
+        NearbySessionManager::instance().stopSession(nearbySession, central);
+    }
+    else
+        NearbySessionManager::instance().removeSession(*nearbySession);
 
 }
 
 void NearbySessionManager::rxCharacteristicWritten(BLEDevice central, BLECharacteristic characteristic)
 {
 
-    NearbySessionManager::instance().handleTLV(central, (uint8_t *)characteristic.value());
+    NearbySessionManager::instance().handleTLV(central, characteristic.value(), characteristic.valueLength());
 }
 
 bool NearbySessionManager::handleStopSession(BLEDevice bleDev)
 {
-    bool status = true;
-    uwb::Status operation = uwb::Status::SUCCESS;
-    NearbySession &nearbySession = NearbySessionManager::instance().find(bleDev);
-   // SEMAPHORE_TAKE();
-    delay(2000);
-    while (nearbySession.sessionState() != notCreated)
+    return stopSession(find(bleDev), bleDev);
+}
+
+bool NearbySessionManager::stopSession(NearbySession *nearbySession, BLEDevice bleDev)
+{
+    if (nearbySession == nullptr)
     {
-        switch (nearbySession.sessionState())
-        {
-        case notStarted:
-            UWBHAL.Log_D("Deleting session: %04X", nearbySession.sessionID());
-            nearbySession.stop();
-            operation = nearbySession.deInit();
+        if (sessionStoppedHandler != nullptr)
+            sessionStoppedHandler(bleDev);
+        return true;
+    }
 
-            if (operation == uwb::Status::SUCCESS || operation == uwb::Status::SESSION_NOT_EXIST)
-            {
-                nearbySession.sessionState(notCreated);
-                status = true;
-            }
-            else
-            {
-                status = false;
-            }
-            //delay(2000);
-            break;
-        case Started:
-            UWBHAL.Log_D("Stopping session: %04X", nearbySession.sessionID());
-            operation = nearbySession.stop();
-            UWBHAL.Log_D("Stopped session with status: %04X", operation);
+    switch (nearbySession->sessionState())
+    {
+    case Started:
+    {
+        UWBHAL.Log_D("Stopping session: %04X", nearbySession->sessionID());
+        nearbySession->resetStop();
+        uwb::Status operation = nearbySession->beginStop();
+        UWBHAL.Log_D("Stopped session with status: %04X", operation);
+        return nearbySession->stopAcknowledged();
+    }
+    case notStarted:
+        // nothing is ranging, release the session right away
+        return finishStop(*nearbySession);
 
-            if (operation == uwb::Status::SUCCESS || operation == uwb::Status::SESSION_NOT_EXIST)
-            {
-                nearbySession.sessionState(notStarted);
-                status = true;
-            }
-            else
-            {
-                status = false;
-            }
-            break;
-            
-        default:
-            UWBHAL.Log_E("Stop session wrong state: %d", nearbySession.sessionState());
+    case Stopping:
+        // already in progress, poll() completes it
+        return true;
+
+    case notCreated:
+        if (sessionStoppedHandler != nullptr)
+            sessionStoppedHandler(bleDev);
+        return true;
+
+    default:
+        UWBHAL.Log_E("Stop session wrong state: %d", nearbySession->sessionState());
+        return false;
+    }
+}
+
+bool NearbySessionManager::finishStop(NearbySession &nearbySession)
+{
+    bool status = true;
+
+    if (nearbySession.releaseOnStop() && nearbySession.stopConfirmed() && !nearbySession.acceptedParams().empty())
+    {
+        // the phone went away, keep the session configured in case it comes back
+        uint8_t mac[2] = {nearbySession.macAddress().get(0), nearbySession.macAddress().get(1)};
+        parked.park(nearbySession.bleKey(), nearbySession.deviceType(), mac, nearbySession.sessionID(),
+                    nearbySession.acceptedParams());
+    }
+    else if (nearbySession.sessionID() != 0)    // 0: the phone's start never created one
+    {
+        UWBHAL.Log_D("Deleting session: %04X", nearbySession.sessionID());
+        uwb::Status operation = nearbySession.deInit();
+        if (operation != uwb::Status::SUCCESS && operation != uwb::Status::SESSION_NOT_EXIST)
+        {
+            UWBHAL.Log_E("Session %04X deinit failed: %d", nearbySession.sessionID(), operation);
             status = false;
-            break;
         }
     }
-   // SEMAPHORE_GIVE();
+    // give up on the session either way, the stack drops it on the next reset
+    nearbySession.sessionID(0);
+    nearbySession.sessionState(notCreated);
+    nearbySession.resetStop();
+
     if (sessionStoppedHandler != nullptr)
-        sessionStoppedHandler(bleDev);
+        sessionStoppedHandler(nearbySession.bleDevice());
     return status;
 }
 
-void NearbySessionManager::handleTLV(BLEDevice bleDev, uint8_t *data)
+void NearbySessionManager::serviceSessions(void)
 {
-    uwb::Status uwb_status = uwb::Status::FAILED;
-
-    uint8_t response;
-
-    if (data == NULL)
+    for (int i = 0; i < numSessions; i++)
     {
-        UWBHAL.Log_W("handleTLV data is NULL");
-    }
-    NearbySession &nearbySession = NearbySessionManager::instance().find(bleDev);
+        NearbySession &nearbySession = *(NearbySession *)sessions[i];
 
-    // TODO check if object is valid
+        if (nearbySession.sessionState() == Started)
+        {
+            if (nearbySession.handshake().activeMs == 0 && nearbySession.sessionStatus() == uwb::SessionStatus::ACTIVE)
+                nearbySession.activated();
+            if (nearbySession.firstRange())
+                firstRange(nearbySession);
+        }
 
-    switch (data[0])
-    {
-    case kMsg_ConfigureAndStart:
-    {
-        nearbySession.sessionState(notStarted);
-        if (nearbySession.deviceType() == Android)
+        if (nearbySession.sessionState() == Stopping)
         {
-            if (nearbySession.startAndroid(data) == uwb::Status::SUCCESS)
-            {
-                response = kRsp_UwbDidStart;
-                txCharacteristic.writeValue(&response, sizeof(response));
-            }
-            else
+            if (nearbySession.stopConfirmed())
             {
-                UWBHAL.Log_E("Could not start Android Nearby Session");
+                finishStop(nearbySession);
             }
+            else if (nearbySession.stopExpired())
             {
-                response = kRsp_UwbDidStart;
-                txCharacteristic.writeValue(&response, sizeof(response));
+                if (!nearbySession.stopAcknowledged() && nearbySession.stopAttempts() < NEARBY_STOP_MAX_ATTEMPTS)
+                {
+                    UWBHAL.Log_W("Retrying stop of session: %04X", nearbySession.sessionID());
+                    nearbySession.beginStop();
+                }
+                else
+                {
+                    // accepted but never notified idle, or out of retries
+                    UWBHAL.Log_W("Session %04X stop timed out", nearbySession.sessionID());
+                    finishStop(nearbySession);
+                }
             }
         }
-        else if (nearbySession.deviceType() == iOS)
+
+        if (nearbySession.sessionState() == notCreated && nearbySession.releaseOnStop())
         {
-            /* Fill-in input structure with device role/type and device mac address*/
-            UWBHAL.Log_Array_D("shareable data", data,30);
+            // removeSession() compacts the array, revisit this index
+            removeSession(nearbySession);
+            i--;
+        }
+    }
+    parked.expire();
+}
 
-            if (nearbySession.startIOS(data) == uwb::Status::SUCCESS)
-            {
-                response = kRsp_UwbDidStart;
-                txCharacteristic.writeValue(&response, sizeof(response));
-                if (nearbySession.shouldUpdateAccessory())
-                {
-                    const uint8_t tmpData[50] = {0};
-                    accessoryConfigDataChar.writeValue(tmpData, 50);//neds to be fixed
-                }
-            }
-            else
+void NearbySessionManager::rangingData(const uwb::RangingResult &result)
+{
+    // poll() may be removing a session, see removeSession()
+    noInterrupts();
+    for (int i = 0; i < numSessions; i++)
+    {
+        NearbySession *nearbySession = (NearbySession *)sessions[i];
+        if (nearbySession->sessionState() == Started && nearbySession->sessionID() == result.session_handle)
+        {
+            nearbySession->rangeReceived();
+            // one phone per session, its measurement comes first
+            const uwb::twr_mesr &twr = result.measurements.twr[0];
+            if (relay.isEnabled() && result.no_of_measurements > 0 && twr.status == 0)
             {
-                UWBHAL.Log_E("Could not start IOS Nearby Session");
+                NearbyRangeSample sample;
+                sample.seq = result.sequence_number;
+                sample.distance = twr.distance;
+                sample.azimuth = twr.aoa_azimuth;
+                sample.elevation = twr.aoa_elevation;
+                nearbySession->rangeSlot().put(sample);
             }
+            break;
         }
-        else
+    }
+    interrupts();
+}
+
+void NearbySessionManager::sessionInfo(const uwb::SessionInfo &info)
+{
+    // poll() may be removing a session, see removeSession()
+    noInterrupts();
+    for (int i = 0; i < numSessions; i++)
+    {
+        NearbySession *nearbySession = (NearbySession *)sessions[i];
+        if (nearbySession->sessionState() != notCreated && nearbySession->sessionID() == info.sessionHandle)
         {
-            uwb_status = uwb::Status::FAILED; // Unknown platform detected
-            UWBHAL.Log_E("Unknown platform detected");
+            nearbySession->sessionStatus((uwb::SessionStatus)info.state);
+            break;
         }
     }
-    break;
+    interrupts();
+}
+
+const NearbySessionManager::Command NearbySessionManager::commands[] = {
+    {kMsg_Initialize_iOS, 1, "Initialize iOS", &NearbySessionManager::initializeIOS},
+    {kMsg_Initialize_Android, 1, "Initialize Android", &NearbySessionManager::initializeAndroid},
+    {kMsg_ConfigureAndStart, 1, "ConfigureAndStart", &NearbySessionManager::configureAndStart},
+    {kMsg_Stop, 1, "Stop", &NearbySessionManager::stopCommand},
+};
+
+void NearbySessionManager::handleTLV(BLEDevice bleDev, const uint8_t *data, size_t len)
+{
+    NearbySpan msg(data, len);
+    if (msg.empty())
+    {
+        UWBHAL.Log_W("handleTLV empty message");
+        return;
+    }
 
-    case kMsg_Initialize_iOS:
+    const Command *cmd = command(msg.data[0]);
+    if (cmd == nullptr)
+    {
+        UWBHAL.Log_W("Unknown command %02X, skipping", msg.data[0]);
+        return;
+    }
+    if (msg.len < cmd->minLength)
+    {
+        UWBHAL.Log_W("%s: %d bytes, too short", cmd->name, msg.len);
+        return;
+    }
+
+    NearbySession *nearbySession = find(bleDev);
+    if (nearbySession == nullptr)
+    {
+        UWBHAL.Log_W("%s from a device without session", cmd->name);
+        return;
+    }
+    if ((cmd->id == kMsg_Initialize_iOS || cmd->id == kMsg_Initialize_Android) && !claimHandshake(*nearbySession))
+    {
+        // it would get the other phone's accessory configuration
+        UWBHAL.Log_W("%s while another phone is configuring, disconnecting", cmd->name);
+        stats.refused++;
+        bleDev.disconnect();
+        return;
+    }
+    // executed by poll(), out of the BLE callback
+    if (!nearbySession->queueCommand(msg))
     {
-        /* Start command received
-         * Fill the ConfigData and send it over BLE to the phone application
-         */
+        UWBHAL.Log_W("%s dropped, previous command still waiting", cmd->name);
+        stats.busy++;
+    }
+}
+
+bool NearbySessionManager::claimHandshake(NearbySession &nearbySession)
+{
+    if (handshaking && handshaking != &nearbySession && millis() - handshakeSince < NEARBY_HANDSHAKE_TIMEOUT_MS)
+        return false;
+    handshaking = &nearbySession;
+    handshakeSince = millis();
+    return true;
+}
+
+void NearbySessionManager::releaseHandshake(NearbySession &nearbySession)
+{
+    if (handshaking == &nearbySession)
+        handshaking = nullptr;
+}
 
-        if (nearbySession.configIOS() == uwb::Status::SUCCESS)
+const NearbySessionManager::Command *NearbySessionManager::command(uint8_t id)
+{
+    for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++)
+    {
+        if (commands[i].id == id)
+            return &commands[i];
+    }
+    return nullptr;
+}
+
+void NearbySessionManager::serviceRelay(void)
+{
+    if (!numSessions || !relay.begin(millis()))
+        return;
+
+    // latest measurement of each session, starting after the last one that fit
+    int n = 0;
+    for (; n < numSessions && relay.room(); n++)
+    {
+        NearbySession &nearbySession = *(NearbySession *)sessions[(nextRelay + n) % numSessions];
+        NearbyRangeSample sample;
+        if (nearbySession.sessionState() != Started || !nearbySession.rangeSlot().take(sample))
+            continue;
+        uint8_t mac[2] = {nearbySession.macAddress().get(0), nearbySession.macAddress().get(1)};
+        relay.add(mac, sample);
+        relay.conflated(nearbySession.rangeSlot().takeConflated());
+    }
+    nextRelay = (nextRelay + n) % numSessions;
+
+    if (!relay.ready())
+        return;
+    respond(relay.message());
+    relay.sent(millis());
+}
+
+void NearbySessionManager::serviceCommands(void)
+{
+    // one command per poll(), starting after the session served last
+    for (int n = 0; n < numSessions; n++)
+    {
+        int i = (nextCommand + n) % numSessions;
+        NearbySession &nearbySession = *(NearbySession *)sessions[i];
+        if (!nearbySession.commandPending())
+            continue;
+        nextCommand = i + 1;
+
+        NearbySpan msg = nearbySession.pendingCommand();
+        uint32_t wait = millis() - nearbySession.commandQueuedAt();
+        uint32_t start = micros();
+        (this->*command(msg.data[0])->handle)(nearbySession.bleDevice(), nearbySession, msg);
+        uint32_t elapsed = micros() - start;
+        nearbySession.commandDone();
+
+        stats.commands++;
+        if (wait > stats.maxWaitMs)
+            stats.maxWaitMs = wait;
+        if (elapsed > stats.maxCommandUs)
+            stats.maxCommandUs = elapsed;
+        return;
+    }
+}
+
+NearbySessionManager::Limits NearbySessionManager::limits(void) const
+{
+    Limits lim;
+    lim.uwbSessions = maxSessions;
+    lim.bleLinks = NEARBY_MAX_BLE_LINKS;
+    lim.phones = lim.uwbSessions < lim.bleLinks ? lim.uwbSessions : lim.bleLinks;
+    if (lim.phones > NEARBY_MAX_PHONES)
+        lim.phones = NEARBY_MAX_PHONES;
+    return lim;
+}
+
+void NearbySessionManager::resetReport(void)
+{
+    uint8_t phones = stats.phones;
+    memset(&stats, 0, sizeof(stats));
+    stats.phones = phones;
+    stats.peakPhones = phones;
+}
+
+void NearbySessionManager::printReport(void) const
+{
+    const NearbySession::Handshake &hs = stats.lastHandshake;
+    UWBHAL.Log_I("nearby: %d phones (peak %d of %d), %lu refused", stats.phones, stats.peakPhones, limits().phones, stats.refused);
+    UWBHAL.Log_I("  %lu commands, %lu dropped busy, longest wait %lu ms, longest command %lu us",
+                 stats.commands, stats.busy, stats.maxWaitMs, stats.maxCommandUs);
+    UWBHAL.Log_I("  last handshake: config sent %lu ms, started %lu ms, first range %lu ms after connection",
+                 hs.configuredMs, hs.startedMs, hs.firstRangeMs);
+    UWBHAL.Log_I("  first range: %lu cold, avg %lu ms, max %lu ms; %lu resumed, avg %lu ms, max %lu ms",
+                 stats.coldRanging, stats.coldRanging ? stats.coldRangeMs / stats.coldRanging : 0, stats.maxColdRangeMs,
+                 stats.resumedRanging, stats.resumedRanging ? stats.resumedRangeMs / stats.resumedRanging : 0,
+                 stats.maxResumedRangeMs);
+    cache.printReport();
+    parked.printReport();
+    relay.printReport();
+}
+
+void NearbySessionManager::firstRange(NearbySession &nearbySession)
+{
+    const NearbySession::Handshake &hs = nearbySession.handshake();
+    stats.lastHandshake = hs;
+    if (hs.resumed)
+    {
+        stats.resumedRanging++;
+        stats.resumedRangeMs += hs.firstRangeMs;
+        if (hs.firstRangeMs > stats.maxResumedRangeMs)
+            stats.maxResumedRangeMs = hs.firstRangeMs;
+    }
+    else
+    {
+        stats.coldRanging++;
+        stats.coldRangeMs += hs.firstRangeMs;
+        if (hs.firstRangeMs > stats.maxColdRangeMs)
+            stats.maxColdRangeMs = hs.firstRangeMs;
+    }
+
+    UWBHAL.Log_I("Session %04X first range %lu ms after connection (%s)", nearbySession.sessionID(), hs.firstRangeMs,
+                 hs.resumed ? "resumed" : "cold");
+    UWBHAL.Log_I("  config %lu us (%s), sent at %lu ms, start %lu us, started at %lu ms, active at %lu ms",
+                 hs.configUs, hs.configCached ? "cached" : "chip", hs.configuredMs, hs.startUs, hs.startedMs, hs.activeMs);
+}
+
+void NearbySessionManager::respond(const NearbyWriter &writer)
+{
+    if (writer.overflow())
+    {
+        UWBHAL.Log_E("Response larger than %d bytes, not sent", NEARBY_MESSAGE_SIZE);
+        return;
+    }
+    txCharacteristic.writeValue(writer.data(), writer.length());
+}
+
+void NearbySessionManager::configureAndStart(BLEDevice bleDev, NearbySession &nearbySession, NearbySpan msg)
+{
+    NearbyWriter rsp = response();
+
+    // done with the accessory configuration, started or not
+    releaseHandshake(nearbySession);
+
+    nearbySession.sessionState(notStarted);
+    if (nearbySession.deviceType() == Android)
+    {
+        NearbySpan config;
+        if (!NearbyMessage::configAndroid(msg, config))
+            UWBHAL.Log_E("ConfigureAndStart: %d bytes, Android configuration missing", msg.len);
+        else
         {
-            uint8_t *BLEmessage_iOS = nearbySession.config();
-            for (int jj=0; jj < 1 + nearbySession.configLen(); jj++)
-            {
-                if(BLEmessage_iOS[jj]<0x10)
-                    Serial.print("0");
-                Serial.print(BLEmessage_iOS[jj], HEX);
-            }
-            Serial.print("\n");
-            if (nearbySession.shouldUpdateAccessory())
-            {
-                UWBHAL.Log_I(" Following spec: 1.1");
-                /* Spec 1.1 required to update GATT server
-                Update the GATT server with the same BLEmessage (only removing Response ID that is not part of the original definition) */
-                accessoryConfigDataChar.writeValue(BLEmessage_iOS + 1, nearbySession.configLen() - 1);
-
-                /* Need to send the exact data over ble */
-                
-                txCharacteristic.writeValue(BLEmessage_iOS, nearbySession.configLen());
-            }
+            nearbySession.starting();
+            uint32_t t0 = micros();
+            bool resumed = resumeSession(nearbySession, config);
+            uint8_t status = resumed ? (uint8_t)uwb::Status::SUCCESS : nearbySession.startAndroid(config);
+            nearbySession.startTimed(micros() - t0);
+            if (status != uwb::Status::SUCCESS)
+                UWBHAL.Log_E("Could not start Android Nearby Session");
             else
             {
-                UWBHAL.Log_I(" Following spec 1.0");
-                /* Spec 1.0 support, clock drift not sent over BLE. BLE message size must  */
-                txCharacteristic.writeValue(BLEmessage_iOS, nearbySession.configLen());
+                nearbySession.started(resumed);
+                if (sessionStartedHandler != nullptr)
+                    sessionStartedHandler(bleDev);
             }
         }
+        // Android expects the answer either way
+        rsp.put(kRsp_UwbDidStart);
+        respond(rsp);
     }
-    break;
-
-    case kMsg_Initialize_Android:
+    else if (nearbySession.deviceType() == iOS)
     {
-
-        if (nearbySession.configAndroid() == uwb::Status::SUCCESS)
+        NearbySpan shareable;
+        if (!NearbyMessage::shareableIOS(msg, shareable))
         {
-            uint8_t *BLEmessage_Android = nearbySession.config();
-
-            /* Need to send the exact data from ConfigData  over ble */
-            txCharacteristic.writeValue(BLEmessage_Android, nearbySession.configLen());
+            UWBHAL.Log_E("ConfigureAndStart: %d bytes, shareable data truncated", msg.len);
+            return;
         }
-        else
-            UWBHAL.Log_E("Android config fail");
-    }
-    break;
-
-    case kMsg_Stop:
-        /* Stop command received
-         * Stop UWB and send back the response to the phone
-         */
-        UWBHAL.Log_I("Received stop message");
-        if (!NearbySessionManager::instance().handleStopSession(bleDev))
+        /* Fill-in input structure with device role/type and device mac address*/
+        UWBHAL.Log_Array_D("shareable data", shareable.data, shareable.len);
+
+        nearbySession.starting();
+        uint32_t t0 = micros();
+        bool resumed = resumeSession(nearbySession, shareable);
+        uint8_t status = resumed ? (uint8_t)uwb::Status::SUCCESS : nearbySession.startIOS(shareable);
+        nearbySession.startTimed(micros() - t0);
+        if (status == uwb::Status::SUCCESS)
         {
-            UWBHAL.Log_E("Stop session failed");
+            nearbySession.started(resumed);
+            rsp.put(kRsp_UwbDidStart);
+            respond(rsp);
+            if (sessionStartedHandler != nullptr)
+                sessionStartedHandler(bleDev);
+            if (nearbySession.shouldUpdateAccessory())
+            {
+                static const uint8_t tmpData[50] = {0};
+                accessoryConfigDataChar.writeValue(tmpData, sizeof(tmpData));//neds to be fixed
+            }
         }
         else
         {
-            uwb_status = uwb::Status::SUCCESS;
+            UWBHAL.Log_E("Could not start IOS Nearby Session");
         }
-        response = kRsp_UwbDidStop;
-        txCharacteristic.writeValue(&response, sizeof(response));
+    }
+    else
+    {
+        UWBHAL.Log_E("Unknown platform detected");
+    }
+}
 
-        break;
+bool NearbySessionManager::resumeSession(NearbySession &nearbySession, NearbySpan params)
+{
+    uint8_t mac[2] = {nearbySession.macAddress().get(0), nearbySession.macAddress().get(1)};
+    uint32_t handle;
+    if (!parked.resume(nearbySession.bleKey(), nearbySession.deviceType(), mac, params, handle))
+        return false;
+    // if it does not start after all, configure a new one
+    return nearbySession.resume(handle, params) == uwb::Status::SUCCESS;
+}
 
-    default:
-        UWBHAL.Log_W("Unknown command, skipping");
-        break;
+void NearbySessionManager::initializeIOS(BLEDevice bleDev, NearbySession &nearbySession, NearbySpan msg)
+{
+    (void)bleDev;
+    (void)msg;
+
+    /* Start command received
+     * Fill the ConfigData and send it over BLE to the phone application
+     */
+    // a returning phone gets the address its parked session was configured with
+    uint8_t mac[2];
+    bool known = parked.mac(nearbySession.bleKey(), iOS, mac);
+    if (nearbySession.configIOS(cache, known ? mac : nullptr) != uwb::Status::SUCCESS)
+        return;
+
+    const uint8_t *BLEmessage_iOS = nearbySession.config();
+    UWBHAL.Log_Array_D("accessory config", BLEmessage_iOS, nearbySession.configLen());
+    if (nearbySession.shouldUpdateAccessory())
+    {
+        UWBHAL.Log_I(" Following spec: 1.1");
+        /* Spec 1.1 required to update GATT server
+        Update the GATT server with the same BLEmessage (only removing Response ID that is not part of the original definition) */
+        accessoryConfigDataChar.writeValue(BLEmessage_iOS + 1, nearbySession.configLen() - 1);
+    }
+    else
+    {
+        /* Spec 1.0 support, clock drift not sent over BLE */
+        UWBHAL.Log_I(" Following spec 1.0");
     }
 
+    /* Need to send the exact data over ble */
+    NearbyWriter rsp = response();
+    rsp.put(BLEmessage_iOS, nearbySession.configLen());
+    respond(rsp);
+    nearbySession.configSent();
+}
+
+void NearbySessionManager::initializeAndroid(BLEDevice bleDev, NearbySession &nearbySession, NearbySpan msg)
+{
+    (void)bleDev;
+    (void)msg;
 
+    uint8_t mac[2];
+    bool known = parked.mac(nearbySession.bleKey(), Android, mac);
+    if (nearbySession.configAndroid(cache, known ? mac : nullptr) != uwb::Status::SUCCESS)
+    {
+        UWBHAL.Log_E("Android config fail");
+        return;
+    }
+
+    /* Need to send the exact data from ConfigData  over ble */
+    NearbyWriter rsp = response();
+    rsp.put(nearbySession.config(), nearbySession.configLen());
+    respond(rsp);
+    nearbySession.configSent();
+}
+
+void NearbySessionManager::stopCommand(BLEDevice bleDev, NearbySession &nearbySession, NearbySpan msg)
+{
+    (void)msg;
+
+    /* Stop command received
+     * Stop UWB and send back the response to the phone
+     */
+    UWBHAL.Log_I("Received stop message");
+    releaseHandshake(nearbySession);
+    if (!stopSession(&nearbySession, bleDev))
+        UWBHAL.Log_E("Stop session failed");
+
+    NearbyWriter rsp = response();
+    rsp.put(kRsp_UwbDidStop);
+    respond(rsp);
 }
+
 void NearbySessionManager::begin(String deviceName)
 {
 
@@ -283,6 +631,9 @@ void NearbySessionManager::begin(String deviceName)
     BLE.setEventHandler(BLEConnected, blePeripheralConnectHandler);
     BLE.setEventHandler(BLEDisconnected, blePeripheralDisconnectHandler);
     rxCharacteristic.setEventHandler(BLEWritten, rxCharacteristicWritten);
+
+    Limits lim = limits();
+    UWBHAL.Log_I("nearby: up to %d phones (%d UWB sessions, %d BLE links)", lim.phones, lim.uwbSessions, lim.bleLinks);
     // set the local name peripheral advertises
     BLE.setLocalName(deviceName.c_str());
     BLE.setDeviceName(deviceName.c_str());
@@ -296,39 +647,76 @@ void NearbySessionManager::poll(void)
         bleInitialized = true;
     }
     BLE.poll();
-
+    serviceCommands();
+    serviceSessions();
+    serviceRelay();
 }
 
-NearbySession &NearbySessionManager::find(BLEDevice dev) 
+NearbySession *NearbySessionManager::find(BLEDevice dev) 
 {
-    NearbySession *tempSession;
-    for (int i = 0; i < numSessions; i++)
-    {
-
-        tempSession = (NearbySession *)sessions[i];
+    return find(NearbySession::bleKey(dev));
+}
 
-        if (tempSession->bleAddress() == dev.address())
-        {
-            return *(NearbySession *)sessions[i];
-        }
-    }
-    return emptySession;
+NearbySession *NearbySessionManager::find(const UWBMacKey &bleKey)
+{
+    NearbySession **entry = index.find(bleKey);
+    return entry ? *entry : nullptr;
 }
 
 bool NearbySessionManager::addSession(NearbySession &sess)
 {
+    if (numSessions >= limits().phones)
+        return false;
+    // parked sessions give their UWB session to a phone that is here
+    while (numSessions + parked.count() >= limits().uwbSessions && parked.evictOldest())
+        ;
+
+    NearbySession **entry = index.insert(sess.bleKey());
+    if (entry == nullptr)
+        return false;
+
     NearbySession *newSess = new NearbySession();
     newSess->sessionID(sess.sessionID());
     newSess->sessionType(sess.sessionType());
     newSess->bleDevice(sess.bleDevice());
 
-    if (numSessions >= maxSessions)
-        return false;
-
+    *entry = newSess;
+    noInterrupts();
     sessions[numSessions++] = newSess; //&sess;
+    interrupts();
     return true;
 }
 
+void NearbySessionManager::removeSession(NearbySession &nearbySession)
+{
+    releaseHandshake(nearbySession);
+
+    // the entry may belong to a newer connection of the same phone
+    NearbySession **entry = index.find(nearbySession.bleKey());
+    if (entry && *entry == &nearbySession)
+        index.remove(nearbySession.bleKey());
+
+    // by address, Nearby sessions do not have an ID until configured.
+    // The notification callbacks walk sessions[] with interrupts off: once
+    // the entry is unlinked none of them can still hold it
+    NearbySession *removed = nullptr;
+    noInterrupts();
+    for (int i = 0; i < numSessions; i++)
+    {
+        if (sessions[i] == &nearbySession)
+        {
+            removed = (NearbySession *)sessions[i];
+            for (int j = i; j < numSessions - 1; j++)
+                sessions[j] = sessions[j + 1];
+            numSessions--;
+            sessions[numSessions] = nullptr;
+            break;
+        }
+    }
+    interrupts();
+    delete removed;
+}
+
 NearbySessionManager &NearbySessionManager::instance()
 {
     static NearbySessionManager instance;
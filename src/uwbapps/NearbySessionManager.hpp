@@ -8,9 +8,96 @@
 #include <ArduinoBLE.h>
 #include "UWBSessionManager.hpp"
 #include "NearbySession.hpp"
+#include "NearbyResumeCache.hpp"
 
+/* BLE connections the stack accepts (ArduinoBLE ATT_MAX_PEERS), define it
+   to match the core when it differs */
+#ifndef NEARBY_MAX_BLE_LINKS
+#define NEARBY_MAX_BLE_LINKS 5
+#endif
+
+/* phones served at once, 1 unless the phone apps tolerate the responses sent
+   to the other phones, see NearbySessionManager */
+#ifndef NEARBY_MAX_PHONES
+#define NEARBY_MAX_PHONES 1
+#endif
+
+/* a phone that sent Initialize holds the handshake until its ConfigureAndStart,
+   or at most this long */
+#define NEARBY_HANDSHAKE_TIMEOUT_MS 5000
+
+/**
+ * @brief Nearby Interaction with several phones at once
+ * 
+ * Every BLE connection gets its own NearbySession and state machine. The BLE
+ * callbacks only validate and queue the phone's command in its session, 
+ * poll() then executes one queued command per call, taking the sessions in
+ * turn, so no phone waits for more than one command of each other phone.
+ * The commands run synchronously in poll(): while the configureDevice_iOS()
+ * or configureDevice_Android() of one phone's ConfigureAndStart waits for
+ * the chip, the other phones, the ranging relay and the BLE stack wait too.
+ * 
+ * limits() gives the number of phones served at once, the lowest of the
+ * UWB sessions, the BLE links and NEARBY_MAX_PHONES; further connections
+ * are refused. 
+ * 
+ * The accessory configuration of the Initialize responses comes from a
+ * NearbyConfigCache, the chip is only read by the first phone; each
+ * session keeps the duration of its handshake steps, logged when the UWB
+ * stack reports the first range (NearbySession::Handshake).
+ * 
+ * The session of a phone that disconnects while ranging is parked in a
+ * NearbyResumeCache, to restart without a new configuration if the phone
+ * comes back with the same parameters. Parked sessions count against the
+ * UWB sessions: they are evicted to make room for a new phone.
+ * 
+ * With rangingRelay() enabled, the accessory's own measurements go back to
+ * the phones on the TX characteristic too, batched and rate capped, see
+ * NearbyRangingRelay.
+ * 
+ * The responses go through the shared TX characteristic, whose
+ * notifications ArduinoBLE sends to every subscribed phone: a phone also
+ * gets the responses of the others, their accessory configuration and
+ * their UwbDidStart and UwbDidStop included. NEARBY_MAX_PHONES is
+ * therefore 1 by default, define it higher only for phone apps that
+ * tolerate those. The handshakes are then taken one at a time: a phone
+ * that sends Initialize while another phone is between its Initialize and
+ * its ConfigureAndStart is disconnected, so that a phone waiting for its
+ * accessory configuration can only get its own.
+ */
 class NearbySessionManager : public UWBSessionManager_ {
 public:
+    /**
+     * @brief resources that bound the number of phones
+     * 
+     */
+    struct Limits {
+        uint8_t phones;         // served at once
+        uint8_t uwbSessions;
+        uint8_t bleLinks;
+    };
+
+    /**
+     * @brief statistics since the last resetReport()
+     * 
+     */
+    struct Report {
+        uint8_t phones;         // connected now
+        uint8_t peakPhones;
+        uint32_t refused;       // connections over the limits or during another handshake
+        uint32_t commands;      // executed
+        uint32_t busy;          // dropped, the previous one still waiting
+        uint32_t maxWaitMs;     // longest time a command waited in its queue
+        uint32_t maxCommandUs;  // longest command execution
+        NearbySession::Handshake lastHandshake;     // of the last session to range
+        uint32_t coldRanging;   // sessions configured with configureDevice
+        uint32_t coldRangeMs;   // total connection to first range time
+        uint32_t maxColdRangeMs;
+        uint32_t resumedRanging;    // sessions resumed from NearbyResumeCache
+        uint32_t resumedRangeMs;
+        uint32_t maxResumedRangeMs;
+    };
+
     NearbySessionManager();
 
     /**
@@ -42,19 +129,46 @@ public:
     /**
      * @brief internal method to handle a situation where the UWB session is being stopped
      * 
+     * Only issues the stop command: the session moves to the Stopping state
+     * and poll() completes the teardown once the UWB stack notifies the 
+     * session as idle, or after NEARBY_STOP_TIMEOUT_MS. Never blocks.
+     * 
      * @param bleDev 
-     * @return true 
-     * @return false 
+     * @return true if the stop was accepted (or nothing had to be stopped)
+     * @return false otherwise, poll() will retry
      */
     bool handleStopSession(BLEDevice bleDev);
 
+    /**
+     * @brief internal method fed with the session state notifications
+     * coming from the UWB stack (called from UWB notification context)
+     * 
+     * @param info 
+     */
+    void sessionInfo(const uwb::SessionInfo &info);
+
+    /**
+     * @brief internal method fed with the ranging notifications, times the
+     * first range of each session (called from UWB notification context)
+     * 
+     * @param result 
+     */
+    void rangingData(const uwb::RangingResult &result);
+
     /**
      * @brief internal method that handles the incoming commands sent by the phone
      * 
+     * The message ID selects an entry of the command table, messages shorter
+     * than the entry requires, of an unknown ID or from a device without a
+     * session are dropped. The others wait in the phone's session for poll(),
+     * whose handlers decode them in place, see NearbyMessage, and build their
+     * response in a preallocated buffer.
+     * 
      * @param bleDev 
      * @param data 
+     * @param len bytes written by the phone
      */
-    void handleTLV(BLEDevice bleDev, uint8_t *data);
+    void handleTLV(BLEDevice bleDev, const uint8_t *data, size_t len);
 
     /**
      * @brief start the BLE manager
@@ -64,18 +178,57 @@ public:
     void begin(String deviceName);
 
     /**
-     * @brief poll the BLE stack
+     * @brief poll the BLE stack and advance the session state machines
      * 
      */
     void poll(void);
 
+    /**
+     * @brief resources available to phones, also logged by begin()
+     * 
+     */
+    Limits limits(void) const;
+
+    const Report &report(void) const { return stats; }
+    void resetReport(void);
+    void printReport(void) const;
+
+    /**
+     * @brief accessory configuration served to the phones
+     * 
+     */
+    NearbyConfigCache &configCache(void) { return cache; }
+
+    /**
+     * @brief sessions of the phones that went away
+     * 
+     */
+    NearbyResumeCache &resumeCache(void) { return parked; }
+
+    /**
+     * @brief relay of the accessory's measurements to the phones, disabled
+     * until enabled
+     * 
+     */
+    NearbyRangingRelay &rangingRelay(void) { return relay; }
+
     /**
      * @brief find a session by BLEDevice
      * 
+     * Converts the device address once, see NearbySession::bleKey()
+     * 
      * @param dev 
-     * @return NearbySession& 
+     * @return NearbySession*, nullptr if the device has no session
      */
-    NearbySession &find(BLEDevice dev) override;
+    NearbySession *find(BLEDevice dev) override;
+
+    /**
+     * @brief find a session by binary BLE address, no allocation
+     * 
+     * @param bleKey 
+     * @return NearbySession*, nullptr if the address has no session
+     */
+    NearbySession *find(const UWBMacKey &bleKey);
 
     /**
      * @brief add a session
@@ -100,7 +253,12 @@ private:
     NearbySessionManager(NearbySessionManager const &) = delete;
     void operator=(NearbySessionManager const &) = delete;
 
-    NearbySession emptySession;
+    /**
+     * @brief sessions by binary BLE address, a phone that reconnects while
+     * its old session is still stopping points to the new one
+     * 
+     */
+    UWBPeerTable<NearbySession *, 8> index;
 
     /**
      * @brief callbacks
@@ -130,7 +288,64 @@ private:
     static void blePeripheralDisconnectHandler(BLEDevice central);
     static void rxCharacteristicWritten(BLEDevice central, BLECharacteristic characteristic);
 
+    /**
+     * @brief command table, see handleTLV()
+     * 
+     */
+    typedef void (NearbySessionManager::*CommandHandler)(BLEDevice bleDev, NearbySession &nearbySession, NearbySpan msg);
+    struct Command {
+        uint8_t id;
+        uint8_t minLength;      // message ID included
+        const char *name;
+        CommandHandler handle;
+    };
+    static const Command commands[];
+
+    void configureAndStart(BLEDevice bleDev, NearbySession &nearbySession, NearbySpan msg);
+    void initializeIOS(BLEDevice bleDev, NearbySession &nearbySession, NearbySpan msg);
+    void initializeAndroid(BLEDevice bleDev, NearbySession &nearbySession, NearbySpan msg);
+    void stopCommand(BLEDevice bleDev, NearbySession &nearbySession, NearbySpan msg);
+    static const Command *command(uint8_t id);
+    void serviceCommands(void);
+
+    /**
+     * @brief the phone between its Initialize and its ConfigureAndStart, see
+     * the class description
+     * 
+     */
+    bool claimHandshake(NearbySession &nearbySession);
+    void releaseHandshake(NearbySession &nearbySession);
+    NearbySession *handshaking;
+    uint32_t handshakeSince;
+
+    /**
+     * @brief responses are built in txBuffer, then notified
+     * 
+     */
+    NearbyWriter response(void) { return NearbyWriter(txBuffer, sizeof(txBuffer)); }
+    void respond(const NearbyWriter &writer);
+    uint8_t txBuffer[NEARBY_MESSAGE_SIZE];
+
+    NearbyConfigCache cache;
+    NearbyResumeCache parked;
+    NearbyRangingRelay relay;
+    int nextRelay;              // session relayed first when they do not all fit
+    void serviceRelay(void);
+    bool resumeSession(NearbySession &nearbySession, NearbySpan params);
+
+    /**
+     * @brief session state machine helpers, see handleStopSession()
+     * 
+     */
+    bool stopSession(NearbySession *nearbySession, BLEDevice bleDev);
+    bool finishStop(NearbySession &nearbySession);
+    void serviceSessions(void);
+    void firstRange(NearbySession &nearbySession);
+    void removeSession(NearbySession &nearbySession);
+
     bool bleInitialized;
+    int nextCommand;            // session whose command runs first, round robin
+    Report stats;
 private:
     
 };
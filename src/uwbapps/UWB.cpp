@@ -21,6 +21,12 @@ extern "C" void logCB(const char *str)
 
 extern "C" void SystemCallback(uwb::NotificationType opType, void *pData)
 {
+    // Nearby sessions track their own state, the user callback still gets it
+    if (opType == uwb::NotificationType::SESSION_DATA && pData != nullptr)
+        UWBNearbySessionManager.sessionInfo(*(uwb::SessionInfo *)pData);
+    else if (opType == uwb::NotificationType::RANGING_DATA && pData != nullptr)
+        UWBNearbySessionManager.rangingData(*(uwb::RangingResult *)pData);
+
     NotificationDispatcher::DispatchNotification(opType, pData);  
 }
 
@@ -0,0 +1,241 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#include "Arduino.h"
+#include "UWBAdaptiveRanging.hpp"
+
+UWBAdaptiveRanging::UWBAdaptiveRanging(UWBSession& sess, const Config& cfg)
+    : session(sess), config(cfg)
+{
+    uwb::AppConfig* duration = session.appParams.findParam(uwb::AppConfigId::RangingDuration);
+    baseline = duration ? duration->param_value.vu32 : 200;
+    if (baseline < config.minInterval)
+        baseline = config.minInterval;
+    if (baseline > config.maxInterval)
+        baseline = config.maxInterval;
+    current = baseline;
+    reset();
+}
+
+void UWBAdaptiveRanging::reset()
+{
+    peers.clear();
+    pending = current;
+    fasterVotes = 0;
+    slowerVotes = 0;
+    changes = 0;
+    rounds = 0;
+    firstTime = 0;
+    lastTime = 0;
+    roundFaster = false;
+    roundSlower = false;
+    roundValid = 0;
+}
+
+bool UWBAdaptiveRanging::peersSettled() const
+{
+    // a few samples are needed before the rate and variance mean anything
+    for (uint16_t i = 0; i < peers.capacity(); ++i)
+    {
+        const Peer* p = peers.at(i);
+        if (p && p->samples < 3)
+            return false;
+    }
+    return true;
+}
+
+void UWBAdaptiveRanging::beginRound(uint32_t now)
+{
+    if (!rounds)
+        firstTime = now;
+    lastTime = now;
+    rounds++;
+    roundFaster = false;
+    roundSlower = true;
+    roundValid = 0;
+}
+
+void UWBAdaptiveRanging::measure(const UWBMacKey& addr, uint16_t distance, uint32_t now)
+{
+    if (distance == 0xFFFF)
+        return;
+    Peer* p = peers.insert(addr);
+    if (!p)
+        return;
+
+    float d = distance;
+    float a = config.smoothing;
+    if (!p->samples)
+    {
+        // first sample, nothing to derive a rate from
+        p->mean = d;
+        p->variance = 0;
+        p->rate = 0;
+        p->anchorMean = d;
+        p->anchorTime = now;
+    }
+    else
+    {
+        float delta = d - p->mean;
+        p->mean += a * delta;
+        p->variance = (1.0f - a) * (p->variance + a * delta * delta);
+
+        // the rate is taken on the smoothed distance over rateWindow so that
+        // ranging noise does not turn into speed at short intervals
+        uint32_t dt = now - p->anchorTime;
+        if (dt >= config.rateWindow)
+        {
+            float moved = p->mean > p->anchorMean ? p->mean - p->anchorMean : p->anchorMean - p->mean;
+            p->rate = moved * 1000.0f / dt;
+            p->anchorMean = p->mean;
+            p->anchorTime = now;
+        }
+    }
+    if (p->samples < 0xFF)
+        p->samples++;
+
+    // one fast peer is enough to speed up, slowing down needs all of them
+    roundValid++;
+    if (p->rate > config.fastRate)
+        roundFaster = true;
+    if (p->rate >= config.slowRate || p->variance >= config.stableStdDev * config.stableStdDev)
+        roundSlower = false;
+}
+
+void UWBAdaptiveRanging::endRound()
+{
+    uint16_t target = pending;
+
+    if (roundFaster)
+    {
+        slowerVotes = 0;
+        if (++fasterVotes >= config.speedUpVotes)
+            target = pending / 2;
+    }
+    else if (roundValid && roundSlower && peersSettled())
+    {
+        fasterVotes = 0;
+        if (++slowerVotes >= config.slowDownVotes)
+            target = pending + pending / 2;
+    }
+    else
+    {
+        fasterVotes = 0;
+        slowerVotes = 0;
+    }
+
+    if (target < config.minInterval)
+        target = config.minInterval;
+    if (target > config.maxInterval)
+        target = config.maxInterval;
+    if (target != pending)
+    {
+        pending = target;
+        fasterVotes = 0;
+        slowerVotes = 0;
+    }
+}
+
+void UWBAdaptiveRanging::update(UWBRangingData& data)
+{
+    if (data.sessionHandle() != session.sessionID())
+        return;
+    if (data.measureType() != (uint8_t)uwb::MeasurementType::TWO_WAY)
+        return;
+
+    uint32_t now = millis();
+    RangingMeasures twr = data.twoWayRangingMeasure();
+
+    beginRound(now);
+    for (int j = 0; j < data.available() && j < uwb::MAX_RESPONDERS; j++)
+    {
+        if (twr[j].status == 0)
+            measure(UWBMacKey::fromMeasure(twr[j].peer_addr, data.macMode()), twr[j].distance, now);
+    }
+    endRound();
+}
+
+uwb::Status UWBAdaptiveRanging::poll()
+{
+    uint16_t target = pending;
+    if (target == current)
+        return uwb::Status::SUCCESS;
+
+    uwb::Status status = session.appConfig(uwb::AppConfigId::RangingDuration, target);
+    if (status != uwb::Status::SUCCESS)
+    {
+        UWBHAL.Log_E("adaptive ranging: could not set interval %u: %d", target, status);
+        // keep the interval the chip is actually using
+        pending = current;
+        return status;
+    }
+    UWBHAL.Log_D("adaptive ranging: interval %u -> %u ms", current, target);
+    current = target;
+    changes++;
+    // keep the cached configuration in line for a later init()
+    session.appParams.rangingDuration(current);
+    return status;
+}
+
+UWBAdaptiveRanging::Report UWBAdaptiveRanging::report() const
+{
+    Report rep;
+    rep.elapsedMs = lastTime - firstTime;
+    rep.rounds = rounds;
+    rep.changes = changes;
+    rep.interval = current;
+    rep.avgUpdateRateHz = rep.elapsedMs ? (rounds - 1) * 1000.0f / rep.elapsedMs : 0;
+    // rounds the fixed initial interval would have needed over the same time
+    float fixedRounds = (float)rep.elapsedMs / baseline + 1;
+    rep.airtimeSavings = rounds ? 1.0f - rounds / fixedRounds : 0;
+    return rep;
+}
+
+void UWBAdaptiveRanging::printReport() const
+{
+    Report rep = report();
+    UWBHAL.Log_I("adaptive ranging %08X: interval %u ms, %lu rounds in %lu ms, %d.%02d Hz, %d changes, airtime saved %d%%",
+                 session.sessionID(), rep.interval, (unsigned long)rep.rounds, (unsigned long)rep.elapsedMs,
+                 (int)rep.avgUpdateRateHz, (int)(rep.avgUpdateRateHz * 100) % 100, rep.changes,
+                 (int)(rep.airtimeSavings * 100));
+}
+
+UWBAdaptiveRanging::Report UWBAdaptiveRanging::replay(const Sample* trace, size_t len)
+{
+    UWBAdaptiveRanging sim(*this);
+    sim.current = baseline;
+    sim.reset();
+    if (!trace || !len)
+        return sim.report();
+
+    int latest[uwb::MAX_RESPONDERS];
+    size_t i = 0;
+    uint32_t t = trace[0].timestamp;
+    uint32_t end = trace[len - 1].timestamp;
+
+    while (t <= end)
+    {
+        // the chip only sees the latest position of every peer at round time
+        for (int p = 0; p < uwb::MAX_RESPONDERS; p++)
+            latest[p] = -1;
+        for (; i < len && trace[i].timestamp <= t; i++)
+            latest[trace[i].peer % uwb::MAX_RESPONDERS] = i;
+
+        sim.beginRound(t);
+        for (int p = 0; p < uwb::MAX_RESPONDERS; p++)
+        {
+            if (latest[p] < 0)
+                continue;
+            sim.measure(UWBMacKey((uint64_t)p), trace[latest[p]].distance, t);
+        }
+        sim.endRound();
+
+        if (sim.pending != sim.current)
+        {
+            sim.current = sim.pending;
+            sim.changes++;
+        }
+        t += sim.current;
+    }
+    return sim.report();
+}
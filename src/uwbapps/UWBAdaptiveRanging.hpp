@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#ifndef UWBADAPTIVERANGING_HPP
+#define UWBADAPTIVERANGING_HPP
+
+#include "UWBSession.hpp"
+#include "UWBRangingData.hpp"
+#include "UWBPeerTable.hpp"
+
+/**
+ * @brief Adapts the ranging interval of a live session to the peers motion
+ *
+ * The presets (UWBTracker, UWBRangingController...) range every 200ms
+ * regardless of what the peers are doing. This controller tracks, for every
+ * peer of the session, the range-rate (how fast the smoothed distance
+ * changes, measured over at least rateWindow) and the distance variance, then:
+ *
+ *     - shortens RANGING_DURATION (halves it) when any peer moves faster
+ *       than fastRate, so moving peers are tracked closely
+ *     - lengthens it (by 50%) when every peer is slower than slowRate and
+ *       its distance is stable, saving air time and battery
+ *
+ * Both directions need several consecutive votes before acting (hysteresis)
+ * and the interval always stays within [minInterval, maxInterval].
+ *
+ * update() is meant to be called from the ranging callback and only takes a
+ * decision, poll() must be called from loop() to push the new interval to
+ * the chip through UWBSession::appConfig().
+ *
+ * replay() runs a recorded trace through the same logic without touching
+ * the chip, to evaluate a configuration offline or on a host.
+ */
+class UWBAdaptiveRanging {
+public:
+    /**
+     * @brief controller tuning, distances in cm and times in ms
+     *
+     * the defaults are tuned on extras/hostsim/bench/walk_trace.csv: with
+     * 4 cm of ranging noise a static peer reads as 5 to 8 cm/s in one
+     * rateWindow out of ten, so slowRate stays above that and well below
+     * walking speed (100 cm/s)
+     */
+    struct Config {
+        uint16_t minInterval;   // shortest ranging duration
+        uint16_t maxInterval;   // longest ranging duration
+        float fastRate;         // range-rate (cm/s) above which we speed up
+        float slowRate;         // range-rate (cm/s) below which we may slow down
+        float stableStdDev;     // max distance std deviation (cm) to slow down
+        uint8_t speedUpVotes;   // consecutive votes needed to speed up
+        uint8_t slowDownVotes;  // consecutive votes needed to slow down
+        float smoothing;        // EWMA weight of a new sample, 0 to 1
+        uint16_t rateWindow;    // min time over which the range-rate is measured
+
+        Config() :
+            minInterval(100),
+            maxInterval(1000),
+            fastRate(30.0f),
+            slowRate(10.0f),
+            stableStdDev(10.0f),
+            speedUpVotes(2),
+            slowDownVotes(5),
+            smoothing(0.3f),
+            rateWindow(500)
+        {}
+    };
+
+    /**
+     * @brief controller statistics, see report()
+     *
+     */
+    struct Report {
+        uint32_t elapsedMs;         // observation time
+        uint32_t rounds;            // ranging rounds seen
+        uint16_t changes;           // interval changes applied
+        uint16_t interval;          // current ranging duration
+        float avgUpdateRateHz;      // rounds per second
+        float airtimeSavings;       // 0..1, rounds saved vs the initial interval
+    };
+
+    /**
+     * @brief one entry of a recorded ranging trace, see replay()
+     *
+     */
+    struct Sample {
+        uint32_t timestamp;     // ms
+        uint8_t peer;           // index of the peer in the trace
+        uint16_t distance;      // cm, 0xFFFF if not valid
+    };
+
+    /**
+     * @brief Construct a new UWBAdaptiveRanging object
+     *
+     * @param sess session to control, the initial interval is read from its appParams
+     * @param cfg tuning
+     */
+    UWBAdaptiveRanging(UWBSession& sess, const Config& cfg = Config());
+
+    /**
+     * @brief feed a ranging notification, safe to call from the ranging callback
+     *
+     * notifications for other sessions are ignored
+     *
+     * @param data
+     */
+    void update(UWBRangingData& data);
+
+    /**
+     * @brief apply a pending interval change to the session, call from loop()
+     *
+     * @return uwb::Status::SUCCESS if nothing to do or the change was accepted
+     */
+    uwb::Status poll();
+
+    /**
+     * @brief current ranging duration, in ms
+     *
+     */
+    uint16_t interval() const { return current; }
+
+    /**
+     * @brief the statistics since construction or the last reset()
+     *
+     */
+    Report report() const;
+
+    /**
+     * @brief log the report
+     *
+     */
+    void printReport() const;
+
+    /**
+     * @brief forget peers and statistics
+     *
+     */
+    void reset();
+
+    /**
+     * @brief simulate the controller over a recorded trace
+     *
+     * the trace is expected to be sampled faster than minInterval: it is
+     * subsampled according to the interval chosen by the controller, as the
+     * chip would do. Nothing is sent to the session.
+     *
+     * @param trace samples sorted by timestamp
+     * @param len number of samples
+     * @return the resulting report
+     */
+    Report replay(const Sample* trace, size_t len);
+
+private:
+    struct Peer {
+        uint8_t samples;
+        uint32_t anchorTime;
+        float anchorMean;
+        float mean;
+        float variance;
+        float rate;
+    };
+
+    bool peersSettled() const;
+    void beginRound(uint32_t now);
+    void measure(const UWBMacKey& addr, uint16_t distance, uint32_t now);
+    void endRound();
+
+    UWBSession& session;
+    Config config;
+    UWBPeerTable<Peer, 16> peers;   // up to uwb::MAX_RESPONDERS
+    uint16_t baseline;
+    uint16_t current;
+    volatile uint16_t pending;
+    uint8_t fasterVotes;
+    uint8_t slowerVotes;
+    bool roundFaster;
+    bool roundSlower;
+    uint8_t roundValid;
+    uint16_t changes;
+    uint32_t rounds;
+    uint32_t firstTime;
+    uint32_t lastTime;
+};
+
+#endif /* UWBADAPTIVERANGING_HPP */
@@ -9,7 +9,8 @@
 #define __UWBAPPPARAMLIST_HPP__
 uwb::AppConfig buildScalar(uwb::AppConfigId id, uint32_t val);
 uwb::AppConfig buildArray(uwb::AppConfigId id, uint8_t *val, uint8_t length);
-class UWBAppParamList : public UWBAppParamsList<uwb::AppConfig, uwb::AppConfigId, uwb::AppParamType, uwb::AppParamValue>
+// room for the longest array, a full list of extended peer addresses, and a few short ones
+class UWBAppParamList : public UWBAppParamsList<uwb::AppConfig, uwb::AppConfigId, uwb::AppParamType, uwb::AppParamValue, 128>
 {
 public:
      /**
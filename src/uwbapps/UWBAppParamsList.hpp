@@ -5,109 +5,395 @@
 #define UWBAPPPARAMSLIST_HPP
 
 
+#include <string.h>
 #include "hal/uwb_types.hpp"
 
-template <typename T, typename P1, typename P2, typename P3> class UWBAppParamsList {
+/**
+ * @brief IDs whose value is a byte array even when it is 4 bytes or shorter,
+ * used to decode TLV blobs (see load())
+ *
+ */
+inline bool isArrayParam(uwb::AppConfigId id)
+{
+    switch (id) {
+    case uwb::AppConfigId::LocalAddress:
+    case uwb::AppConfigId::PeerAddress:
+    case uwb::AppConfigId::StaticStsIv:
+    case uwb::AppConfigId::UlTdoaDeviceId:
+    case uwb::AppConfigId::SessionKey:
+    case uwb::AppConfigId::SubSessionKey:
+        return true;
+    default:
+        return false;
+    }
+}
+
+inline bool isArrayParam(uwb::VendorAppConfigId id)
+{
+    return id == uwb::VendorAppConfigId::ANTENNAE_CONFIGURATION_TX ||
+           id == uwb::VendorAppConfigId::ANTENNAE_CONFIGURATION_RX;
+}
+
+/**
+ * @brief Fixed size list of TLV parameters
+ *
+ * Parameters are kept compact and in insertion order in _paramsList, which
+ * is what the HAL serialises: _paramsList and _size must stay the first
+ * members and the class trivially copyable, the list is passed by value to
+ * the precompiled HAL.
+ *
+ * The list is copied whenever it is handed to the HAL, so the bookkeeping
+ * is kept small and holds positions rather than pointers. Lookups go
+ * through _index, an open addressed table (linear probing, INDEX_SIZE
+ * bytes) from the ID to the position, usually a single probe. A bit per
+ * position tracks the parameters changed since the last markClean(), so
+ * callers can resend only what changed. Removing keeps the insertion order,
+ * hence moves the entries that follow and rebuilds the index.
+ *
+ * Array values are copied into an arena of ARENA_SIZE bytes, sized for each
+ * kind of list. The entries' pointers are set back to this list's arena by
+ * rebase(), which getParamsList() and findParam() call, so a copied list
+ * never points into the original. addOrUpdateParam(param, false) keeps the
+ * caller's buffer instead, for values that outlive the list (e.g. presets
+ * in flash).
+ */
+template <typename T, typename P1, typename P2, typename P3, unsigned int ARENA_SIZE> class UWBAppParamsList {
+    static_assert(ARENA_SIZE < 0xFF, "arena offsets are 8 bit");
 public:
-    UWBAppParamsList() : _size(0) {}
+    UWBAppParamsList() : _size(0), _dirty(0), _arenaUsed(0) {
+        memset(_index, EMPTY, sizeof(_index));
+    }
+
 
- 
     bool addOrUpdateParam(P1 param_id, P2 param_type, P3 param_value, uint16_t param_len=0) {
-        
-        // First, check if the parameter already exists
-        for (unsigned int i = 0; i < _size; i++) {
-            if (_paramsList[i].param_id == param_id) {
-                // Parameter exists, update it
-                _paramsList[i].param_type = param_type;
-                _paramsList[i].param_value = param_value;
-                //UWBHAL.Log_D("param updated %x: %x %x",param_id,param_type,param_value);
-                return true; // Update successful
-            }
-        }
-        
-            
+        T param;
+        param.param_id = param_id;
+        param.param_type = param_type;
+        param.param_value = param_value;
+        return addOrUpdateParam(param);
+    }
+
+    /**
+     * @brief add a parameter or update its value
+     *
+     * @param param
+     * @param copy false to keep pointing to the caller's array instead of copying it
+     * @return false if the list or its array storage is full, a parameter
+     * already in the list then keeps its previous value
+     */
+    bool addOrUpdateParam(T param, bool copy = true)
+    {
+        int found = indexOf(param.param_id);
+        bool exists = found >= 0;
+        unsigned int pos = exists ? found : _size;
 
         // If the parameter does not exist, add it (if there's space)
-        if (_size < MAX_SIZE) {
-            _paramsList[_size].param_id = param_id;
-            _paramsList[_size].param_type = param_type;
-            _paramsList[_size].param_value = param_value;
-            _size++;
-            //UWBHAL.Log_D("param added");
-            return true; // Addition successful
-        } else {
+        if (!exists && _size >= MAX_SIZE) {
             // Array is full, cannot add new parameter
-            //UWBHAL.Log_E("too many params");
+            //UWBHAL.Log_D("List full");
             return false;
         }
-    }
 
-    bool addOrUpdateParam(T param)
-    {
-        // First, check if the parameter already exists
-        for (unsigned int i = 0; i < _size; i++) {
-            if (_paramsList[i].param_id == param.param_id) {
-                // Parameter exists, update it
-                _paramsList[i].param_type = param.param_type;
-                _paramsList[i].param_value = param.param_value;
-                //UWBHAL.Log_D("param updated");
-                return true; // Update successful
-            }
+        if (param.param_type == P2::ARRAY_U8 && copy) {
+            if (!store(pos, exists, param.param_value.au8.param_value, param.param_value.au8.param_len))
+                return false;
+        } else {
+            _where[pos] = NOT_OWNED;
         }
 
-        // If the parameter does not exist, add it (if there's space)
-        if (_size < MAX_SIZE) {
-            _paramsList[_size].param_id = param.param_id;
-            _paramsList[_size].param_type = param.param_type;
-            _paramsList[_size].param_value = param.param_value;
-            _size++;
-            //UWBHAL.Log_D("param added");
-            return true; // Addition successful
+        _paramsList[pos].param_id = param.param_id;
+        _paramsList[pos].param_type = param.param_type;
+        if (_where[pos] == NOT_OWNED) {
+            _paramsList[pos].param_value = param.param_value;
         } else {
-            // Array is full, cannot add new parameter
-            //UWBHAL.Log_D("List full");
-            return false;
+            _paramsList[pos].param_value.au8.param_value = storage(pos);
+            _paramsList[pos].param_value.au8.param_len = param.param_value.au8.param_len;
+        }
+        _dirty |= 1UL << pos;
+        if (!exists) {
+            _index[freeSlot(param.param_id)] = pos;
+            _size++;
         }
+        return true;
     }
 
-    
+
 
     bool removeParam(P1 param_id) {
+        int found = indexOf(param_id);
+        if (found < 0)
+            return false; // Param not found
+
+        // the HAL expects a compact list in insertion order
+        unsigned int pos = found;
+        for (unsigned int j = pos; j < _size - 1; j++) {
+            _paramsList[j] = _paramsList[j + 1];
+            _where[j] = _where[j + 1];
+        }
+        uint32_t below = (1UL << pos) - 1;
+        _dirty = (_dirty & below) | ((_dirty >> 1) & ~below);
+        _size--;
+        reindex();
+        return true;
+    }
+
+    T* findParam(P1 param_id) {
+        int found = indexOf(param_id);
+        if (found < 0)
+            return nullptr; // Param not found
+        rebase();
+        return &_paramsList[found];
+    }
+
+    bool hasParam(P1 param_id) const {
+        return indexOf(param_id) >= 0;
+    }
+
+    /**
+     * @brief true if the parameter was added or updated since the last markClean()
+     *
+     */
+    bool isDirty(P1 param_id) const {
+        int found = indexOf(param_id);
+        return found >= 0 && (_dirty & (1UL << found));
+    }
+
+    /**
+     * @brief number of parameters added or updated since the last markClean()
+     *
+     */
+    unsigned int dirtyCount() const {
+        unsigned int n = 0;
+        for (unsigned int i = 0; i < _size; i++)
+            n += (_dirty >> i) & 1;
+        return n;
+    }
+
+    /**
+     * @brief forget the changes, e.g. once the list was sent to the chip
+     *
+     */
+    void markClean() {
+        _dirty = 0;
+    }
+
+    /**
+     * @brief point the array values to this list's storage, needed after the
+     * list was copied and before it is handed to the HAL
+     *
+     */
+    void rebase() {
         for (unsigned int i = 0; i < _size; i++) {
-            if (_paramsList[i].param_id == param_id) {
-                for (unsigned int j = i; j < _size - 1; j++) {
-                    _paramsList[j] = _paramsList[j + 1];
-                }
-                _size--;
-                return true;
+            if (_where[i] != NOT_OWNED)
+                _paramsList[i].param_value.au8.param_value = &_arena[_where[i]];
+        }
+    }
+
+    /**
+     * @brief Add or update the parameters encoded in a UCI TLV blob
+     * (ID, length, value little endian), see UWBPreset and UWBProfile
+     *
+     * Array values (isArrayParam() or longer than 4 bytes) point into the
+     * blob without copy, which must then outlive the list (presets and
+     * profiles live in flash).
+     *
+     * @param tlv
+     * @param len size of the blob in bytes
+     * @return true
+     * @return false if the blob is truncated or the list is full
+     */
+    bool load(const uint8_t* tlv, size_t len) {
+        size_t o = 0;
+        while (o + 2 <= len) {
+            T param;
+            param.param_id = (P1)tlv[o];
+            uint8_t size = tlv[o + 1];
+            o += 2;
+            if (o + size > len)
+                return false;
+
+            if (isArrayParam(param.param_id) || size > 4) {
+                // the HAL only reads array values
+                param.param_type = P2::ARRAY_U8;
+                param.param_value.au8.param_value = const_cast<uint8_t*>(&tlv[o]);
+                param.param_value.au8.param_len = size;
+            } else {
+                param.param_type = P2::U32;
+                param.param_value.vu32 = 0;
+                for (int i = size - 1; i >= 0; i--)
+                    param.param_value.vu32 = (param.param_value.vu32 << 8) | tlv[o + i];
             }
+            if (!addOrUpdateParam(param, false))
+                return false;
+            o += size;
         }
-        return false; // Param not found
+        return o == len;
     }
 
-    T* findParam(P1 param_id) {
+    /**
+     * @brief encode the list as a UCI TLV blob, in insertion order
+     *
+     * scalars use the shortest length holding their value
+     *
+     * @param out
+     * @param size size of out
+     * @return number of bytes written, 0 if out is too small
+     */
+    size_t save(uint8_t* out, size_t size) {
+        rebase();
+        size_t o = 0;
         for (unsigned int i = 0; i < _size; i++) {
-            if (_paramsList[i].param_id == param_id) {
-                return &_paramsList[i];
+            const T& p = _paramsList[i];
+            bool array = p.param_type == P2::ARRAY_U8;
+            uint32_t v = p.param_value.vu32;
+            uint16_t len = array ? p.param_value.au8.param_len : (v > 0xFFFF ? 4 : v > 0xFF ? 2 : 1);
+            if (len > 0xFF || o + 2 + len > size)
+                return 0;
+            out[o++] = key(p.param_id);
+            out[o++] = len;
+            if (array) {
+                memcpy(&out[o], p.param_value.au8.param_value, len);
+                o += len;
+            } else {
+                for (uint16_t j = 0; j < len; j++, v >>= 8)
+                    out[o++] = v & 0xFF;
             }
         }
-        return nullptr; // Param not found
+        return o;
     }
 
     // Method to return the raw paramsList array
     T* getParamsList() {
+        rebase();
         return (T *)&_paramsList[0];
     }
 
     unsigned int getSize() {
         return _size;
     }
-    
+
 
 private:
     static const unsigned int MAX_SIZE = 30; // Maximum number of elements
+    static const uint8_t NOT_OWNED = 0xFF;     // scalar or caller's array
+    static const unsigned int INDEX_SIZE = 64;  // power of two, at most half full
+    static const uint8_t EMPTY = 0xFF;         // free slot of _index
+    static_assert(MAX_SIZE <= 32, "one dirty bit per position");
+    static_assert(INDEX_SIZE >= 2 * MAX_SIZE && (INDEX_SIZE & (INDEX_SIZE - 1)) == 0, "index too small");
+
+    static uint8_t key(P1 param_id) { return static_cast<uint8_t>(param_id); }
+
+    // the IDs are mostly consecutive, so they hardly collide in the low bits
+    static unsigned int home(P1 param_id) { return key(param_id) & (INDEX_SIZE - 1); }
+
+    int indexOf(P1 param_id) const {
+        for (unsigned int s = home(param_id); _index[s] != EMPTY; s = (s + 1) & (INDEX_SIZE - 1)) {
+            if (_paramsList[_index[s]].param_id == param_id)
+                return _index[s];
+        }
+        return -1;
+    }
+
+    // first free slot of the probe sequence of an ID not in the list
+    unsigned int freeSlot(P1 param_id) const {
+        unsigned int s = home(param_id);
+        while (_index[s] != EMPTY)
+            s = (s + 1) & (INDEX_SIZE - 1);
+        return s;
+    }
+
+    void reindex() {
+        memset(_index, EMPTY, sizeof(_index));
+        for (unsigned int i = 0; i < _size; i++)
+            _index[freeSlot(_paramsList[i].param_id)] = i;
+    }
+
+    uint8_t* storage(unsigned int pos) {
+        return &_arena[_where[pos]];
+    }
+
+    bool store(unsigned int pos, bool exists, const uint8_t* value, uint16_t len) {
+        bool owned = exists && _where[pos] != NOT_OWNED;
+
+        // shrinking or same size values stay where they are
+        if (owned && _paramsList[pos].param_value.au8.param_len >= len) {
+            memmove(&_arena[_where[pos]], value, len);
+            return true;
+        }
+        // decide before touching anything: on failure the old value stays valid
+        if (live(owned ? pos : -1) + len > ARENA_SIZE)
+            return false;
+
+        if (_arenaUsed + len > ARENA_SIZE) {
+            // the value may come from our own arena, which compact() moves
+            int from = owner(value);
+            uint8_t offset = from >= 0 ? value - &_arena[_where[from]] : 0;
+            // the old value is only kept through compact() if it is the source
+            if (owned && from != (int)pos)
+                _where[pos] = NOT_OWNED;
+            compact();
+            if (from >= 0)
+                value = &_arena[_where[from] + offset];
+            if (_arenaUsed + len > ARENA_SIZE)
+                return false;
+        }
+        memcpy(&_arena[_arenaUsed], value, len);
+        _where[pos] = _arenaUsed;
+        _arenaUsed += len;
+        return true;
+    }
+
+    // arena bytes held by the entries, but skip
+    unsigned int live(int skip) const {
+        unsigned int used = 0;
+        for (unsigned int i = 0; i < _size; i++) {
+            if (_where[i] != NOT_OWNED && (int)i != skip)
+                used += _paramsList[i].param_value.au8.param_len;
+        }
+        return used;
+    }
+
+    // entry whose arena value holds ptr, -1 if none
+    int owner(const uint8_t* ptr) const {
+        for (unsigned int i = 0; i < _size; i++) {
+            if (_where[i] != NOT_OWNED && ptr >= &_arena[_where[i]] &&
+                ptr < &_arena[_where[i]] + _paramsList[i].param_value.au8.param_len)
+                return i;
+        }
+        return -1;
+    }
+
+    // drop the space of removed or reallocated values, moving the live ones
+    // down in offset order so that none is overwritten
+    void compact() {
+        uint8_t used = 0;
+        for (;;) {
+            int next = -1;
+            for (unsigned int i = 0; i < _size; i++) {
+                if (_where[i] != NOT_OWNED && _where[i] >= used &&
+                    _paramsList[i].param_value.au8.param_len &&
+                    (next < 0 || _where[i] < _where[next]))
+                    next = i;
+            }
+            if (next < 0)
+                break;
+            uint16_t len = _paramsList[next].param_value.au8.param_len;
+            memmove(&_arena[used], &_arena[_where[next]], len);
+            _where[next] = used;
+            used += len;
+        }
+        _arenaUsed = used;
+        rebase();
+    }
+
     T _paramsList[MAX_SIZE];
     unsigned int _size; // Current number of elements
+    // appended after the members the HAL knows about
+    uint32_t _dirty;                    // changed since markClean(), bit per position
+    uint8_t _where[MAX_SIZE];           // NOT_OWNED or offset in _arena
+    uint8_t _index[INDEX_SIZE];         // EMPTY or position in _paramsList
+    uint8_t _arenaUsed;
+    uint8_t _arena[ARENA_SIZE];
 };
 
 #endif //_UWBAPPPARAMSLIST_H_
@@ -0,0 +1,257 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#include "UWBChannelAllocator.hpp"
+
+// share of a round leaking through the cross-correlation of two BPRF codes
+#define CROSS_CODE_LEAK     0.05f
+// a different SFD halves the chance of locking on the other session's frames
+#define CROSS_SFD_FACTOR    0.5f
+
+UWBChannelAllocator::UWBChannelAllocator(uint32_t siteSeed)
+{
+    count = 0;
+    anyAdjacency = false;
+    ch5 = true;
+    ch9 = true;
+    seed = siteSeed;
+    state = 0;
+    memset(neighbours, 0, sizeof(neighbours));
+    memset(result, 0, sizeof(result));
+}
+
+int UWBChannelAllocator::addSession(UWBSession& sess)
+{
+    if (count >= maxSessions)
+        return -1;
+    sessions[count] = &sess;
+    return count++;
+}
+
+bool UWBChannelAllocator::adjacent(int a, int b)
+{
+    if (a < 0 || a >= count || b < 0 || b >= count || a == b)
+        return false;
+    neighbours[a] |= 1 << b;
+    neighbours[b] |= 1 << a;
+    anyAdjacency = true;
+    return true;
+}
+
+void UWBChannelAllocator::allowChannel(uint8_t channel, bool allowed)
+{
+    if (channel == 5)
+        ch5 = allowed;
+    else if (channel == 9)
+        ch9 = allowed;
+}
+
+uint32_t UWBChannelAllocator::random()
+{
+    // xorshift32, the same sequence on every peer for a given seed
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+bool UWBChannelAllocator::isAdjacent(int a, int b) const
+{
+    if (a == b)
+        return false;
+    if (!anyAdjacency)
+        return true;
+    return neighbours[a] & (1 << b);
+}
+
+float UWBChannelAllocator::airtime(int index) const
+{
+    UWBAppParamList& params = sessions[index]->appParams;
+    uwb::AppConfig* p;
+    uint32_t slots = (p = params.findParam(uwb::AppConfigId::SlotsPerRound)) ? p->param_value.vu32 : 25;
+    uint32_t slotRstu = (p = params.findParam(uwb::AppConfigId::SlotDuration)) ? p->param_value.vu32 : 2400;
+    uint32_t durationMs = (p = params.findParam(uwb::AppConfigId::RangingDuration)) ? p->param_value.vu32 : 200;
+    if (!durationMs)
+        return 1.0f;
+
+    float share = (float)(slots * slotRstu) / (durationMs * 1200.0f);
+    return share > 1.0f ? 1.0f : share;
+}
+
+float UWBChannelAllocator::interference(const Tuple& a, const Tuple& b) const
+{
+    if (a.channel != b.channel)
+        return 0;
+    float w = a.code == b.code ? 1.0f : CROSS_CODE_LEAK;
+    if (a.sfd != b.sfd)
+        w *= CROSS_SFD_FACTOR;
+    return w;
+}
+
+uint32_t UWBChannelAllocator::deriveSessionID(int index)
+{
+    uint32_t id;
+    bool unique;
+    do
+    {
+        id = random();
+        unique = id != 0;
+        for (int i = 0; i < index && unique; ++i)
+            unique = result[i].sessionID != id;
+    } while (!unique);
+    return id;
+}
+
+bool UWBChannelAllocator::allocate()
+{
+    if (!ch5 && !ch9)
+    {
+        UWBHAL.Log_E("channel allocator: no channel allowed");
+        return false;
+    }
+
+    state = seed ^ 0x9E3779B9;
+    if (!state)
+        state = 1;
+
+    // the candidate tuples, shuffled by the seed so that two sites with the
+    // same layout do not pick the same resources
+    static const uint8_t codes[] = {9, 10, 11, 12};
+    static const uint8_t sfds[] = {2, 0};
+    int n = 0;
+    for (int c = 0; c < 2; ++c)
+    {
+        if ((c == 0 && !ch9) || (c == 1 && !ch5))
+            continue;
+        for (int s = 0; s < 2; ++s)
+        {
+            for (int k = 0; k < 4; ++k)
+            {
+                tuples[n].channel = c == 0 ? 9 : 5;
+                tuples[n].code = codes[k];
+                tuples[n].sfd = sfds[s];
+                n++;
+            }
+        }
+    }
+    for (int i = n - 1; i > 0; --i)
+    {
+        int j = random() % (i + 1);
+        Tuple t = tuples[i];
+        tuples[i] = tuples[j];
+        tuples[j] = t;
+    }
+
+    for (int i = 0; i < count; ++i)
+        result[i].sessionID = 0;
+    for (int i = 0; i < count; ++i)
+        result[i].sessionID = deriveSessionID(i);
+
+    // most constrained sessions first (greedy colouring), ties by index
+    int order[maxSessions];
+    int degree[maxSessions];
+    for (int i = 0; i < count; ++i)
+    {
+        order[i] = i;
+        degree[i] = 0;
+        for (int j = 0; j < count; ++j)
+            degree[i] += isAdjacent(i, j);
+    }
+    for (int i = 1; i < count; ++i)
+    {
+        int v = order[i];
+        int j = i - 1;
+        for (; j >= 0 && degree[order[j]] < degree[v]; --j)
+            order[j + 1] = order[j];
+        order[j + 1] = v;
+    }
+
+    bool assigned[maxSessions] = {false};
+    uint8_t uses[numTuples] = {0};
+    for (int k = 0; k < count; ++k)
+    {
+        int s = order[k];
+        int best = 0;
+        float bestCost = 0;
+        for (int t = 0; t < n; ++t)
+        {
+            float cost = 0;
+            for (int j = 0; j < count; ++j)
+            {
+                if (assigned[j] && isAdjacent(s, j))
+                    cost += interference(tuples[t], tuples[tupleOf[j]]) * airtime(j);
+            }
+            // spread the reuse over the whole site when costs are equal
+            cost += uses[t] * 1e-4f;
+            if (t == 0 || cost < bestCost)
+            {
+                best = t;
+                bestCost = cost;
+            }
+        }
+        tupleOf[s] = best;
+        uses[best]++;
+        assigned[s] = true;
+    }
+
+    bool ok = true;
+    for (int i = 0; i < count; ++i)
+    {
+        const Tuple& t = tuples[tupleOf[i]];
+        float clear = 1.0f;
+        for (int j = 0; j < count; ++j)
+        {
+            if (isAdjacent(i, j))
+                clear *= 1.0f - interference(t, tuples[tupleOf[j]]) * airtime(j);
+        }
+        result[i].channel = t.channel;
+        result[i].preambleCode = t.code;
+        result[i].sfdId = t.sfd;
+        result[i].collisionProbability = 1.0f - clear;
+
+        UWBSession* sess = sessions[i];
+        sess->sessionID(result[i].sessionID);
+        ok = sess->appParams.channel(t.channel) && ok;
+        ok = sess->appParams.preambleCodeIndex(t.code) && ok;
+        ok = sess->appParams.sfdId(t.sfd) && ok;
+    }
+    if (!ok)
+        UWBHAL.Log_E("channel allocator: parameter list full");
+    return ok;
+}
+
+bool UWBChannelAllocator::assignment(int index, Assignment& assignment) const
+{
+    if (index < 0 || index >= count)
+        return false;
+    assignment = result[index];
+    return true;
+}
+
+float UWBChannelAllocator::worstCollisionProbability() const
+{
+    float worst = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        if (result[i].collisionProbability > worst)
+            worst = result[i].collisionProbability;
+    }
+    return worst;
+}
+
+void UWBChannelAllocator::printReport() const
+{
+    float total = 0;
+    UWBHAL.Log_I("channel allocator: %d sessions, seed %08X", count, seed);
+    for (int i = 0; i < count; ++i)
+    {
+        const Assignment& a = result[i];
+        int permille = (int)(a.collisionProbability * 1000 + 0.5f);
+        total += a.collisionProbability;
+        UWBHAL.Log_I("  #%d %08X ch %u code %u sfd %u collision %d.%d%%", i, a.sessionID, a.channel,
+                     a.preambleCode, a.sfdId, permille / 10, permille % 10);
+    }
+    int worst = (int)(worstCollisionProbability() * 1000 + 0.5f);
+    int mean = count ? (int)(total * 1000 / count + 0.5f) : 0;
+    UWBHAL.Log_I("  worst %d.%d%% mean %d.%d%%", worst / 10, worst % 10, mean / 10, mean % 10);
+}
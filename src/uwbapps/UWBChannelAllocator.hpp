@@ -0,0 +1,151 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#ifndef UWBCHANNELALLOCATOR_HPP
+#define UWBCHANNELALLOCATOR_HPP
+
+#include "hal/uwb_hal.hpp"
+#include "UWBSession.hpp"
+
+/**
+ * @brief Assigns channel, preamble code, SFD and session ID to co-located sessions
+ *
+ * The presets all use preamble code 10 on the default channel, so in a dense
+ * deployment every tag/anchor pair ends up on the same radio resources. The
+ * allocator spreads a set of sessions over the 16 BPRF combinations
+ * (channel 5/9, preamble code 9 to 12, SFD 0/2) so that sessions declared
+ * adjacent share as little as possible:
+ *
+ *     different channel                   no interference
+ *     same channel, different code        codes are nearly orthogonal
+ *     same channel and code               rounds overlapping in time collide
+ *
+ * The assignment only depends on the site seed, the order in which sessions
+ * were added and the adjacency, so every peer running the allocator with the
+ * same inputs derives the same tuples (and session IDs) without talking to
+ * each other.
+ *
+ * The report estimates for every session the probability that one of its
+ * ranging rounds overlaps a round of an interfering neighbour, from the air
+ * time of the rounds (slots per round, slot duration, ranging duration).
+ *
+ * Example:
+ *
+ *     UWBChannelAllocator alloc(0xC0FFEE);
+ *     int a = alloc.addSession(tracker1);
+ *     int b = alloc.addSession(tracker2);
+ *     alloc.adjacent(a, b);
+ *     alloc.allocate();
+ *     alloc.printReport();
+ */
+class UWBChannelAllocator {
+public:
+    static const int maxSessions = 16;
+
+    /**
+     * @brief the resources given to one session
+     *
+     */
+    struct Assignment {
+        uint32_t sessionID;
+        uint8_t channel;
+        uint8_t preambleCode;
+        uint8_t sfdId;
+        float collisionProbability;     // per ranging round, 0..1
+    };
+
+    /**
+     * @brief Construct a new UWBChannelAllocator object
+     *
+     * @param siteSeed shared by every peer of the site
+     */
+    UWBChannelAllocator(uint32_t siteSeed);
+
+    /**
+     * @brief add a session, it is configured by allocate()
+     *
+     * @param sess
+     * @return index of the session, -1 if full
+     */
+    int addSession(UWBSession& sess);
+
+    /**
+     * @brief declare two sessions as neighbours, able to hear each other
+     *
+     * When no adjacency is declared at all, every session is considered
+     * adjacent to every other (single room).
+     *
+     * @param a index returned by addSession()
+     * @param b index returned by addSession()
+     * @return false if an index is not valid
+     */
+    bool adjacent(int a, int b);
+
+    /**
+     * @brief allow or forbid a channel, both are allowed by default
+     *
+     * @param channel 5 or 9
+     * @param allowed
+     */
+    void allowChannel(uint8_t channel, bool allowed);
+
+    /**
+     * @brief compute the assignment and write it to the sessions
+     * (session ID, channel, preamble code index, SFD ID)
+     *
+     * @return false if no channel is allowed or a parameter list is full
+     */
+    bool allocate();
+
+    /**
+     * @brief get the assignment of a session, valid after allocate()
+     *
+     * @param index 0 to size()-1
+     * @param assignment
+     * @return true if index is valid
+     */
+    bool assignment(int index, Assignment& assignment) const;
+
+    /**
+     * @brief highest collision probability among the sessions
+     *
+     */
+    float worstCollisionProbability() const;
+
+    /**
+     * @brief log the assignment and the collision probabilities
+     *
+     */
+    void printReport() const;
+
+    int size() const { return count; }
+
+private:
+    struct Tuple {
+        uint8_t channel;
+        uint8_t code;
+        uint8_t sfd;
+    };
+
+    static const int numTuples = 16;
+
+    uint32_t random();
+    bool isAdjacent(int a, int b) const;
+    float airtime(int index) const;
+    float interference(const Tuple& a, const Tuple& b) const;
+    uint32_t deriveSessionID(int index);
+
+    UWBSession* sessions[maxSessions];
+    Assignment result[maxSessions];
+    uint8_t tupleOf[maxSessions];
+    uint16_t neighbours[maxSessions];
+    Tuple tuples[numTuples];
+    int count;
+    bool anyAdjacency;
+    bool ch5;
+    bool ch9;
+    uint32_t seed;
+    uint32_t state;
+};
+
+#endif /* UWBCHANNELALLOCATOR_HPP */
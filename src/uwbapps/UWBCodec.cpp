@@ -0,0 +1,254 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#include <string.h>
+#include "UWBCodec.hpp"
+
+#define LZ_MAX_OFFSET   (1 << 13)
+#define LZ_MAX_LITERALS 32
+#define LZ_MAX_MATCH    (7 + 255 + 2)
+
+static void put32(uint8_t* p, uint32_t v)
+{
+    for (int i = 0; i < 4; ++i, v >>= 8)
+        p[i] = v & 0xFF;
+}
+
+static uint32_t get32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint8_t varintSize(uint32_t v)
+{
+    uint8_t n = 1;
+    while (v >= 0x80)
+    {
+        v >>= 7;
+        n++;
+    }
+    return n;
+}
+
+static uint8_t putVarint(uint8_t* p, uint32_t v)
+{
+    uint8_t n = 0;
+    while (v >= 0x80)
+    {
+        p[n++] = (v & 0x7F) | 0x80;
+        v >>= 7;
+    }
+    p[n++] = v;
+    return n;
+}
+
+// 0 if the varint is truncated or longer than 5 bytes
+static uint8_t getVarint(const uint8_t* p, size_t len, uint32_t& v)
+{
+    v = 0;
+    for (uint8_t n = 0; n < len && n < 5; ++n)
+    {
+        v |= (uint32_t)(p[n] & 0x7F) << (7 * n);
+        if (!(p[n] & 0x80))
+            return n + 1;
+    }
+    return 0;
+}
+
+static uint32_t zigzag(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t v)
+{
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+size_t UWBDeltaCodec::packSamples(const int32_t* samples, size_t n, uint8_t* out, size_t size, size_t& written)
+{
+    uint32_t prev = 0;
+    size_t i = 0;
+    written = 0;
+    for (; i < n; ++i)
+    {
+        // wrapping difference, decoding wraps back
+        uint32_t z = zigzag((int32_t)((uint32_t)samples[i] - prev));
+        if (written + varintSize(z) > size)
+            break;
+        written += putVarint(&out[written], z);
+        prev = samples[i];
+    }
+    return i;
+}
+
+size_t UWBDeltaCodec::unpackSamples(const uint8_t* in, size_t len, int32_t* samples, size_t max)
+{
+    uint32_t prev = 0;
+    size_t n = 0;
+    size_t pos = 0;
+    while (pos < len && n < max)
+    {
+        uint32_t z;
+        uint8_t used = getVarint(&in[pos], len - pos, z);
+        if (!used)
+            return 0;
+        pos += used;
+        prev += (uint32_t)unzigzag(z);
+        samples[n++] = prev;
+    }
+    return n;
+}
+
+size_t UWBDeltaCodec::encode(const uint8_t* in, size_t len, uint8_t* out, size_t size)
+{
+    if (len % 4)
+        return 0;
+    uint32_t prev = 0;
+    size_t written = 0;
+    for (size_t i = 0; i < len; i += 4)
+    {
+        uint32_t v = get32(&in[i]);
+        uint32_t z = zigzag((int32_t)(v - prev));
+        if (written + varintSize(z) > size)
+            return 0;
+        written += putVarint(&out[written], z);
+        prev = v;
+    }
+    return written;
+}
+
+size_t UWBDeltaCodec::decode(const uint8_t* in, size_t len, uint8_t* out, size_t size)
+{
+    uint32_t prev = 0;
+    size_t written = 0;
+    size_t pos = 0;
+    while (pos < len)
+    {
+        uint32_t z;
+        uint8_t used = getVarint(&in[pos], len - pos, z);
+        if (!used || written + 4 > size)
+            return 0;
+        pos += used;
+        prev += (uint32_t)unzigzag(z);
+        put32(&out[written], prev);
+        written += 4;
+    }
+    return written;
+}
+
+static uint8_t lzHash(const uint8_t* p)
+{
+    uint32_t v = p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16);
+    return (v * 2654435761u) >> 24;
+}
+
+size_t UWBLzCodec::encode(const uint8_t* in, size_t len, uint8_t* out, size_t size)
+{
+    if (!len || len > 0xFFFF || !size)
+        return 0;
+    memset(table, 0, sizeof(table));
+
+    // out[lit] is the control byte of the literal run being written
+    size_t op = 1;
+    size_t lit = 0;
+    size_t ip = 0;
+    while (ip < len)
+    {
+        size_t match = 0;
+        size_t ref = 0;
+        if (ip + 2 < len)
+        {
+            uint8_t h = lzHash(&in[ip]);
+            ref = table[h];
+            table[h] = ip;
+            // any position works as a hint, it is verified
+            if (ref < ip && ip - ref <= LZ_MAX_OFFSET && !memcmp(&in[ref], &in[ip], 3))
+            {
+                size_t max = len - ip < LZ_MAX_MATCH ? len - ip : LZ_MAX_MATCH;
+                match = 3;
+                while (match < max && in[ref + match] == in[ip + match])
+                    match++;
+            }
+        }
+
+        if (!match)
+        {
+            if (op >= size)
+                return 0;
+            out[op++] = in[ip++];
+            if (++lit == LZ_MAX_LITERALS)
+            {
+                out[op - lit - 1] = lit - 1;
+                lit = 0;
+                op++;
+            }
+            continue;
+        }
+
+        // close the literal run, or drop its unused control byte
+        if (lit)
+            out[op - lit - 1] = lit - 1;
+        else
+            op--;
+        size_t off = ip - ref - 1;
+        size_t l = match - 2;
+        if (op + (l < 7 ? 2 : 3) + 1 > size)
+            return 0;
+        if (l < 7)
+            out[op++] = (off >> 8) | (l << 5);
+        else
+        {
+            out[op++] = (off >> 8) | (7 << 5);
+            out[op++] = l - 7;
+        }
+        out[op++] = off & 0xFF;
+        lit = 0;
+        op++;
+        ip += match;
+    }
+
+    if (lit)
+        out[op - lit - 1] = lit - 1;
+    else
+        op--;
+    return op;
+}
+
+size_t UWBLzCodec::decode(const uint8_t* in, size_t len, uint8_t* out, size_t size)
+{
+    size_t ip = 0;
+    size_t op = 0;
+    while (ip < len)
+    {
+        uint8_t ctrl = in[ip++];
+        if (ctrl < LZ_MAX_LITERALS)
+        {
+            size_t n = ctrl + 1;
+            if (ip + n > len || op + n > size)
+                return 0;
+            memcpy(&out[op], &in[ip], n);
+            ip += n;
+            op += n;
+            continue;
+        }
+
+        size_t n = ctrl >> 5;
+        if (n == 7)
+        {
+            if (ip >= len)
+                return 0;
+            n += in[ip++];
+        }
+        n += 2;
+        if (ip >= len)
+            return 0;
+        size_t off = (((size_t)(ctrl & 0x1F) << 8) | in[ip++]) + 1;
+        if (off > op || op + n > size)
+            return 0;
+        // byte by byte, the copy may overlap what it writes
+        for (size_t i = 0; i < n; ++i, ++op)
+            out[op] = out[op - off];
+    }
+    return op;
+}
@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#ifndef UWBCODEC_HPP
+#define UWBCODEC_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief payload coding for the in-band data path
+ *
+ * A codec turns a payload in a shorter one and back, with a fixed memory
+ * footprint and no allocation. Every codec has an ID, carried by the
+ * packets it coded, and codecs are negotiated per session by exchanging
+ * the masks of the IDs each side supports, see UWBCompressedData.hpp.
+ *
+ * encode() and decode() return the bytes written, 0 if the output does
+ * not fit size or the input is malformed.
+ */
+class UWBCodec {
+public:
+    enum Id : uint8_t {
+        NONE = 0,       // payload copied as is
+        DELTA = 1,      // UWBDeltaCodec
+        LZ = 2,         // UWBLzCodec
+        MAX_ID = 7
+    };
+
+    static uint8_t mask(uint8_t id) { return 1 << id; }
+
+    virtual ~UWBCodec() = default;
+    virtual uint8_t id() const = 0;
+    virtual size_t encode(const uint8_t* in, size_t len, uint8_t* out, size_t size) = 0;
+    virtual size_t decode(const uint8_t* in, size_t len, uint8_t* out, size_t size) = 0;
+};
+
+/**
+ * @brief integer series: delta, zigzag and varint coding
+ *
+ * Each sample is stored as its difference from the previous one (the first
+ * from 0), zigzag mapped so that small negative differences stay small, in
+ * a varint of 7 bits per byte. A slowly changing series takes one byte per
+ * sample instead of four. Every packet starts from 0, so it decodes alone
+ * when other packets are lost. No state.
+ *
+ * The byte interface takes little endian 32-bit samples. packSamples()
+ * fills a packet with as many samples as fit:
+ *
+ *     size_t n = codec.packSamples(&series[sent], left, slot, room, len);
+ */
+class UWBDeltaCodec : public UWBCodec {
+public:
+    uint8_t id() const override { return DELTA; }
+
+    /**
+     * @brief len must be a multiple of 4
+     *
+     */
+    size_t encode(const uint8_t* in, size_t len, uint8_t* out, size_t size) override;
+    size_t decode(const uint8_t* in, size_t len, uint8_t* out, size_t size) override;
+
+    /**
+     * @brief code the samples that fit in size
+     *
+     * @param written bytes of out used
+     * @return number of samples coded
+     */
+    size_t packSamples(const int32_t* samples, size_t n, uint8_t* out, size_t size, size_t& written);
+
+    /**
+     * @brief decode at most max samples
+     *
+     * @return number of samples decoded, 0 if the input is malformed
+     */
+    size_t unpackSamples(const uint8_t* in, size_t len, int32_t* samples, size_t max);
+};
+
+/**
+ * @brief general payloads: LZ77 with a hashed dictionary
+ *
+ * LZF format: a control byte below 32 is followed by that many plus one
+ * literals, otherwise it holds a match length and, with the next byte, the
+ * distance (up to 8 KB) of an earlier copy of the data. Matches are found
+ * through a table of HASH_SIZE positions, the only memory used; decoding
+ * needs none. Repeated structures such as TLV records and text compress,
+ * random data grows by one byte every 32.
+ */
+class UWBLzCodec : public UWBCodec {
+public:
+    static const uint16_t HASH_SIZE = 256;
+
+    uint8_t id() const override { return LZ; }
+
+    /**
+     * @brief len up to 65535
+     *
+     */
+    size_t encode(const uint8_t* in, size_t len, uint8_t* out, size_t size) override;
+    size_t decode(const uint8_t* in, size_t len, uint8_t* out, size_t size) override;
+
+private:
+    uint16_t table[HASH_SIZE];
+};
+
+#endif /* UWBCODEC_HPP */
@@ -0,0 +1,271 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#include "Arduino.h"
+#include "UWBCompressedData.hpp"
+
+static void put32(uint8_t* p, uint32_t v)
+{
+    for (int i = 0; i < 4; ++i, v >>= 8)
+        p[i] = v & 0xFF;
+}
+
+static uint32_t get32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+UWBCompressedTx::UWBCompressedTx(UWBInBandDataTx& sess)
+    : session(sess), numCodecs(0), current(nullptr)
+{
+    resetReport();
+}
+
+bool UWBCompressedTx::addCodec(UWBCodec& codec)
+{
+    if (numCodecs >= MAX_CODECS)
+        return false;
+    codecList[numCodecs++] = &codec;
+    return true;
+}
+
+uint8_t UWBCompressedTx::codecs() const
+{
+    uint8_t m = UWBCodec::mask(UWBCodec::NONE);
+    for (uint8_t i = 0; i < numCodecs; ++i)
+        m |= UWBCodec::mask(codecList[i]->id());
+    return m;
+}
+
+uint8_t UWBCompressedTx::negotiate(uint8_t peerCodecs)
+{
+    current = nullptr;
+    for (uint8_t i = 0; i < numCodecs && !current; ++i)
+    {
+        if (peerCodecs & UWBCodec::mask(codecList[i]->id()))
+            current = codecList[i];
+    }
+    UWBHAL.Log_I("compressed data %08X: codec %d", session.sessionID(), codec());
+    return codec();
+}
+
+bool UWBCompressedTx::send(const uint8_t* data, size_t len)
+{
+    uint8_t* packet = session.acquire();
+    if (!packet)
+        return false;
+
+    uint32_t t0 = micros();
+    size_t n = current ? current->encode(data, len, &packet[1], ROOM) : 0;
+    stats.packUs += micros() - t0;
+
+    if (n && n < len)
+        packet[0] = current->id();
+    else
+    {
+        // not shorter, or did not fit coded
+        if (len > ROOM)
+            return false;
+        packet[0] = UWBCodec::NONE;
+        memcpy(&packet[1], data, len);
+        n = len;
+        stats.raw++;
+    }
+    session.commit(1 + n);
+    session.poll();
+
+    stats.packets++;
+    stats.inputBytes += len;
+    stats.outputBytes += 1 + n;
+    return true;
+}
+
+size_t UWBCompressedTx::sendSamples(const int32_t* samples, size_t n)
+{
+    if (!n)
+        return 0;
+    uint8_t* packet = session.acquire();
+    if (!packet)
+        return 0;
+
+    size_t count;
+    size_t len;
+    uint32_t t0 = micros();
+    if (codec() == UWBCodec::DELTA)
+    {
+        packet[0] = UWBCodec::DELTA;
+        count = static_cast<UWBDeltaCodec*>(current)->packSamples(samples, n, &packet[1], ROOM, len);
+    }
+    else
+    {
+        packet[0] = UWBCodec::NONE;
+        count = n < ROOM / 4 ? n : ROOM / 4;
+        for (size_t i = 0; i < count; ++i)
+            put32(&packet[1 + 4 * i], samples[i]);
+        len = 4 * count;
+        stats.raw++;
+    }
+    stats.packUs += micros() - t0;
+
+    session.commit(1 + len);
+    session.poll();
+
+    stats.packets++;
+    stats.samples += count;
+    stats.inputBytes += 4 * count;
+    stats.outputBytes += 1 + len;
+    return count;
+}
+
+UWBCompressedTx::Report UWBCompressedTx::report() const
+{
+    Report rep = stats;
+    rep.ratio = rep.outputBytes ? (float)rep.inputBytes / rep.outputBytes : 0;
+    rep.samplesPerPacket = rep.packets ? (float)rep.samples / rep.packets : 0;
+    rep.usPerPack = rep.packets ? rep.packUs / rep.packets : 0;
+    rep.cyclesPerPack = rep.packets ? (uint32_t)((uint64_t)rep.packUs * UWB_CPU_MHZ / rep.packets) : 0;
+    return rep;
+}
+
+void UWBCompressedTx::resetReport()
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+void UWBCompressedTx::printReport() const
+{
+    Report rep = report();
+    UWBHAL.Log_I("compressed data %08X: codec %d, %lu packets (%lu not coded), %lu -> %lu bytes, ratio %d.%02d",
+                 session.sessionID(), codec(), rep.packets, rep.raw, rep.inputBytes, rep.outputBytes,
+                 (int)rep.ratio, (int)(rep.ratio * 100) % 100);
+    UWBHAL.Log_I("  %d.%d samples/packet, %lu us (%lu cycles) per pack",
+                 (int)rep.samplesPerPacket, (int)(rep.samplesPerPacket * 10) % 10, rep.usPerPack, rep.cyclesPerPack);
+}
+
+UWBCompressedRx::UWBCompressedRx(UWBInBandDataRx& sess)
+    : session(sess), numCodecs(0)
+{
+    resetReport();
+}
+
+bool UWBCompressedRx::addCodec(UWBCodec& codec)
+{
+    if (numCodecs >= MAX_CODECS)
+        return false;
+    codecList[numCodecs++] = &codec;
+    return true;
+}
+
+uint8_t UWBCompressedRx::codecs() const
+{
+    uint8_t m = UWBCodec::mask(UWBCodec::NONE);
+    for (uint8_t i = 0; i < numCodecs; ++i)
+        m |= UWBCodec::mask(codecList[i]->id());
+    return m;
+}
+
+UWBCodec* UWBCompressedRx::find(uint8_t id) const
+{
+    for (uint8_t i = 0; i < numCodecs; ++i)
+    {
+        if (codecList[i]->id() == id)
+            return codecList[i];
+    }
+    return nullptr;
+}
+
+int UWBCompressedRx::read(uint8_t* out, size_t size)
+{
+    UWBInBandDataRx::Span span;
+    if (!session.peek(span))
+        return 0;
+
+    int res = -1;
+    if (span.len)
+    {
+        uint8_t id = span.data[0];
+        UWBCodec* codec = find(id);
+        uint32_t t0 = micros();
+        if (id == UWBCodec::NONE)
+        {
+            if (span.len - 1u <= size)
+            {
+                memcpy(out, &span.data[1], span.len - 1);
+                res = span.len - 1;
+            }
+        }
+        else if (codec)
+        {
+            size_t n = codec->decode(&span.data[1], span.len - 1, out, size);
+            if (n)
+                res = n;
+        }
+        stats.unpackUs += micros() - t0;
+
+        if (id != UWBCodec::NONE && !codec)
+            stats.unsupported++;
+        else if (res < 0)
+            stats.malformed++;
+    }
+    else
+        stats.malformed++;
+
+    stats.packets++;
+    stats.inputBytes += span.len;
+    if (res > 0)
+        stats.outputBytes += res;
+    session.release();
+    return res;
+}
+
+int UWBCompressedRx::readSamples(int32_t* samples, size_t max)
+{
+    UWBInBandDataRx::Span span;
+    if (!session.peek(span))
+        return 0;
+
+    // DELTA decodes to samples directly, the others to little endian words
+    UWBCodec* delta = span.len ? find(UWBCodec::DELTA) : nullptr;
+    if (!delta || span.data[0] != UWBCodec::DELTA)
+    {
+        int n = read((uint8_t*)samples, max * 4);
+        if (n <= 0)
+            return n;
+        for (int i = 0; i < n / 4; ++i)
+            samples[i] = get32((const uint8_t*)&samples[i]);
+        return n / 4;
+    }
+
+    uint32_t t0 = micros();
+    size_t n = static_cast<UWBDeltaCodec*>(delta)->unpackSamples(&span.data[1], span.len - 1, samples, max);
+    stats.unpackUs += micros() - t0;
+
+    stats.packets++;
+    stats.inputBytes += span.len;
+    stats.outputBytes += 4 * n;
+    if (!n && span.len > 1)
+        stats.malformed++;
+    session.release();
+    return n || span.len == 1 ? (int)n : -1;
+}
+
+UWBCompressedRx::Report UWBCompressedRx::report() const
+{
+    Report rep = stats;
+    rep.usPerUnpack = rep.packets ? rep.unpackUs / rep.packets : 0;
+    rep.cyclesPerUnpack = rep.packets ? (uint32_t)((uint64_t)rep.unpackUs * UWB_CPU_MHZ / rep.packets) : 0;
+    return rep;
+}
+
+void UWBCompressedRx::resetReport()
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+void UWBCompressedRx::printReport() const
+{
+    Report rep = report();
+    UWBHAL.Log_I("compressed data %08X: %lu packets, %lu -> %lu bytes, %lu unsupported, %lu malformed",
+                 session.sessionID(), rep.packets, rep.inputBytes, rep.outputBytes, rep.unsupported, rep.malformed);
+    UWBHAL.Log_I("  %lu us (%lu cycles) per unpack", rep.usPerUnpack, rep.cyclesPerUnpack);
+}
@@ -0,0 +1,182 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#ifndef UWBCOMPRESSEDDATA_HPP
+#define UWBCOMPRESSEDDATA_HPP
+
+#include "UWBInbandDataTx.hpp"
+#include "UWBInbandDataRx.hpp"
+#include "UWBCodec.hpp"
+
+#ifndef UWB_CPU_MHZ
+#define UWB_CPU_MHZ 64      // nRF52840, converts the measured times to cycles
+#endif
+
+/**
+ * @brief Compressed packets over a UWBInBandDataTx session
+ *
+ * Each packet is coded in place in the session's TX ring: one byte with the
+ * codec ID, then the coded payload. A payload the codec cannot shorten goes
+ * as is, with the NONE ID, so that a packet never grows by more than the ID
+ * byte.
+ *
+ * The codec is negotiated per session: both sides register the codecs they
+ * have, in order of preference on the sending side, the receiver's mask
+ * (UWBCompressedRx::codecs()) is carried to the sender on the session setup
+ * channel (BLE, a UWBReliableChannel...) and negotiate() picks the first
+ * codec of the sender the receiver knows:
+ *
+ *     UWBDeltaCodec delta;
+ *     UWBLzCodec lz;
+ *     UWBCompressedTx tx(session);
+ *     tx.addCodec(delta);
+ *     tx.addCodec(lz);
+ *     tx.negotiate(peerCodecs);
+ *     ...
+ *     size_t n = tx.sendSamples(&series[sent], count - sent);   // as many as fit
+ *
+ * The report gives the samples per packet, the compression ratio and the
+ * average duration of a pack, in microseconds and in cycles (UWB_CPU_MHZ).
+ */
+class UWBCompressedTx {
+public:
+    static const uint8_t MAX_CODECS = 4;
+    static const uint8_t ROOM = uwb::MAX_APP_DATA_SIZE - 1;
+
+    /**
+     * @brief statistics since the last resetReport()
+     *
+     */
+    struct Report {
+        uint32_t packets;
+        uint32_t raw;               // packets sent without coding
+        uint32_t inputBytes;
+        uint32_t outputBytes;       // codec ID included
+        uint32_t samples;
+        uint32_t packUs;            // total time spent coding
+        float ratio;                // inputBytes / outputBytes
+        float samplesPerPacket;
+        uint32_t usPerPack;
+        uint32_t cyclesPerPack;
+    };
+
+    UWBCompressedTx(UWBInBandDataTx& session);
+
+    /**
+     * @brief register a codec, in order of preference
+     *
+     * @return false if MAX_CODECS are registered already
+     */
+    bool addCodec(UWBCodec& codec);
+
+    /**
+     * @brief mask of the registered codec IDs, NONE included
+     *
+     */
+    uint8_t codecs() const;
+
+    /**
+     * @brief choose the first registered codec in the peer's mask
+     *
+     * @return the codec ID chosen, NONE if there's no common one
+     */
+    uint8_t negotiate(uint8_t peerCodecs);
+
+    uint8_t codec() const { return current ? current->id() : (uint8_t)UWBCodec::NONE; }
+
+    /**
+     * @brief code a payload in a packet and queue it
+     *
+     * @return false if the TX ring is full or the payload does not fit a packet
+     */
+    bool send(const uint8_t* data, size_t len);
+
+    /**
+     * @brief queue a packet with as many samples as fit
+     *
+     * The samples are coded with the DELTA codec if it was negotiated, else
+     * they go as 32-bit little endian words.
+     *
+     * @return number of samples sent, 0 if the TX ring is full
+     */
+    size_t sendSamples(const int32_t* samples, size_t n);
+
+    void poll() { session.poll(); }
+
+    Report report() const;
+    void resetReport();
+    void printReport() const;
+
+private:
+    UWBInBandDataTx& session;
+    UWBCodec* codecList[MAX_CODECS];
+    uint8_t numCodecs;
+    UWBCodec* current;
+    Report stats;
+};
+
+/**
+ * @brief Decodes the packets of a UWBCompressedTx received by a UWBInBandDataRx
+ *
+ * The packets are decoded from the session's RX ring with the codec their ID
+ * names; packets of a codec not registered are dropped and counted.
+ */
+class UWBCompressedRx {
+public:
+    static const uint8_t MAX_CODECS = 4;
+
+    /**
+     * @brief statistics since the last resetReport()
+     *
+     */
+    struct Report {
+        uint32_t packets;
+        uint32_t inputBytes;        // codec ID included
+        uint32_t outputBytes;
+        uint32_t unsupported;       // packets of a codec not registered
+        uint32_t malformed;         // packets that did not decode, or fit the buffer
+        uint32_t unpackUs;
+        uint32_t usPerUnpack;
+        uint32_t cyclesPerUnpack;
+    };
+
+    UWBCompressedRx(UWBInBandDataRx& session);
+
+    bool addCodec(UWBCodec& codec);
+
+    /**
+     * @brief mask of the registered codec IDs, NONE included, for the sender's negotiate()
+     *
+     */
+    uint8_t codecs() const;
+
+    /**
+     * @brief decode the oldest packet received
+     *
+     * @return the bytes written to out, 0 if no packet is waiting, -1 if the
+     * packet was dropped
+     */
+    int read(uint8_t* out, size_t size);
+
+    /**
+     * @brief decode the oldest packet received as 32-bit samples
+     *
+     * @return the samples written, 0 if no packet is waiting, -1 if the
+     * packet was dropped
+     */
+    int readSamples(int32_t* samples, size_t max);
+
+    Report report() const;
+    void resetReport();
+    void printReport() const;
+
+private:
+    UWBCodec* find(uint8_t id) const;
+
+    UWBInBandDataRx& session;
+    UWBCodec* codecList[MAX_CODECS];
+    uint8_t numCodecs;
+    Report stats;
+};
+
+#endif /* UWBCOMPRESSEDDATA_HPP */
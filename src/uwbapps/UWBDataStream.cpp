@@ -0,0 +1,283 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#include "Arduino.h"
+#include "UWBDataStream.hpp"
+
+static void put16(uint8_t* p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void put32(uint8_t* p, uint32_t v)
+{
+    for (int i = 0; i < 4; ++i, v >>= 8)
+        p[i] = v & 0xFF;
+}
+
+static uint16_t get16(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+UWBDataStreamTx::UWBDataStreamTx(UWBInBandDataTx& sess, uint8_t packets)
+    : session(sess), payload(nullptr), length(0), fragments(0), next(0), messageId(0),
+      pendingMessage(false), messageFailed(false), sent(0), completed(0)
+{
+    baseSeq = session.sequenceNumber();
+    window(packets);
+    resetReport();
+}
+
+void UWBDataStreamTx::window(uint8_t packets)
+{
+    // the chip's queue and the TX ring bound the packets in flight
+    uint8_t max = session.dataBlocks() < MAX_WINDOW ? session.dataBlocks() : MAX_WINDOW;
+    if (packets > max)
+        packets = max;
+    win = packets ? packets : 1;
+}
+
+bool UWBDataStreamTx::send(const uint8_t* data, uint32_t len)
+{
+    // the fragment index is 16 bit on the air
+    uint32_t n = UWBDataFragment::count(len);
+    if (!done() || (!data && len) || n > 0xFFFF)
+        return false;
+    payload = data;
+    length = len;
+    fragments = n;
+    next = 0;
+    messageId++;
+    pendingMessage = true;
+    messageFailed = false;
+    return true;
+}
+
+bool UWBDataStreamTx::done() const
+{
+    return next >= fragments && inFlight() == 0;
+}
+
+void UWBDataStreamTx::poll()
+{
+    while (next < fragments && inFlight() < win)
+    {
+        // fragments are built in the session's TX ring, no copy on the way to the chip
+        uint8_t* packet = session.acquire();
+        if (!packet)
+            break;
+
+        bool first = next == 0;
+        uint32_t offset = UWBDataFragment::offset(next);
+        uint32_t room = first ? UWBDataFragment::FIRST_PAYLOAD : UWBDataFragment::PAYLOAD;
+        uint32_t n = length - offset < room ? length - offset : room;
+        uint8_t header = first ? UWBDataFragment::FIRST_HEADER_SIZE : UWBDataFragment::HEADER_SIZE;
+
+        packet[0] = (first ? UWBDataFragment::FIRST : 0) | (next + 1 == fragments ? UWBDataFragment::LAST : 0);
+        packet[1] = messageId;
+        put16(&packet[2], next);
+        if (first)
+            put32(&packet[4], length);
+        memcpy(&packet[header], &payload[offset], n);
+
+        sizes[sent % MAX_WINDOW] = n;
+        session.commit(header + n);
+        sent++;
+        next++;
+    }
+    session.poll();
+
+    if (pendingMessage && done())
+    {
+        pendingMessage = false;
+        if (!messageFailed)
+            messages++;
+    }
+}
+
+void UWBDataStreamTx::dataTransmitted(uwb::DataTransmit& ntf)
+{
+    if (!session.dataTransmitted(ntf))
+        return;
+
+    // this stream owns the session's data path, the sequence numbers follow each other
+    uint16_t k = ntf.transmitNtf_sequence_number - baseSeq;
+    if ((uint16_t)(k - completed) >= inFlight())
+        return;
+
+    if (ntf.transmitNtf_status == UWBInBandDataTx::TX_OK || ntf.transmitNtf_status == UWBInBandDataTx::TX_REPETITION_OK)
+    {
+        packets++;
+        bytes += sizes[k % MAX_WINDOW];
+    }
+    else
+    {
+        failed++;
+        messageFailed = true;
+    }
+    completed++;
+}
+
+void UWBDataStreamTx::update(UWBRangingData& data)
+{
+    if (data.sessionHandle() == session.sessionID())
+        rounds++;
+}
+
+UWBDataStreamTx::Report UWBDataStreamTx::report() const
+{
+    Report rep;
+    rep.messages = messages;
+    rep.packets = packets;
+    rep.failed = failed;
+    rep.bytes = bytes;
+    rep.rounds = rounds;
+    rep.elapsedMs = millis() - startTime;
+    rep.bytesPerRound = rep.rounds ? (float)rep.bytes / rep.rounds : 0;
+    rep.packetsPerRound = rep.rounds ? (float)rep.packets / rep.rounds : 0;
+    rep.bytesPerSecond = rep.elapsedMs ? rep.bytes * 1000.0f / rep.elapsedMs : 0;
+    return rep;
+}
+
+void UWBDataStreamTx::resetReport()
+{
+    messages = 0;
+    packets = 0;
+    failed = 0;
+    bytes = 0;
+    rounds = 0;
+    startTime = millis();
+}
+
+void UWBDataStreamTx::printReport() const
+{
+    Report rep = report();
+    UWBHAL.Log_I("data stream %08X: %lu payloads, %lu packets (%lu failed), %lu bytes in %lu rounds",
+                 session.sessionID(), rep.messages, rep.packets, rep.failed, rep.bytes, rep.rounds);
+    UWBHAL.Log_I("  goodput %d.%d bytes/round, %d B/s, %d%% of the data phases used, window %d",
+                 (int)rep.bytesPerRound, (int)(rep.bytesPerRound * 10) % 10, (int)rep.bytesPerSecond,
+                 (int)(rep.packetsPerRound * 100), win);
+}
+
+UWBDataStreamRx::UWBDataStreamRx(UWBInBandDataRx& sess)
+    : session(sess), buffer(nullptr), size(0), state(IDLE), messageId(0), expected(0), total(0), received(0)
+{
+    resetReport();
+}
+
+void UWBDataStreamRx::receiveInto(uint8_t* buf, uint32_t len)
+{
+    buffer = buf;
+    size = len;
+    state = buf ? WAITING : IDLE;
+}
+
+void UWBDataStreamRx::poll()
+{
+    UWBInBandDataRx::Span span;
+    while (session.peek(span))
+    {
+        fragment(span.data, span.len);
+        session.release();
+    }
+}
+
+void UWBDataStreamRx::fragment(const uint8_t* p, uint16_t len)
+{
+    if (len < UWBDataFragment::HEADER_SIZE)
+        return;
+
+    uint8_t flags = p[0];
+    uint16_t index = get16(&p[2]);
+    stats.packets++;
+
+    if (flags & UWBDataFragment::FIRST)
+    {
+        if (len < UWBDataFragment::FIRST_HEADER_SIZE)
+            return;
+        if (state == RECEIVING)
+            stats.lost++;       // the previous payload never ended
+        if (state == IDLE || state == COMPLETE || get32(&p[4]) > size)
+        {
+            stats.overflows++;
+            if (state == RECEIVING)
+                state = WAITING;
+            return;
+        }
+        state = RECEIVING;
+        messageId = p[1];
+        total = get32(&p[4]);
+        received = 0;
+        expected = 0;
+    }
+    if (state != RECEIVING)
+        return;
+    if (p[1] != messageId || index != expected)
+    {
+        stats.lost++;
+        state = WAITING;
+        return;
+    }
+
+    uint8_t header = index ? UWBDataFragment::HEADER_SIZE : UWBDataFragment::FIRST_HEADER_SIZE;
+    uint32_t n = len - header;
+    uint32_t offset = UWBDataFragment::offset(index);
+    if (offset + n > total)
+    {
+        stats.lost++;
+        state = WAITING;
+        return;
+    }
+    memcpy(&buffer[offset], &p[header], n);
+    received += n;
+    expected++;
+
+    if (flags & UWBDataFragment::LAST)
+    {
+        if (received == total)
+        {
+            stats.messages++;
+            stats.bytes += total;
+            state = COMPLETE;
+        }
+        else
+        {
+            stats.lost++;
+            state = WAITING;
+        }
+    }
+}
+
+void UWBDataStreamRx::update(UWBRangingData& data)
+{
+    if (data.sessionHandle() == session.sessionID())
+        stats.rounds++;
+}
+
+UWBDataStreamRx::Report UWBDataStreamRx::report() const
+{
+    Report rep = stats;
+    rep.bytesPerRound = rep.rounds ? (float)rep.bytes / rep.rounds : 0;
+    return rep;
+}
+
+void UWBDataStreamRx::resetReport()
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+void UWBDataStreamRx::printReport() const
+{
+    Report rep = report();
+    UWBHAL.Log_I("data stream %08X: %lu payloads, %lu packets, %lu bytes in %lu rounds, %d.%d bytes/round",
+                 session.sessionID(), rep.messages, rep.packets, rep.bytes, rep.rounds,
+                 (int)rep.bytesPerRound, (int)(rep.bytesPerRound * 10) % 10);
+    UWBHAL.Log_I("  %lu payloads lost, %lu dropped without buffer", rep.lost, rep.overflows);
+}
@@ -0,0 +1,271 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#ifndef UWBDATASTREAM_HPP
+#define UWBDATASTREAM_HPP
+
+#include "UWBInbandDataTx.hpp"
+#include "UWBInbandDataRx.hpp"
+#include "UWBRangingData.hpp"
+
+/**
+ * @brief Fragment header of the in-band data streams, little endian
+ *
+ *     0   flags (FIRST, LAST)
+ *     1   message ID
+ *     2   fragment index (2 bytes)
+ *     4   message length (4 bytes), first fragment only
+ */
+struct UWBDataFragment {
+    static const uint8_t FIRST = 0x01;
+    static const uint8_t LAST = 0x02;
+    static const uint8_t HEADER_SIZE = 4;
+    static const uint8_t FIRST_HEADER_SIZE = 8;
+    static const uint8_t PAYLOAD = uwb::MAX_APP_DATA_SIZE - HEADER_SIZE;
+    static const uint8_t FIRST_PAYLOAD = uwb::MAX_APP_DATA_SIZE - FIRST_HEADER_SIZE;
+
+    /**
+     * @brief offset in the message of a fragment's payload
+     *
+     */
+    static uint32_t offset(uint16_t index) {
+        return index ? FIRST_PAYLOAD + (uint32_t)(index - 1) * PAYLOAD : 0;
+    }
+
+    /**
+     * @brief number of fragments of a message
+     *
+     */
+    static uint32_t count(uint32_t len) {
+        if (len <= FIRST_PAYLOAD)
+            return 1;
+        // rounded up without overflowing for lengths close to 4 GB
+        uint32_t rest = len - FIRST_PAYLOAD;
+        return 1 + rest / PAYLOAD + (rest % PAYLOAD ? 1 : 0);
+    }
+};
+
+/**
+ * @brief Sends payloads of any length over a UWBInBandDataTx session
+ *
+ * A payload is cut in fragments of up to uwb::MAX_APP_DATA_SIZE bytes, see
+ * UWBDataFragment, built in place in the session's TX ring. Only one packet goes out per ranging round, so rather
+ * than waiting for each DATA_TRANSMIT_NTF before sending the next fragment,
+ * up to window() fragments are kept queued in the chip: the next one is
+ * always ready for the next data phase and the stream uses every round.
+ * Each notification frees a place in the window.
+ *
+ * Notifications come in the callbacks, poll() does the sending from loop():
+ *
+ *     UWBInBandDataTx session(0x1234, src, dst);
+ *     UWBDataStreamTx stream(session);
+ *
+ *     void txHandler(uwb::DataTransmit& ntf) { stream.dataTransmitted(ntf); }
+ *     void rangingHandler(UWBRangingData& data) { stream.update(data); }
+ *
+ *     UWB.registerDataTxCallback(txHandler);
+ *     UWB.registerRangingCallback(rangingHandler);
+ *     ...
+ *     stream.send(log, logSize);          // log must stay valid until done()
+ *     void loop() { stream.poll(); }
+ *
+ * Delivery is not guaranteed: a failed fragment is counted and skipped.
+ */
+class UWBDataStreamTx {
+public:
+    static const uint8_t MAX_WINDOW = UWBInBandDataTx::TX_SLOTS;
+
+    /**
+     * @brief transfer statistics since the last resetReport()
+     *
+     */
+    struct Report {
+        uint32_t messages;          // payloads sent without any failed fragment
+        uint32_t packets;           // fragments confirmed by the chip
+        uint32_t failed;            // fragments reported as failed
+        uint32_t bytes;             // payload bytes confirmed, headers excluded
+        uint32_t rounds;            // ranging rounds seen
+        uint32_t elapsedMs;
+        float bytesPerRound;        // goodput
+        float packetsPerRound;      // 1.0 when every data phase is used
+        float bytesPerSecond;
+    };
+
+    /**
+     * @brief Construct a new UWBDataStreamTx object
+     *
+     * @param session
+     * @param window fragments queued in the chip, at most the session's data blocks
+     */
+    UWBDataStreamTx(UWBInBandDataTx& session, uint8_t window = 2);
+
+    /**
+     * @brief set the number of fragments queued in the chip
+     *
+     */
+    void window(uint8_t packets);
+    uint8_t window() const { return win; }
+
+    /**
+     * @brief start sending a payload, not copied
+     *
+     * @param data must stay valid until done()
+     * @param len
+     * @return false if a payload is being sent, or if it needs more than
+     * 65535 fragments, the most the fragment index can number
+     */
+    bool send(const uint8_t* data, uint32_t len);
+
+    /**
+     * @brief true once every fragment of the last payload was confirmed or failed
+     *
+     */
+    bool done() const;
+
+    /**
+     * @brief fragments handed to the chip and not confirmed yet
+     *
+     */
+    uint8_t inFlight() const { return (uint16_t)(sent - completed); }
+
+    /**
+     * @brief queue fragments while the window allows, call it from loop()
+     *
+     */
+    void poll();
+
+    /**
+     * @brief pass the DATA_TRANSMIT_NTF notifications, from the callback,
+     * instead of UWBInBandDataTx::dataTransmitted()
+     *
+     */
+    void dataTransmitted(uwb::DataTransmit& ntf);
+
+    /**
+     * @brief pass the ranging notifications to count the rounds, from the callback
+     *
+     */
+    void update(UWBRangingData& data);
+
+    Report report() const;
+    void resetReport();
+    void printReport() const;
+
+private:
+    UWBInBandDataTx& session;
+    uint8_t win;
+    const uint8_t* payload;
+    uint32_t length;
+    uint32_t fragments;
+    uint32_t next;              // next fragment to send
+    uint8_t messageId;
+    bool pendingMessage;        // sent, not counted in the report yet
+    volatile bool messageFailed;    // a fragment of it failed, written by the callback
+    uint16_t baseSeq;           // session sequence number of the first packet
+    uint16_t sent;              // committed, written by poll() only
+    volatile uint16_t completed;    // written by the callback only
+    uint8_t sizes[MAX_WINDOW];  // payload bytes of the packets in flight
+    volatile uint32_t packets;
+    volatile uint32_t failed;
+    volatile uint32_t bytes;
+    volatile uint32_t rounds;
+    uint32_t messages;
+    uint32_t startTime;
+};
+
+/**
+ * @brief Reassembles the payloads of a UWBDataStreamTx into caller buffers
+ *
+ * poll() takes the fragments from the session's RX ring and copies them to
+ * their place in the buffer given to receiveInto(). Once a payload is
+ * complete available() is true until the buffer is given back with
+ * receiveInto() (the same buffer or another one), payloads arriving
+ * meanwhile are dropped and counted.
+ *
+ *     UWBInBandDataRx session(0x1234, src, dst);
+ *     UWBDataStreamRx stream(session);
+ *     uint8_t buffer[4096];
+ *
+ *     void rxHandler(uwb::DataPacket& packet) { session.dataReceived(packet); }
+ *     UWB.registerDataRxCallback(rxHandler);
+ *     stream.receiveInto(buffer, sizeof(buffer));
+ *     ...
+ *     void loop() {
+ *         stream.poll();
+ *         if (stream.available()) {
+ *             process(buffer, stream.length());
+ *             stream.receiveInto(buffer, sizeof(buffer));
+ *         }
+ *     }
+ *
+ * A missing fragment drops the whole payload.
+ */
+class UWBDataStreamRx {
+public:
+    /**
+     * @brief reception statistics since the last resetReport()
+     *
+     */
+    struct Report {
+        uint32_t messages;          // payloads reassembled
+        uint32_t packets;           // fragments received
+        uint32_t bytes;             // payload bytes of the reassembled payloads
+        uint32_t lost;              // payloads dropped for a missing fragment
+        uint32_t overflows;         // payloads dropped, no buffer or too large
+        uint32_t rounds;            // ranging rounds seen
+        float bytesPerRound;        // goodput
+    };
+
+    UWBDataStreamRx(UWBInBandDataRx& session);
+
+    /**
+     * @brief buffer for the next payload, also releases the previous one
+     *
+     */
+    void receiveInto(uint8_t* buffer, uint32_t size);
+
+    /**
+     * @brief true if a payload is complete in the buffer
+     *
+     */
+    bool available() const { return state == COMPLETE; }
+
+    /**
+     * @brief length of the complete payload
+     *
+     */
+    uint32_t length() const { return available() ? total : 0; }
+
+    /**
+     * @brief reassemble the fragments waiting in the session's RX ring, call it from loop()
+     *
+     */
+    void poll();
+
+    /**
+     * @brief pass the ranging notifications to count the rounds, from the callback
+     *
+     */
+    void update(UWBRangingData& data);
+
+    Report report() const;
+    void resetReport();
+    void printReport() const;
+
+private:
+    enum State : uint8_t { IDLE, WAITING, RECEIVING, COMPLETE };
+
+    void fragment(const uint8_t* p, uint16_t len);
+
+    UWBInBandDataRx& session;
+    uint8_t* buffer;
+    uint32_t size;
+    State state;
+    uint8_t messageId;
+    uint16_t expected;          // next fragment index
+    uint32_t total;
+    uint32_t received;
+    Report stats;
+};
+
+#endif /* UWBDATASTREAM_HPP */
@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#include "UWBInbandDataRx.hpp"
+
+UWBInBandDataRx::UWBInBandDataRx(uint32_t session_ID, UWBMacAddress srcAddr,
+                                 UWBMacAddress dstAddr, uint8_t dataBlocks)
+    : destination(dstAddr), blocks(dataBlocks), written(0), read(0), hasLast(false), lastSeq(0)
+{
+    sessionID(session_ID);
+    sessionType(uwb::SessionType::RANGING_WITH_DATA);
+
+    rangingParams.deviceRole(uwb::DeviceRole::RESPONDER);
+    rangingParams.deviceType(uwb::DeviceType::CONTROLEE);
+    rangingParams.multiNodeMode(uwb::MultiNodeMode::UNICAST);
+    rangingParams.rangingRoundUsage(uwb::RangingMethod::DS_TWR);
+    rangingParams.scheduledMode(uwb::ScheduledMode::TIME_SCHEDULED);
+    rangingParams.noOfControlees(1);
+    rangingParams.deviceMacAddr(srcAddr);
+    rangingParams.destinationMacAddr(dstAddr);
+
+    //SP1, link layer bypass, see UWBPreset.cpp
+    appParams.load(UWBPreset::inbandData.data, UWBPreset::inbandData.size);
+
+    size = blocks < RX_SLOTS ? blocks : RX_SLOTS;
+    if (!size)
+        size = 1;
+    resetStats();
+}
+
+bool UWBInBandDataRx::dataReceived(uwb::DataPacket& packet)
+{
+    if (packet.session_handle != sessionID())
+        return false;
+
+    uint16_t seq = packet.sequence_number;
+    if (hasLast)
+    {
+        int16_t ahead = seq - lastSeq;
+        if (ahead <= 0)
+            counters.outOfOrder++;
+        else
+            counters.missing += ahead - 1;
+    }
+    if (!hasLast || (int16_t)(seq - lastSeq) > 0)
+        lastSeq = seq;
+    hasLast = true;
+
+    uint8_t fill = available();
+    if (fill >= size)
+    {
+        counters.overruns++;
+        return true;
+    }
+
+    uint16_t len = packet.data_size;
+    if (len > uwb::MAX_APP_DATA_SIZE)
+    {
+        counters.truncated++;
+        len = uwb::MAX_APP_DATA_SIZE;
+    }
+    uint8_t i = written % size;
+    memcpy(slots[i], packet.data, len);
+    lengths[i] = len;
+    seqs[i] = seq;
+    written = (written + 1) % (2 * size);
+
+    counters.received++;
+    if (fill + 1 > counters.maxFill)
+        counters.maxFill = fill + 1;
+    return true;
+}
+
+bool UWBInBandDataRx::peek(Span& span)
+{
+    if (!available())
+        return false;
+    uint8_t i = read % size;
+    span.data = slots[i];
+    span.len = lengths[i];
+    span.sequenceNumber = seqs[i];
+    return true;
+}
+
+void UWBInBandDataRx::release()
+{
+    if (available())
+        read = (read + 1) % (2 * size);
+}
+
+void UWBInBandDataRx::resetStats()
+{
+    memset(&counters, 0, sizeof(counters));
+}
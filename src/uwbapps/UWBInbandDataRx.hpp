@@ -4,62 +4,111 @@
 #ifndef UWBINBANDDATARX_HPP
 #define UWBINBANDDATARX_HPP
 
-extern "C" {
-    extern void *dataRcvNtfSemTx;
-    extern uint8_t dataReceived[];
-};
-
-
 #include "UWB.hpp"
 #include "UWBSession.hpp"
 #include "UWBMacAddress.hpp"
+#include "UWBPreset.hpp"
 
 /*
 * This class will setup a ranging session with in-band data reception capabilities.
-* When the data is received it will be signaled in the userCallback by receiving a
-* notification of type DataReceived.
+* Every session has its own RX ring, one slot per data block the chip buffers
+* (SESSION_INBAND_DATA_RX_BLOCKS, at most RX_SLOTS): the DATA_RCV_NTF payloads
+* are copied once, from the notification to a slot, and then read in place.
+*
+*     void rxHandler(uwb::DataPacket& packet) { rx.dataReceived(packet); }
+*     UWB.registerDataRxCallback(rxHandler);
+*     ...
+*     UWBInBandDataRx::Span span;
+*     while (rx.peek(span)) {
+*         process(span.data, span.len);
+*         rx.release();
+*     }
+*
+* When the application does not keep up the newest packets are dropped and
+* counted as overruns. Sequence numbers are checked on arrival: gaps count
+* the packets missed, older or repeated numbers count as out of order.
+* UWBDataStreamRx reassembles the payloads sent by a UWBDataStreamTx.
 */
 
 class UWBInBandDataRx : public UWBSession {
-public:   
-    UWBInBandDataRx(uint32_t session_ID, UWBMacAddress srcAddr, 
-                    UWBMacAddress dstAddr, uint32_t dataBlocks = 12)
-        : destination(dstAddr) 
-    {
-        sessionID(session_ID);
-        sessionType(uwb::SessionType::RANGING_WITH_DATA_TRANSFER);
-        
-        // Set ranging parameters using HAL types
-        rangingParams.setDeviceRole(uwb::DeviceRole::RESPONDER);
-        rangingParams.setDeviceType(uwb::DeviceType::CONTROLEE);
-        rangingParams.setMultiNodeMode(uwb::MultiNodeMode::UNICAST);
-        rangingParams.setRangingRoundUsage(uwb::RangingRoundUsage::DS_TWR);
-        rangingParams.setScheduleMode(uwb::ScheduleMode::TIME_SCHEDULED);
-        rangingParams.setDeviceMacAddr(srcAddr);
-
-        // Set app parameters
-        appParams.addOrUpdateParam(AppConfigId::NO_OF_CONTROLEES, 
-                                    AppParamType::U32, 1);
-        appParams.setDstMacAddr(dstAddr);
-        setDefaults();
-
-        // Link layer and frame config
-        appParams.addOrUpdateParam(AppConfigId::LINK_LAYER_MODE, 
-                                    AppParamType::U32, 
-                                    static_cast<uint32_t>(uwb::LinkLayerMode::BYPASS));
-        appParams.addOrUpdateParam(AppConfigId::RFRAME_CONFIG, 
-                                    AppParamType::U32,
-                                    static_cast<uint32_t>(uwb::RFrameConfig::SP1));
-
-        // Vendor specific data transfer parameters
-        vendorParams.addOrUpdateParam(VendorAppConfigId::SESSION_INBAND_DATA_TX_BLOCKS, 
-                                       AppParamType::U32, 0);
-        vendorParams.addOrUpdateParam(VendorAppConfigId::SESSION_INBAND_DATA_RX_BLOCKS, 
-                                       AppParamType::U32, dataBlocks);
-    }
+public:
+    static const uint8_t RX_SLOTS = 12;
+
+    /**
+     * @brief a received packet, valid until release()
+     *
+     */
+    struct Span {
+        const uint8_t* data;
+        uint16_t len;
+        uint16_t sequenceNumber;
+    };
+
+    /**
+     * @brief ring statistics
+     *
+     */
+    struct Stats {
+        uint32_t received;      // packets stored in the ring
+        uint32_t overruns;      // packets dropped, ring full
+        uint32_t missing;       // sequence numbers skipped
+        uint32_t outOfOrder;    // packets older than, or equal to, the last one
+        uint32_t truncated;     // packets longer than a slot
+        uint8_t maxFill;        // highest number of packets waiting
+    };
+
+    UWBInBandDataRx(uint32_t session_ID, UWBMacAddress srcAddr,
+                    UWBMacAddress dstAddr, uint8_t dataBlocks = 12);
+
+    /**
+     * @brief pass the DATA_RCV_NTF notifications, from the callback
+     *
+     * @return true if the packet is for this session
+     */
+    bool dataReceived(uwb::DataPacket& packet);
+
+    /**
+     * @brief get the oldest packet not released
+     *
+     * @return false if there's none
+     */
+    bool peek(Span& span);
+
+    /**
+     * @brief free the packet returned by peek()
+     *
+     */
+    void release();
+
+    /**
+     * @brief number of packets waiting
+     *
+     */
+    uint8_t available() const { return (written + 2 * size - read) % (2 * size); }
+
+    /**
+     * @brief packets the chip can buffer (SESSION_INBAND_DATA_RX_BLOCKS)
+     *
+     */
+    uint8_t dataBlocks() const { return blocks; }
+
+    const Stats& stats() const { return counters; }
+    void resetStats();
 
 private:
     UWBMacAddress destination;
+    uint8_t blocks;
+    uint8_t size;                   // slots in use, blocks up to RX_SLOTS
+
+    uint8_t slots[RX_SLOTS][uwb::MAX_APP_DATA_SIZE];
+    uint8_t lengths[RX_SLOTS];
+    uint16_t seqs[RX_SLOTS];
+    // positions modulo 2 * size, to tell a full ring from an empty one
+    volatile uint8_t written;       // callback only
+    volatile uint8_t read;          // application only
+    bool hasLast;
+    uint16_t lastSeq;
+    Stats counters;
 };
 
-#endif /* UWBINBANDDATARX */
+#endif /* UWBINBANDDATARX_HPP */
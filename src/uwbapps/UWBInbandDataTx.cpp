@@ -0,0 +1,134 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#include "UWBInbandDataTx.hpp"
+
+UWBInBandDataTx::UWBInBandDataTx(uint32_t session_ID, UWBMacAddress srcAddr,
+                                 UWBMacAddress dstAddr, uint8_t dataBlocks)
+    : destination(dstAddr), sequence_number(0), blocks(dataBlocks), onStatus(nullptr),
+      acquired(false), committed(0), issued(0), released(0)
+{
+    sessionID(session_ID);
+    sessionType(uwb::SessionType::RANGING_WITH_DATA);
+
+    rangingParams.deviceRole(uwb::DeviceRole::INITIATOR);
+    rangingParams.deviceType(uwb::DeviceType::CONTROLLER);
+    rangingParams.multiNodeMode(uwb::MultiNodeMode::UNICAST);
+    rangingParams.rangingRoundUsage(uwb::RangingMethod::DS_TWR);
+    rangingParams.scheduledMode(uwb::ScheduledMode::TIME_SCHEDULED);
+    rangingParams.noOfControlees(1);
+    rangingParams.deviceMacAddr(srcAddr);
+    rangingParams.destinationMacAddr(dstAddr);
+
+    //SP1, link layer bypass, data transmit notifications, see UWBPreset.cpp
+    appParams.load(UWBPreset::inbandData.data, UWBPreset::inbandData.size);
+
+    memset(&counters, 0, sizeof(counters));
+}
+
+uwb::Status UWBInBandDataTx::sendData(const uint8_t data[], uint16_t data_size)
+{
+    if (data_size > uwb::MAX_APP_DATA_SIZE)
+        return uwb::Status::INVALID_PARAM;
+
+    uint8_t* slot = acquire();
+    if (!slot)
+        return uwb::Status::BUFFER_OVERFLOW;
+    memcpy(slot, data, data_size);
+    commit(data_size);
+    poll();
+    return uwb::Status::SUCCESS;
+}
+
+uint8_t* UWBInBandDataTx::acquire()
+{
+    if (pending() >= TX_SLOTS)
+    {
+        counters.full++;
+        return nullptr;
+    }
+    acquired = true;
+    return slots[committed % TX_SLOTS];
+}
+
+bool UWBInBandDataTx::commit(uint16_t len)
+{
+    if (!acquired || len > uwb::MAX_APP_DATA_SIZE)
+        return false;
+
+    uint8_t i = committed % TX_SLOTS;
+    lengths[i] = len;
+    seqs[i] = sequence_number++;
+    status[i] = PENDING;
+    acquired = false;
+    committed++;
+    counters.committed++;
+    return true;
+}
+
+uint8_t UWBInBandDataTx::credits() const
+{
+    uint16_t inChip = issued - released;
+    return inChip < blocks ? blocks - inChip : 0;
+}
+
+uint8_t UWBInBandDataTx::poll()
+{
+    uint8_t n = 0;
+    while (issued != committed && credits())
+    {
+        uint8_t i = issued % TX_SLOTS;
+
+        uwb::DataPacket packet;
+        packet.session_handle = sessionID();
+        memcpy(packet.mac_address, destination.getData(), destination.getSize());
+        packet.data = slots[i];
+        packet.data_size = lengths[i];
+        packet.sequence_number = seqs[i];
+
+        // the notification may come before sendData() returns
+        issued++;
+        if (UWBHAL.sendData(packet) != uwb::Status::SUCCESS)
+        {
+            issued--;
+            counters.refused++;
+            break;
+        }
+        counters.issued++;
+        n++;
+    }
+    return n;
+}
+
+bool UWBInBandDataTx::dataTransmitted(uwb::DataTransmit& ntf)
+{
+    if (ntf.transmitNtf_sessionHandle != sessionID())
+        return false;
+
+    // notifications normally come in order, but look among all the packets in the chip
+    uint16_t k = released;
+    for (; k != issued; ++k)
+    {
+        uint8_t i = k % TX_SLOTS;
+        if (seqs[i] == ntf.transmitNtf_sequence_number && status[i] == PENDING)
+            break;
+    }
+    if (k == issued)
+        return false;
+
+    uint8_t i = k % TX_SLOTS;
+    status[i] = ntf.transmitNtf_status;
+    if (ntf.transmitNtf_status == TX_OK || ntf.transmitNtf_status == TX_REPETITION_OK)
+        counters.ok++;
+    else
+        counters.failed++;
+    if (onStatus)
+        onStatus(ntf.transmitNtf_sequence_number, ntf.transmitNtf_status);
+
+    // free the slots, and return the credits, of the confirmed packets
+    uint16_t r = released;
+    while (r != issued && status[r % TX_SLOTS] != PENDING)
+        r++;
+    released = r;
+    return true;
+}
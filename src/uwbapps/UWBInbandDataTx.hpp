@@ -4,71 +4,181 @@
 #ifndef UWBINBANDDATATX_HPP
 #define UWBINBANDDATATX_HPP
 
-extern "C" uint8_t dataToSend[];
-
-
 #include "UWB.hpp"
 #include "UWBSession.hpp"
 #include "UWBMacAddress.hpp"
+#include "UWBPreset.hpp"
 
+/**
+ * @brief DS-TWR controller session carrying in-band data to its controlee
+ *
+ * Each ranging round has a data phase that carries one packet of at most
+ * uwb::MAX_APP_DATA_SIZE bytes. Outgoing packets wait in a ring of TX_SLOTS
+ * preallocated slots that producers fill in place, without an intermediate
+ * buffer:
+ *
+ *     uint8_t* slot = tx.acquire();      // nullptr if the ring is full
+ *     if (slot) {
+ *         size_t len = readSensors(slot, uwb::MAX_APP_DATA_SIZE);
+ *         tx.commit(len);
+ *     }
+ *
+ * poll() hands the committed slots to the chip as long as it has credits:
+ * one per data block (SESSION_INBAND_DATA_TX_BLOCKS), taken by each packet
+ * and returned by its DATA_TRANSMIT_NTF. A slot is reused once its
+ * notification arrived, whose status goes to the statusCallback(). The
+ * notifications must be passed to dataTransmitted():
+ *
+ *     void txHandler(uwb::DataTransmit& ntf) { tx.dataTransmitted(ntf); }
+ *     UWB.registerDataTxCallback(txHandler);
+ *     ...
+ *     void loop() { tx.poll(); }
+ *
+ * A single producer and a single poll() caller are expected, the callback
+ * may run concurrently with both. UWBDataStreamTx sends payloads of any
+ * length through the ring.
+ */
 class UWBInBandDataTx : public UWBSession {
-public: 
-    UWBInBandDataTx(uint32_t session_ID, UWBMacAddress srcAddr, 
-                    UWBMacAddress dstAddr, uint32_t dataBlocks = 12)
-        : destination(dstAddr), sequence_number(0)
-    {
-        setSessionID(session_ID);
-        setSessionType(uwb::SessionType::RANGING_WITH_DATA_TRANSFER);
-        
-        // Set ranging parameters using HAL types
-        rangingParams.deviceRole(uwb::DeviceRole::INITIATOR);
-        rangingParams.deviceType(uwb::DeviceType::CONTROLLER);
-        rangingParams.multiNodeMode(uwb::MultiNodeMode::UNICAST);
-        rangingParams.rangingRoundUsage(uwb::RangingRoundUsage::DS_TWR);
-        rangingParams.scheduleMode(uwb::ScheduleMode::TIME_SCHEDULED);
-        rangingParams.deviceMacAddr(srcAddr);
-
-        // Set app parameters
-        appParams.addOrUpdateParam(AppConfigId::NO_OF_CONTROLEES, 
-                                    AppParamType::U32, 1);
-		appParams.dstMacAddr(dstAddr);
-        setDefaults();
-
-        // Link layer and frame config
-        appParams.addOrUpdateParam(AppConfigId::LINK_LAYER_MODE, 
-                                    AppParamType::U32, 
-                                    static_cast<uint32_t>(uwb::LinkLayerMode::BYPASS));
-									appParams.addOrUpdateParam(AppConfigId::RFRAME_CONFIG, 
-                                    AppParamType::U32,
-                                    static_cast<uint32_t>(uwb::RFrameConfig::SP1));
-
-        // Vendor specific data transfer parameters
-        vendorParams.addOrUpdateParam(VendorAppConfigId::SESSION_INBAND_DATA_TX_BLOCKS, 
-                                       AppParamType::U32, dataBlocks);
-        vendorParams.addOrUpdateParam(VendorAppConfigId::SESSION_INBAND_DATA_RX_BLOCKS, 
-                                       AppParamType::U32, 0);
-    }
-
-    uwb::Status sendData(uint8_t data[], uint16_t data_size) {
-        uwb::DataPacket packet;
-        packet.session_handle = sessionHdl;
-        memcpy(packet.mac_address, destination.getData(), destination.getSize());
-        packet.data = data;
-        packet.data_size = data_size;
-        packet.sequence_number = sequence_number;
-
-        uwb::Status status = UWBHAL.sendData(packet);
-        if (status != uwb::Status::SUCCESS) {
-            UWBHAL.Log_E("Failed to send data");
-        } else {
-            sequence_number++;
-        }
-        return status;
-    }
+public:
+    static const uint8_t TX_SLOTS = 8;
+
+    /**
+     * @brief status of a DATA_TRANSMIT_NTF (uwb::DataTransmit::transmitNtf_status)
+     *
+     */
+    enum TxStatus : uint8_t {
+        TX_OK = 0x00,
+        TX_REPETITION_OK = 0x01,
+        TX_ERROR = 0x02,
+        TX_NO_CREDIT = 0x03,
+        TX_REJECTED = 0x04,
+        TX_SESSION_TYPE_NOT_SUPPORTED = 0x05,
+        TX_ONGOING = 0x06,
+        TX_INVALID_FORMAT = 0x07
+    };
+
+    /**
+     * @brief called from the notification context with the status of each packet
+     *
+     */
+    typedef void (*TxStatusCallback)(uint16_t sequenceNumber, uint8_t status);
+
+    /**
+     * @brief ring statistics
+     *
+     */
+    struct Stats {
+        uint32_t committed;     // packets queued in the ring
+        uint32_t issued;        // packets handed to the chip
+        uint32_t ok;            // packets confirmed sent
+        uint32_t failed;        // packets reported as failed
+        uint32_t full;          // acquire() calls refused, ring full
+        uint32_t refused;       // sendData() refused by the chip, retried
+    };
+
+    /**
+     * @brief Construct a new UWBInBandDataTx object
+     *
+     * @param session_ID
+     * @param srcAddr
+     * @param dstAddr address of the UWBInBandDataRx peer
+     * @param dataBlocks packets the chip can queue (SESSION_INBAND_DATA_TX_BLOCKS)
+     */
+    UWBInBandDataTx(uint32_t session_ID, UWBMacAddress srcAddr,
+                    UWBMacAddress dstAddr, uint8_t dataBlocks = 12);
+
+    using UWBSession::sendData;
+
+    /**
+     * @brief copy a packet to the ring and send it if there's a credit
+     *
+     * @param data
+     * @param data_size at most uwb::MAX_APP_DATA_SIZE
+     * @return uwb::Status::SUCCESS if queued, uwb::Status::BUFFER_OVERFLOW if the ring is full
+     */
+    uwb::Status sendData(const uint8_t data[], uint16_t data_size);
+
+    /**
+     * @brief get the next free slot, to be filled in place
+     *
+     * @return uwb::MAX_APP_DATA_SIZE bytes, nullptr if the ring is full
+     */
+    uint8_t* acquire();
+
+    /**
+     * @brief queue the slot returned by acquire()
+     *
+     * the packet gets sequenceNumber() as it was before the call
+     *
+     * @param len bytes written to the slot
+     * @return false if no slot was acquired or len is too large
+     */
+    bool commit(uint16_t len);
+
+    /**
+     * @brief hand the committed packets to the chip while there are credits,
+     * call it from loop()
+     *
+     * @return number of packets handed
+     */
+    uint8_t poll();
+
+    /**
+     * @brief pass the DATA_TRANSMIT_NTF notifications, from the callback
+     *
+     * @return true if the notification is for one of the packets sent
+     */
+    bool dataTransmitted(uwb::DataTransmit& ntf);
+
+    /**
+     * @brief get notified of the status of every packet
+     *
+     */
+    void statusCallback(TxStatusCallback callback) { onStatus = callback; }
+
+    /**
+     * @brief sequence number of the next packet
+     *
+     */
+    uint16_t sequenceNumber() const { return sequence_number; }
+
+    /**
+     * @brief packets the chip can queue
+     *
+     */
+    uint8_t dataBlocks() const { return blocks; }
+
+    /**
+     * @brief credits left, packets that poll() can hand to the chip
+     *
+     */
+    uint8_t credits() const;
+
+    /**
+     * @brief packets committed and not confirmed yet, in the ring or in the chip
+     *
+     */
+    uint8_t pending() const { return (uint16_t)(committed - released); }
+
+    const Stats& stats() const { return counters; }
 
 private:
-    uint16_t sequence_number;
+    static const uint8_t PENDING = 0xFF;
+
     UWBMacAddress destination;
+    uint16_t sequence_number;
+    uint8_t blocks;
+    TxStatusCallback onStatus;
+
+    uint8_t slots[TX_SLOTS][uwb::MAX_APP_DATA_SIZE];
+    uint8_t lengths[TX_SLOTS];
+    uint16_t seqs[TX_SLOTS];
+    volatile uint8_t status[TX_SLOTS];
+    bool acquired;
+    uint16_t committed;             // producer only
+    uint16_t issued;                // poll() only
+    volatile uint16_t released;     // callback only
+    Stats counters;
 };
 
-#endif /* UWBINBANDDATATX */
+#endif /* UWBINBANDDATATX_HPP */
@@ -80,6 +80,23 @@ public:
     {
         return (uint8_t *)&data[0];
     }
+
+    const uint8_t *getData() const
+    {
+        return &data[0];
+    }
+
+    /**
+     * @brief same size and same bytes, see UWBMacKey to use addresses as keys
+     *
+     */
+    bool operator==(const UWBMacAddress& other) const {
+        return currentSize == other.currentSize && memcmp(data, other.data, getSize()) == 0;
+    }
+
+    bool operator!=(const UWBMacAddress& other) const {
+        return !(*this == other);
+    }
 };
 
 
@@ -14,6 +14,7 @@ private:
     UWBMacAddress arrays[MAX_SIZE];
     size_t count;
     UWBMacAddress::Size typeSize;
+    uint8_t packed[MAX_SIZE * UWBMacAddress::LONG]; // addresses back to back, as the chip expects them
 
 public:
     UWBMacAddressList(UWBMacAddress::Size size)
@@ -25,22 +26,19 @@ public:
             return;
         }
         if (count < MAX_SIZE) {
+            memcpy(&packed[count * array.getSize()], array.getData(), array.getSize());
             arrays[count++] = array;
         } else {
             //Serial.println(F("List is full, cannot add more items"));
         }
     }
 
+    /**
+     * @brief all the addresses back to back, kept up to date by add()
+     *
+     */
     uint8_t* getAllData()  {
-        static uint8_t result[MAX_SIZE * UWBMacAddress::LONG]; // Assuming a constant maximum address size
-        uint8_t* ptr = result;
-        for (size_t i = 0; i < count; ++i) {
-            uint8_t* data = arrays[i].getData();
-            for (size_t j = 0; j < arrays[i].getSize(); ++j) {
-                *ptr++ = data[j];
-            }
-        }
-        return result; // Note: this returns a pointer to a static array, so it should not and cannot be deleted.
+        return packed;
     }
 
     uint32_t size()  {
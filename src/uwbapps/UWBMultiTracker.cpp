@@ -0,0 +1,179 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#include "UWBMultiTracker.hpp"
+#include "UWBSlotPlanner.hpp"
+
+UWBMultiTracker::UWBMultiTracker(uint32_t session_ID, UWBMacAddress srcAddr)
+{
+    count = 0;
+    addrSize = srcAddr.getSize();
+    dirty = false;
+    paused = false;
+    restart = false;
+    batched = 0;
+    memset(packed, 0, sizeof(packed));
+    memset(&statistics, 0, sizeof(statistics));
+
+    sessionID(session_ID);
+    sessionType(uwb::SessionType::RANGING);
+
+    rangingParams.deviceRole(uwb::DeviceRole::INITIATOR);
+    rangingParams.deviceType(uwb::DeviceType::CONTROLLER);
+    // MULTICAST is the FiRa one-to-many node mode
+    rangingParams.multiNodeMode(uwb::MultiNodeMode::MULTICAST);
+    rangingParams.rangingRoundUsage(uwb::RangingMethod::DS_TWR);
+    rangingParams.scheduledMode(uwb::ScheduledMode::TIME_SCHEDULED);
+    rangingParams.deviceMacAddr(srcAddr);
+    rangingParams.noOfControlees(0);
+
+    // the round is sized for a full list, joining peers never change the slots
+    UWBSlotPlanner planner(uwb::MAX_RESPONDERS, uwb::RangingMethod::DS_TWR, uwb::RfFrameConfig::SP3, 1);
+    planner.rangingDuration(200);
+    planner.apply(appParams);
+    // the actual number of controlees travels with the ranging params
+    appParams.removeParam(uwb::AppConfigId::NumControlees);
+    appParams.sfdId(2);
+    appParams.preambleCodeIndex(10);
+    appParams.stsConfig(uwb::StsConfig::StaticSts);
+}
+
+uwb::Status UWBMultiTracker::init()
+{
+    if (count == 0)
+    {
+        UWBHAL.Log_E("multi tracker %08X: no controlees to init with", sessID);
+        return uwb::Status::INVALID_PARAM;
+    }
+    return UWBSession::init();
+}
+
+int UWBMultiTracker::indexOf(UWBMacAddress& addr)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        if (list[i] == addr)
+            return i;
+    }
+    return -1;
+}
+
+bool UWBMultiTracker::addControlee(UWBMacAddress& addr)
+{
+    if (addr.getSize() != addrSize || count >= uwb::MAX_RESPONDERS)
+        return false;
+    if (indexOf(addr) >= 0)
+        return false;
+
+    list[count++] = addr;
+    batched++;
+    syncConfig();
+    return true;
+}
+
+bool UWBMultiTracker::removeControlee(UWBMacAddress& addr)
+{
+    if (addr.getSize() != addrSize)
+        return false;
+    int i = indexOf(addr);
+    if (i < 0)
+        return false;
+
+    // keep the order, slots are assigned by position in the list
+    for (; i < count - 1; ++i)
+        list[i] = list[i + 1];
+    count--;
+    batched++;
+    syncConfig();
+    return true;
+}
+
+void UWBMultiTracker::syncConfig()
+{
+    UWBMacAddressList dst(addrSize == UWBMacAddress::LONG ? UWBMacAddress::LONG : UWBMacAddress::SHORT);
+    for (int i = 0; i < count; ++i)
+    {
+        memcpy(&packed[i * addrSize], list[i].getData(), addrSize);
+        dst.add(list[i]);
+    }
+    // cached for the next init(), sent to a live session by poll()
+    rangingParams.noOfControlees(count);
+    rangingParams.destinationMacAddr(dst);
+    dirty = true;
+}
+
+uwb::Status UWBMultiTracker::poll()
+{
+    if (!dirty)
+        return uwb::Status::SUCCESS;
+
+    uwb::Status res = sendUpdate();
+    if (res == uwb::Status::SUCCESS)
+    {
+        dirty = false;
+        statistics.changes += batched;
+        batched = 0;
+    }
+    return res;
+}
+
+uwb::Status UWBMultiTracker::sendUpdate()
+{
+    uint8_t st;
+    if (state(st) != uwb::Status::SUCCESS || st == (uint8_t)uwb::SessionStatus::DEINIT)
+    {
+        // not initialized, init() will send the cached configuration
+        return uwb::Status::SUCCESS;
+    }
+    bool active = st == (uint8_t)uwb::SessionStatus::ACTIVE;
+
+    if (count == 0)
+    {
+        if (active)
+        {
+            UWBHAL.Log_I("multi tracker %08X: no controlees, pausing", sessID);
+            uwb::Status res = stop();
+            if (res != uwb::Status::SUCCESS)
+                return res;
+            paused = true;
+        }
+        return uwb::Status::SUCCESS;
+    }
+
+    UWBAppParamList update;
+    update.noOfControlees(count);
+    update.addOrUpdateParam(buildArray(uwb::AppConfigId::PeerAddress, packed, count * addrSize));
+
+    uwb::Status res = UWBHAL.setAppConfigMultiple(sessID, update);
+    if (res != uwb::Status::SUCCESS && active && restart)
+    {
+        // the chip did not take the list while ranging, update it in IDLE
+        UWBHAL.Log_W("multi tracker %08X: live update refused (%d), restarting ranging", sessID, res);
+        statistics.restarts++;
+        res = stop();
+        if (res == uwb::Status::SUCCESS)
+        {
+            // stays paused until a start() succeeds, here or on a later poll()
+            paused = true;
+            res = UWBHAL.setAppConfigMultiple(sessID, update);
+            uwb::Status started = start();
+            if (started == uwb::Status::SUCCESS)
+                paused = false;
+            if (res == uwb::Status::SUCCESS)
+                res = started;
+        }
+    }
+    else if (res == uwb::Status::SUCCESS && paused)
+        res = start();
+
+    if (res != uwb::Status::SUCCESS)
+    {
+        UWBHAL.Log_E("multi tracker %08X: could not update controlees: %d", sessID, res);
+        statistics.failures++;
+        return res;
+    }
+    paused = false;
+    statistics.updates++;
+    UWBHAL.Log_D("multi tracker %08X: %u controlees, %u changes", sessID, count, batched);
+    return res;
+}
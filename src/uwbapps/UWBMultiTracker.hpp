@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#ifndef UWBMULTITRACKER_HPP
+#define UWBMULTITRACKER_HPP
+
+#include "hal/uwb_hal.hpp"
+#include "UWB.hpp"
+#include "UWBSession.hpp"
+
+/**
+ * @brief One-to-many DS-TWR controller ranging with up to uwb::MAX_RESPONDERS
+ * controlees in a single session
+ *
+ * Unlike UWBTracker and UWBRangingController, which range with a single peer,
+ * this preset uses a ONE_TO_MANY session whose ranging round is sized for the
+ * maximum number of controlees (see UWBSlotPlanner), so that controlees can
+ * join or leave while the session runs without changing the slot layout.
+ *
+ * addControlee() and removeControlee() only edit the local list, poll()
+ * then sends every change made since the previous call as a single update
+ * (number of controlees and destination addresses) to the running session,
+ * without restarting it. Should the chip refuse the update in ACTIVE state
+ * poll() returns the error, the session keeps ranging with its previous
+ * controlees and the changes stay pending. With restartOnRefusal(true) the
+ * session is instead briefly stopped, updated and started again, it is never
+ * deinitialized.
+ * When the last controlee is removed ranging is paused until one is added.
+ *
+ * UWBSessionManager and UWBSessionScheduler keep a copy of their sessions,
+ * which would not follow the controlee list: they do not take a multi
+ * tracker, init() and start() it directly.
+ *
+ * Example:
+ *
+ *     UWBMultiTracker tracker(0x11223344, srcAddr);
+ *     tracker.addControlee(anchor1);
+ *     tracker.addControlee(anchor2);
+ *     tracker.init();
+ *     tracker.start();
+ *     ...
+ *     void loop() { tracker.poll(); }
+ */
+class UWBMultiTracker : public UWBSession {
+public:
+    /**
+     * @brief update statistics, see stats()
+     *
+     */
+    struct Stats {
+        uint16_t updates;       // batches sent to the chip
+        uint16_t changes;       // add/remove calls folded into those batches
+        uint16_t restarts;      // updates that needed a stop/start, see restartOnRefusal()
+        uint16_t failures;      // updates refused
+    };
+
+    /**
+     * @brief Construct a new UWBMultiTracker object
+     *
+     * @param session_ID
+     * @param srcAddr address of this controller, the controlees must use the same size
+     */
+    UWBMultiTracker(uint32_t session_ID, UWBMacAddress srcAddr);
+
+    /**
+     * @brief init the session with the current controlees
+     *
+     * The chip does not take a one-to-many session without controlees, add
+     * at least one before.
+     *
+     * @return uwb::Status::INVALID_PARAM if there are no controlees
+     */
+    uwb::Status init() override;
+
+    /**
+     * @brief add a controlee, applied on the next poll()
+     *
+     * @param addr
+     * @return true on success
+     * @return false if the list is full, the address size is wrong or it is already there
+     */
+    bool addControlee(UWBMacAddress& addr);
+
+    /**
+     * @brief remove a controlee, applied on the next poll()
+     *
+     * @param addr
+     * @return true if found
+     */
+    bool removeControlee(UWBMacAddress& addr);
+
+    /**
+     * @brief number of controlees in the local list
+     *
+     */
+    uint8_t controlees() const { return count; }
+
+    /**
+     * @brief get a controlee of the local list
+     *
+     * @param index 0 to controlees()-1
+     */
+    UWBMacAddress& controlee(uint8_t index) { return list[index < count ? index : 0]; }
+
+    /**
+     * @brief true if some changes were not sent to the chip yet
+     *
+     */
+    bool pendingChanges() const { return dirty; }
+
+    /**
+     * @brief stop and restart the session when the chip refuses a live update
+     *
+     * Disabled by default: a refused update is reported by poll() and left
+     * pending, the session keeps ranging with its previous controlees.
+     *
+     * @param enable
+     */
+    void restartOnRefusal(bool enable) { restart = enable; }
+    bool restartOnRefusal() const { return restart; }
+
+    /**
+     * @brief send the pending changes to the session, call it from loop()
+     *
+     * Must not be called from a notification callback.
+     *
+     * @return uwb::Status::SUCCESS if nothing to do or the update was applied
+     */
+    uwb::Status poll();
+
+    Stats stats() const { return statistics; }
+
+private:
+    int indexOf(UWBMacAddress& addr);
+    void syncConfig();
+    uwb::Status sendUpdate();
+
+    UWBMacAddress list[uwb::MAX_RESPONDERS];
+    uint8_t count;
+    uint8_t addrSize;
+    uint8_t packed[uwb::MAX_RESPONDERS * MAC_EXT_ADD_LEN];
+    bool dirty;
+    bool paused;
+    bool restart;
+    uint16_t batched;
+    Stats statistics;
+};
+
+#endif /* UWBMULTITRACKER_HPP */
@@ -0,0 +1,324 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#include "Arduino.h"
+#include "UWBParamValidator.hpp"
+
+bool UWBParamValidator::Context::has(uwb::AppConfigId id) const
+{
+    return app->hasParam(id);
+}
+
+uint32_t UWBParamValidator::Context::value(uwb::AppConfigId id, uint32_t defaultValue) const
+{
+    uwb::AppConfig* p = app->findParam(id);
+    return p ? p->param_value.vu32 : defaultValue;
+}
+
+static bool isTwr(const UWBParamValidator::Context& ctx)
+{
+    // UL-TDoA and DL-TDoA roles ignore the ranging method
+    if (ctx.role != uwb::DeviceRole::INITIATOR && ctx.role != uwb::DeviceRole::RESPONDER)
+        return false;
+    return ctx.method >= uwb::RangingMethod::SS_TWR && ctx.method <= uwb::RangingMethod::DS_TWR_NO_DEFER;
+}
+
+static bool isBprf(const UWBParamValidator::Context& ctx)
+{
+    return ctx.value(uwb::AppConfigId::PrfMode, 0) == 0;
+}
+
+static uint8_t frameConfig(const UWBParamValidator::Context& ctx)
+{
+    return ctx.value(uwb::AppConfigId::RFrameConfig, uwb::RfFrameConfig::SP3);
+}
+
+// FiRa CHANNELS capability: b0 ch5, b1 ch6, b2 ch8, b3 ch9, b4 ch10...
+static int channelBit(uint32_t channel)
+{
+    switch (channel)
+    {
+    case 5: return 0;
+    case 6: return 1;
+    case 8: return 2;
+    case 9: return 3;
+    case 10: return 4;
+    case 12: return 5;
+    case 13: return 6;
+    case 14: return 7;
+    default: return -1;
+    }
+}
+
+static const char* checkDataFrame(const UWBParamValidator::Context& ctx)
+{
+    bool data = ctx.type == uwb::SessionType::RANGING_WITH_DATA || ctx.type == uwb::SessionType::DATA_TRANSFER ||
+                ctx.type == uwb::SessionType::DATA_ONLY || ctx.type == uwb::SessionType::RANGING_AND_DATA;
+    if (data && frameConfig(ctx) == uwb::RfFrameConfig::SP3)
+        return "SP3 frames carry no payload, data sessions need SP0 or SP1";
+    return nullptr;
+}
+
+static const char* checkUltdoaTimestamp(const UWBParamValidator::Context& ctx)
+{
+    if (ctx.value(uwb::AppConfigId::UlTdoaTxTimestamp, 0) && ctx.lowPower)
+        return "UL-TDoA TX timestamp needs low power mode disabled";
+    return nullptr;
+}
+
+static const char* checkUltdoaInterval(const UWBParamValidator::Context& ctx)
+{
+    if (ctx.role == uwb::DeviceRole::UT_TAG && !ctx.value(uwb::AppConfigId::UlTdoaTxInterval, 0))
+        return "UL-TDoA tags need a TX interval";
+    return nullptr;
+}
+
+static const char* checkRangingDuration(const UWBParamValidator::Context& ctx)
+{
+    if (isTwr(ctx) && ctx.value(uwb::AppConfigId::RangingDuration, 200) == 0)
+        return "ranging duration is 0";
+    return nullptr;
+}
+
+static const char* checkSlotsFit(const UWBParamValidator::Context& ctx)
+{
+    if (!isTwr(ctx))
+        return nullptr;
+    uint32_t slots = ctx.value(uwb::AppConfigId::SlotsPerRound, 25);
+    uint32_t slotRstu = ctx.value(uwb::AppConfigId::SlotDuration, 2400);
+    uint32_t durationMs = ctx.value(uwb::AppConfigId::RangingDuration, 200);
+    if (slots * slotRstu > durationMs * 1200)
+        return "slots per round x slot duration exceed the ranging duration";
+    return nullptr;
+}
+
+static const char* checkStsSegments(const UWBParamValidator::Context& ctx)
+{
+    if (frameConfig(ctx) == uwb::RfFrameConfig::SP0)
+    {
+        if (ctx.value(uwb::AppConfigId::NumStsSegments, 0) != 0)
+            return "SP0 frames have no STS segments";
+        return nullptr;
+    }
+    uint32_t segments = ctx.value(uwb::AppConfigId::NumStsSegments, 1);
+    if (segments == 0 || segments > 4)
+        return "STS frames need 1 to 4 STS segments";
+    return nullptr;
+}
+
+static const char* checkChannel(const UWBParamValidator::Context& ctx)
+{
+    uint32_t channel = ctx.value(uwb::AppConfigId::Channel, 9);
+    if (channel != 5 && channel != 9)
+        return "only channels 5 and 9 are supported";
+    return nullptr;
+}
+
+static const char* checkPreamble(const UWBParamValidator::Context& ctx)
+{
+    if (!ctx.has(uwb::AppConfigId::PreambleCodeIndex))
+        return nullptr;
+    uint32_t code = ctx.value(uwb::AppConfigId::PreambleCodeIndex, 0);
+    if (isBprf(ctx) && (code < 9 || code > 12))
+        return "BPRF preamble codes are 9 to 12";
+    if (!isBprf(ctx) && (code < 25 || code > 32))
+        return "HPRF preamble codes are 25 to 32";
+    return nullptr;
+}
+
+static const char* checkSfd(const UWBParamValidator::Context& ctx)
+{
+    uint32_t sfd = ctx.value(uwb::AppConfigId::SfdId, 2);
+    if (isBprf(ctx) && sfd != 0 && sfd != 2)
+        return "BPRF supports SFD 0 and 2";
+    return nullptr;
+}
+
+static const char* checkControlees(const UWBParamValidator::Context& ctx)
+{
+    if (!isTwr(ctx) || ctx.deviceType != uwb::DeviceType::CONTROLLER)
+        return nullptr;
+    uint8_t n = ctx.rangingControlees;
+    if (ctx.nodeMode == uwb::MultiNodeMode::UNICAST && n != 1)
+        return "unicast sessions have exactly one controlee";
+    if (n == 0 || n > uwb::MAX_RESPONDERS)
+        return "controlees must be 1 to MAX_RESPONDERS";
+    if (ctx.has(uwb::AppConfigId::NumControlees) && ctx.value(uwb::AppConfigId::NumControlees, 0) != n)
+        return "app and ranging params disagree on the number of controlees";
+    return nullptr;
+}
+
+static const char* checkVendorArrays(const UWBParamValidator::Context& ctx)
+{
+    if (!ctx.vendor)
+        return nullptr;
+    uwb::VendorAppConfig* list = ctx.vendor->getParamsList();
+    for (unsigned int i = 0; i < ctx.vendor->getSize(); ++i)
+    {
+        if (list[i].param_type == uwb::AppParamType::ARRAY_U8 &&
+            (!list[i].param_value.au8.param_value || !list[i].param_value.au8.param_len))
+            return "vendor array parameter without data";
+    }
+    return nullptr;
+}
+
+static const char* checkCapChannel(const UWBParamValidator::Context& ctx)
+{
+    int bit = channelBit(ctx.value(uwb::AppConfigId::Channel, 9));
+    if (ctx.caps->channels && bit >= 0 && !(ctx.caps->channels & (1 << bit)))
+        return "channel not supported by the device";
+    return nullptr;
+}
+
+static const char* checkCapFrame(const UWBParamValidator::Context& ctx)
+{
+    if (ctx.caps->rframeConfig && !(ctx.caps->rframeConfig & (1 << frameConfig(ctx))))
+        return "RFRAME config not supported by the device";
+    return nullptr;
+}
+
+static const char* checkCapMethod(const UWBParamValidator::Context& ctx)
+{
+    if (isTwr(ctx) && ctx.caps->rangingMethod && !(ctx.caps->rangingMethod & (1 << (uint8_t)ctx.method)))
+        return "ranging method not supported by the device";
+    return nullptr;
+}
+
+static const char* checkCapSts(const UWBParamValidator::Context& ctx)
+{
+    uint32_t sts = ctx.value(uwb::AppConfigId::StsConfig, uwb::StsConfig::StaticSts);
+    if (ctx.caps->stsConfig && !(ctx.caps->stsConfig & (1 << sts)))
+        return "STS config not supported by the device";
+    return nullptr;
+}
+
+static const char* checkCapNodeMode(const UWBParamValidator::Context& ctx)
+{
+    if (ctx.caps->multiNodeMode && !(ctx.caps->multiNodeMode & (1 << ctx.nodeMode)))
+        return "multi node mode not supported by the device";
+    return nullptr;
+}
+
+static const char* checkCapRole(const UWBParamValidator::Context& ctx)
+{
+    if (ctx.caps->deviceRoles && !(ctx.caps->deviceRoles & (1 << ctx.role)))
+        return "device role not supported by the device";
+    return nullptr;
+}
+
+static const char* checkCapType(const UWBParamValidator::Context& ctx)
+{
+    if (ctx.caps->deviceTypes && !(ctx.caps->deviceTypes & (1 << ctx.deviceType)))
+        return "device type not supported by the device";
+    return nullptr;
+}
+
+static const UWBParamValidator::Rule rules[] = {
+    {"sp3-data", uwb::Status::INVALID_PARAM, checkDataFrame},
+    {"ultdoa-timestamp", uwb::Status::INVALID_PARAM, checkUltdoaTimestamp},
+    {"ultdoa-interval", uwb::Status::INVALID_PARAM, checkUltdoaInterval},
+    {"ranging-duration", uwb::Status::INVALID_RANGE, checkRangingDuration},
+    {"slots-fit", uwb::Status::INVALID_RANGE, checkSlotsFit},
+    {"sts-segments", uwb::Status::INVALID_RANGE, checkStsSegments},
+    {"channel", uwb::Status::INVALID_RANGE, checkChannel},
+    {"preamble", uwb::Status::INVALID_RANGE, checkPreamble},
+    {"sfd", uwb::Status::INVALID_RANGE, checkSfd},
+    {"controlees", uwb::Status::INVALID_RANGE, checkControlees},
+    {"vendor-arrays", uwb::Status::INVALID_PARAM, checkVendorArrays},
+};
+
+// only run when the device capabilities are known
+static const UWBParamValidator::Rule capabilityRules[] = {
+    {"cap-channel", uwb::Status::INVALID_PARAM, checkCapChannel},
+    {"cap-rframe", uwb::Status::INVALID_PARAM, checkCapFrame},
+    {"cap-method", uwb::Status::INVALID_PARAM, checkCapMethod},
+    {"cap-sts", uwb::Status::INVALID_PARAM, checkCapSts},
+    {"cap-node-mode", uwb::Status::INVALID_PARAM, checkCapNodeMode},
+    {"cap-role", uwb::Status::INVALID_PARAM, checkCapRole},
+    {"cap-type", uwb::Status::INVALID_PARAM, checkCapType},
+};
+
+UWBParamValidator::UWBParamValidator()
+{
+    memset(&caps, 0, sizeof(caps));
+    hasCaps = false;
+    lowPower = true;
+    count = 0;
+    elapsed = 0;
+    sessionID = 0;
+}
+
+uwb::Status UWBParamValidator::readCapabilities()
+{
+    uwb::Status res = UWBHAL.getDeviceCapability(caps);
+    hasCaps = res == uwb::Status::SUCCESS;
+    if (!hasCaps)
+        UWBHAL.Log_E("validator: could not read device capabilities: %d", res);
+    return res;
+}
+
+void UWBParamValidator::capabilities(const uwb::DeviceCapabilities& c)
+{
+    caps = c;
+    hasCaps = true;
+}
+
+uwb::Status UWBParamValidator::validate(UWBSession& sess, UWBVendorParamList* vendorParams)
+{
+    uint32_t start = micros();
+
+    Context ctx;
+    ctx.type = sess.sessionType();
+    ctx.role = sess.rangingParams.deviceRole();
+    ctx.deviceType = sess.rangingParams.deviceType();
+    ctx.method = sess.rangingParams.rangingRoundUsage();
+    ctx.nodeMode = sess.rangingParams.multiNodeMode();
+    ctx.rangingControlees = sess.rangingParams.noOfControlees();
+    ctx.app = &sess.appParams;
+    ctx.vendor = vendorParams;
+    ctx.caps = &caps;
+    ctx.lowPower = lowPower;
+
+    uwb::Status status = uwb::Status::SUCCESS;
+    count = 0;
+    sessionID = sess.sessionID();
+
+    const Rule* tables[] = {rules, capabilityRules};
+    const size_t sizes[] = {sizeof(rules) / sizeof(rules[0]), sizeof(capabilityRules) / sizeof(capabilityRules[0])};
+    int numTables = hasCaps ? 2 : 1;
+
+    for (int t = 0; t < numTables; ++t)
+    {
+        for (size_t i = 0; i < sizes[t]; ++i)
+        {
+            const char* reason = tables[t][i].check(ctx);
+            if (!reason)
+                continue;
+            if (count < maxViolations)
+            {
+                found[count].status = tables[t][i].status;
+                found[count].rule = tables[t][i].name;
+                found[count].message = reason;
+            }
+            if (status == uwb::Status::SUCCESS)
+                status = tables[t][i].status;
+            if (count < 0xFF)
+                count++;
+        }
+    }
+
+    elapsed = micros() - start;
+    return status;
+}
+
+void UWBParamValidator::printReport() const
+{
+    if (!count)
+    {
+        UWBHAL.Log_I("validator: session %08X OK (%lu us)", sessionID, (unsigned long)elapsed);
+        return;
+    }
+    UWBHAL.Log_E("validator: session %08X, %d violations (%lu us)", sessionID, count, (unsigned long)elapsed);
+    for (int i = 0; i < stored(); ++i)
+        UWBHAL.Log_E("  %s: %s", found[i].rule, found[i].message);
+}
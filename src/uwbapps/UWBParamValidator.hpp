@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#ifndef UWBPARAMVALIDATOR_HPP
+#define UWBPARAMVALIDATOR_HPP
+
+#include "hal/uwb_hal.hpp"
+#include "UWBSession.hpp"
+#include "UWBVendorParamList.hpp"
+
+/**
+ * @brief Checks a session configuration locally before it reaches the chip
+ *
+ * Some combinations of parameters are only refused by the chip after a UCI
+ * round trip, or accepted and then fail once ranging starts (e.g. SP3 frames
+ * in a data session, more slots than fit in the ranging duration). The
+ * validator runs a table of rules over the app, ranging and vendor params
+ * and reports every violation it finds, without any HAL traffic.
+ *
+ * When the device capabilities are known (readCapabilities() or
+ * capabilities()) the configuration is also checked against what the chip
+ * supports: channels, RFRAME configs, ranging methods, STS configs, node
+ * modes, device roles and types.
+ *
+ * A session given a validator with UWBSession::validator() runs it at the
+ * beginning of init() and does not touch the chip if a rule is violated:
+ *
+ *     UWBParamValidator validator;
+ *     validator.readCapabilities();
+ *     tracker.validator(&validator);
+ *     tracker.init();     // logs the violations and returns INVALID_PARAM
+ */
+class UWBParamValidator {
+public:
+    static const uint8_t maxViolations = 16;
+
+    /**
+     * @brief one broken rule
+     *
+     */
+    struct Violation {
+        uwb::Status status;     // INVALID_PARAM or INVALID_RANGE
+        const char* rule;       // short rule name
+        const char* message;    // what is wrong
+    };
+
+    UWBParamValidator();
+
+    /**
+     * @brief read the device capabilities from the chip, call it once from setup()
+     *
+     * @return uwb::Status::SUCCESS if read
+     */
+    uwb::Status readCapabilities();
+
+    /**
+     * @brief use capabilities read elsewhere
+     *
+     */
+    void capabilities(const uwb::DeviceCapabilities& caps);
+
+    /**
+     * @brief whether the device runs in low power mode, enabled by default
+     *
+     */
+    void lowPowerMode(bool enabled) { lowPower = enabled; }
+
+    /**
+     * @brief validate the configuration of a session
+     *
+     * @param sess
+     * @param vendorParams optional vendor params sent with the session
+     * @return uwb::Status::SUCCESS if no rule is violated, the status of the first violation otherwise
+     */
+    uwb::Status validate(UWBSession& sess, UWBVendorParamList* vendorParams = nullptr);
+
+    /**
+     * @brief number of violations found by the last validate()
+     *
+     * every violation is counted, only the first maxViolations are kept
+     */
+    uint8_t violations() const { return count; }
+
+    /**
+     * @brief get a violation of the last validate()
+     *
+     * @param index 0 to violations()-1
+     */
+    const Violation& violation(uint8_t index) const { return found[index < stored() ? index : 0]; }
+
+    /**
+     * @brief duration of the last validate(), in microseconds
+     *
+     */
+    uint32_t elapsedUs() const { return elapsed; }
+
+    /**
+     * @brief log the violations of the last validate()
+     *
+     */
+    void printReport() const;
+
+    /**
+     * @brief parameters of the session being validated, as seen by the rules
+     *
+     */
+    struct Context {
+        uwb::SessionType type;
+        uwb::DeviceRole role;
+        uwb::DeviceType deviceType;
+        uwb::RangingMethod method;
+        uwb::MultiNodeMode nodeMode;
+        uint8_t rangingControlees;
+        UWBAppParamList* app;
+        UWBVendorParamList* vendor;
+        const uwb::DeviceCapabilities* caps;
+        bool lowPower;
+
+        bool has(uwb::AppConfigId id) const;
+        uint32_t value(uwb::AppConfigId id, uint32_t defaultValue) const;
+    };
+
+    /**
+     * @brief a rule returns nullptr if satisfied, the reason otherwise
+     *
+     */
+    typedef const char* (*Check)(const Context& ctx);
+
+    struct Rule {
+        const char* name;
+        uwb::Status status;
+        Check check;
+    };
+
+private:
+    uint8_t stored() const { return count < maxViolations ? count : maxViolations; }
+
+    uwb::DeviceCapabilities caps;
+    bool hasCaps;
+    bool lowPower;
+    Violation found[maxViolations];
+    uint8_t count;
+    uint32_t elapsed;
+    uint32_t sessionID;
+};
+
+#endif /* UWBPARAMVALIDATOR_HPP */
@@ -0,0 +1,244 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#ifndef UWBPEERTABLE_HPP
+#define UWBPEERTABLE_HPP
+
+#include <stdint.h>
+#include <string.h>
+#include "UWBMacAddress.hpp"
+
+/**
+ * @brief MAC address packed in a 64 bit integer, little endian
+ *
+ * Short addresses are zero extended, so only the valid bytes of a
+ * measurement's peer_addr take part in comparisons (the chip does not clear
+ * the others). Keys of short and extended addresses are not told apart: a
+ * session uses a single addressing mode.
+ *
+ * No dependency on the HAL, so the same keys work on host side tools.
+ */
+class UWBMacKey {
+public:
+    UWBMacKey() : value(0) {}
+
+    explicit UWBMacKey(uint64_t packed) : value(packed) {}
+
+    /**
+     * @brief pack a raw address
+     *
+     * @param addr
+     * @param len valid bytes, 2 or 8
+     */
+    UWBMacKey(const uint8_t* addr, size_t len) : value(0) {
+        if (len > 8)
+            len = 8;
+        for (size_t i = len; i-- > 0;)
+            value = (value << 8) | addr[i];
+    }
+
+    UWBMacKey(const UWBMacAddress& addr) : value(0) {
+        for (size_t i = addr.getSize(); i-- > 0;)
+            value = (value << 8) | addr.get(i);
+    }
+
+    /**
+     * @brief key of a ranging measurement address
+     *
+     * @param addr peer_addr of a measurement
+     * @param macMode UWBRangingData::macMode(), 0 for short addresses
+     */
+    static UWBMacKey fromMeasure(const uint8_t* addr, uint8_t macMode) {
+        return UWBMacKey(addr, macMode == 0 ? 2 : 8);
+    }
+
+    uint64_t packed() const { return value; }
+
+    /**
+     * @brief unpack to a raw address
+     *
+     * @param out
+     * @param len bytes to write, 2 or 8
+     */
+    void copyTo(uint8_t* out, size_t len) const {
+        uint64_t v = value;
+        for (size_t i = 0; i < len && i < 8; ++i, v >>= 8)
+            out[i] = v & 0xFF;
+    }
+
+    /**
+     * @brief 32 bit hash, the higher bits are the best mixed
+     *
+     */
+    uint32_t hash() const {
+        // fold, then Fibonacci hashing: cheap on 32 bit cores
+        uint32_t h = ((uint32_t)value ^ (uint32_t)(value >> 32)) * 0x85EBCA6BUL;
+        h ^= h >> 15;
+        return h * 0x9E3779B1UL;
+    }
+
+    bool operator==(const UWBMacKey& other) const { return value == other.value; }
+    bool operator!=(const UWBMacKey& other) const { return value != other.value; }
+
+private:
+    uint64_t value;
+};
+
+/**
+ * @brief Fixed capacity hash table of per peer state, keyed by MAC address
+ *
+ * Open addressing with linear probing: finding the state of the peer of a
+ * measurement is a hash and, at the load factors allowed here, usually a
+ * single probe, instead of comparing the address against every entry.
+ * Removing shifts back the entries that follow, so there are no tombstones
+ * and lookups do not degrade over time.
+ *
+ * At most 3/4 of CAPACITY entries are stored to keep the probe sequences
+ * short, CAPACITY must be a power of two. No dynamic memory:
+ *
+ *     UWBPeerTable<PeerState, 16> peers;     // up to 12 peers
+ *     PeerState* p = peers.insert(UWBMacKey::fromMeasure(twr[j].peer_addr, data.macMode()));
+ *
+ * @tparam T per peer state, reset with a default constructed T on insert
+ * @tparam CAPACITY number of slots
+ */
+template <typename T, uint16_t CAPACITY> class UWBPeerTable {
+    static_assert(CAPACITY >= 2 && (CAPACITY & (CAPACITY - 1)) == 0, "capacity must be a power of two");
+public:
+    static const uint16_t MAX_ENTRIES = CAPACITY - CAPACITY / 4;
+
+    UWBPeerTable() { clear(); }
+
+    void clear() {
+        memset(used, 0, sizeof(used));
+        count = 0;
+    }
+
+    /**
+     * @brief get the state of a peer
+     *
+     * @return nullptr if the peer is unknown
+     */
+    T* find(const UWBMacKey& key) {
+        uint16_t i;
+        return lookup(key, i) ? &values[i] : nullptr;
+    }
+
+    const T* find(const UWBMacKey& key) const {
+        uint16_t i;
+        return lookup(key, i) ? &values[i] : nullptr;
+    }
+
+    bool contains(const UWBMacKey& key) const {
+        uint16_t i;
+        return lookup(key, i);
+    }
+
+    /**
+     * @brief get the state of a peer, adding it if unknown
+     *
+     * @return nullptr if the peer is unknown and the table full
+     */
+    T* insert(const UWBMacKey& key) {
+        uint16_t i;
+        if (lookup(key, i))
+            return &values[i];
+        if (count >= MAX_ENTRIES)
+            return nullptr;
+        // lookup() stopped on the first free slot of the sequence
+        used[i] = true;
+        keys[i] = key;
+        values[i] = T();
+        count++;
+        return &values[i];
+    }
+
+    /**
+     * @brief forget a peer
+     *
+     * @return false if the peer is unknown
+     */
+    bool remove(const UWBMacKey& key) {
+        uint16_t hole;
+        if (!lookup(key, hole))
+            return false;
+
+        // move back the entries that would no longer be reachable
+        uint16_t i = hole;
+        while (true) {
+            i = (i + 1) & MASK;
+            if (!used[i])
+                break;
+            uint16_t home = slot(keys[i]);
+            // the entry stays if its home is cyclically in (hole, i]
+            bool stays = hole <= i ? (hole < home && home <= i) : (hole < home || home <= i);
+            if (stays)
+                continue;
+            keys[hole] = keys[i];
+            values[hole] = values[i];
+            hole = i;
+        }
+        used[hole] = false;
+        count--;
+        return true;
+    }
+
+    uint16_t size() const { return count; }
+
+    bool full() const { return count >= MAX_ENTRIES; }
+
+    /**
+     * @brief number of slots, to iterate with at() and keyAt()
+     *
+     */
+    static uint16_t capacity() { return CAPACITY; }
+
+    /**
+     * @brief state in a slot
+     *
+     * @param i 0 to capacity()-1
+     * @return nullptr if the slot is free
+     */
+    T* at(uint16_t i) { return i < CAPACITY && used[i] ? &values[i] : nullptr; }
+
+    const T* at(uint16_t i) const { return i < CAPACITY && used[i] ? &values[i] : nullptr; }
+
+    /**
+     * @brief key in a slot, only meaningful if at(i) is not nullptr
+     *
+     */
+    UWBMacKey keyAt(uint16_t i) const { return keys[i & MASK]; }
+
+private:
+    static const uint16_t MASK = CAPACITY - 1;
+
+    static uint16_t slot(const UWBMacKey& key) {
+        // the high bits of the hash are the best mixed
+        return (key.hash() >> 16) & MASK;
+    }
+
+    // index of the key, or of the free slot where it would go
+    bool lookup(const UWBMacKey& key, uint16_t& index) const {
+        uint16_t i = slot(key);
+        for (uint16_t n = 0; n < CAPACITY; ++n, i = (i + 1) & MASK) {
+            if (!used[i]) {
+                index = i;
+                return false;
+            }
+            if (keys[i] == key) {
+                index = i;
+                return true;
+            }
+        }
+        // only reached when full, which MAX_ENTRIES prevents
+        index = 0;
+        return false;
+    }
+
+    UWBMacKey keys[CAPACITY];
+    T values[CAPACITY];
+    bool used[CAPACITY];
+    uint16_t count;
+};
+
+#endif /* UWBPEERTABLE_HPP */
@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#include "UWBPreset.hpp"
+
+// UWBTracker: DS-TWR, SP3, 25 slots, 200ms rounds, static STS
+static constexpr UWBPreset::Param trackerParams[] = {
+    UWBPreset::u8(uwb::AppConfigId::RFrameConfig, uwb::RfFrameConfig::SP3),
+    UWBPreset::u8(uwb::AppConfigId::SlotsPerRound, 25),
+    UWBPreset::u32(uwb::AppConfigId::RangingDuration, 200),
+    UWBPreset::u8(uwb::AppConfigId::MaxRrRetry, 0),
+    UWBPreset::u8(uwb::AppConfigId::SfdId, 2),
+    UWBPreset::u8(uwb::AppConfigId::PreambleCodeIndex, 10),
+    UWBPreset::u8(uwb::AppConfigId::StsConfig, uwb::StsConfig::StaticSts),
+    UWBPreset::u8(uwb::AppConfigId::NumStsSegments, 1),
+};
+static constexpr auto trackerBlob = UWBPreset::build<UWBPreset::tlvSize(trackerParams)>(trackerParams);
+
+// UWBUltdoaTag: SP1 blinks on channel 9, no ranging notifications, low power
+static constexpr UWBPreset::Param ultdoaTagParams[] = {
+    UWBPreset::u8(uwb::AppConfigId::RFrameConfig, uwb::RfFrameConfig::Sfd_Sts),
+    UWBPreset::u8(uwb::AppConfigId::StsConfig, uwb::StsConfig::StaticSts),
+    UWBPreset::u8(uwb::AppConfigId::RangingRoundControl, (uint8_t)uwb::RangingMethod::TDOA),
+    // patched with the interval given to the constructor
+    UWBPreset::u32(uwb::AppConfigId::UlTdoaTxInterval, 2000),
+    UWBPreset::u8(uwb::AppConfigId::SessionInfoNtf, 0),
+    UWBPreset::u8(uwb::AppConfigId::Channel, 9),
+    UWBPreset::u8(uwb::AppConfigId::PreambleCodeIndex, 10),
+    UWBPreset::u8(uwb::AppConfigId::TxPowerId, 30),
+    UWBPreset::u8(uwb::AppConfigId::SfdId, 0),
+    UWBPreset::u8(uwb::AppConfigId::MacFcsType, 0),
+    UWBPreset::u8(uwb::AppConfigId::UlTdoaTxTimestamp, 0),
+};
+static constexpr auto ultdoaTagBlob = UWBPreset::build<UWBPreset::tlvSize(ultdoaTagParams)>(ultdoaTagParams);
+
+// UWBInBandDataTx/Rx: DS-TWR with a data phase, SP1 (SP3 frames carry no
+// payload), link layer bypass, DATA_TRANSMIT_NTF enabled for flow control
+static constexpr UWBPreset::Param inbandDataParams[] = {
+    UWBPreset::u8(uwb::AppConfigId::RFrameConfig, uwb::RfFrameConfig::SP1),
+    UWBPreset::u8(uwb::AppConfigId::SlotsPerRound, 25),
+    UWBPreset::u32(uwb::AppConfigId::RangingDuration, 200),
+    UWBPreset::u8(uwb::AppConfigId::MaxRrRetry, 0),
+    UWBPreset::u8(uwb::AppConfigId::SfdId, 2),
+    UWBPreset::u8(uwb::AppConfigId::PreambleCodeIndex, 10),
+    UWBPreset::u8(uwb::AppConfigId::StsConfig, uwb::StsConfig::StaticSts),
+    UWBPreset::u8(uwb::AppConfigId::LinkMode, 0),
+    UWBPreset::u8(uwb::AppConfigId::DataTransferStatus, 1),
+};
+static constexpr auto inbandDataBlob = UWBPreset::build<UWBPreset::tlvSize(inbandDataParams)>(inbandDataParams);
+
+const UWBPreset::Tlv UWBPreset::tracker = trackerBlob.tlv();
+const UWBPreset::Tlv UWBPreset::ultdoaTag = ultdoaTagBlob.tlv();
+const UWBPreset::Tlv UWBPreset::inbandData = inbandDataBlob.tlv();
@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#ifndef UWBPRESET_HPP
+#define UWBPRESET_HPP
+
+#include <stddef.h>
+#include "hal/uwb_types.hpp"
+
+/**
+ * @brief Compile-time session presets
+ *
+ * A preset is a fixed list of app parameters turned at compile time into a
+ * UCI TLV byte array (ID, length, value little endian) that lives in flash:
+ *
+ *     static constexpr UWBPreset::Param myParams[] = {
+ *         UWBPreset::u8(uwb::AppConfigId::RFrameConfig, uwb::RfFrameConfig::SP3),
+ *         UWBPreset::u16(uwb::AppConfigId::RangingDuration, 200),
+ *         UWBPreset::reserve(uwb::AppConfigId::PeerAddress, 2),
+ *     };
+ *     static constexpr auto myPreset = UWBPreset::build<UWBPreset::tlvSize(myParams)>(myParams);
+ *
+ * UWBAppParamList::load() reads the blob in a single pass instead of a chain
+ * of setter calls, and array values point straight into flash.
+ * Fields only known at runtime (MAC address, TX interval...) are reserved
+ * in the blob so that they keep their position, and patched after load()
+ * with the usual setters. The session ID is not an app parameter and is set
+ * with UWBSession::sessionID() as usual.
+ *
+ * The blobs of the library presets are UWBPreset::tracker, UWBPreset::ultdoaTag
+ * and UWBPreset::inbandData.
+ */
+class UWBPreset {
+public:
+    /**
+     * @brief one parameter of a preset, see u8(), u16(), u32() and reserve()
+     *
+     */
+    struct Param {
+        uint8_t id;
+        uint8_t len;
+        uint32_t value;
+    };
+
+    /**
+     * @brief a TLV blob ready to be given to UWBAppParamList::load()
+     *
+     */
+    struct Tlv {
+        const uint8_t* data;
+        uint16_t size;
+    };
+
+    template <size_t N> struct Blob {
+        uint8_t bytes[N];
+
+        constexpr Tlv tlv() const { return Tlv{bytes, N}; }
+    };
+
+    static constexpr Param u8(uwb::AppConfigId id, uint8_t value) { return Param{(uint8_t)id, 1, value}; }
+    static constexpr Param u16(uwb::AppConfigId id, uint16_t value) { return Param{(uint8_t)id, 2, value}; }
+    static constexpr Param u32(uwb::AppConfigId id, uint32_t value) { return Param{(uint8_t)id, 4, value}; }
+
+    /**
+     * @brief a zero filled field of len bytes, patched at runtime
+     *
+     */
+    static constexpr Param reserve(uwb::AppConfigId id, uint8_t len) { return Param{(uint8_t)id, len, 0}; }
+
+    /**
+     * @brief size of the TLV encoding of a parameter list
+     *
+     */
+    template <size_t K> static constexpr size_t tlvSize(const Param (&params)[K])
+    {
+        size_t size = 0;
+        for (size_t i = 0; i < K; ++i)
+            size += 2 + params[i].len;
+        return size;
+    }
+
+    /**
+     * @brief encode a parameter list, N must be tlvSize(params)
+     *
+     */
+    template <size_t N, size_t K> static constexpr Blob<N> build(const Param (&params)[K])
+    {
+        Blob<N> blob{};
+        size_t o = 0;
+        for (size_t i = 0; i < K; ++i)
+        {
+            blob.bytes[o++] = params[i].id;
+            blob.bytes[o++] = params[i].len;
+            for (size_t j = 0; j < params[i].len; ++j)
+                blob.bytes[o++] = j < 4 ? (params[i].value >> (8 * j)) & 0xFF : 0;
+        }
+        return blob;
+    }
+
+    static const Tlv tracker;
+    static const Tlv ultdoaTag;
+    static const Tlv inbandData;
+};
+
+#endif /* UWBPRESET_HPP */
@@ -0,0 +1,201 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#include "UWBProfile.hpp"
+#include "UWBSession.hpp"
+#include "UWBVendorParamList.hpp"
+
+#define RANGING_FIXED_SIZE  15   // 7 single byte fields + device MAC
+#define STS_IV_SIZE         8
+
+static uint16_t get16(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void put16(uint8_t* p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void put32(uint8_t* p, uint32_t v)
+{
+    for (int i = 0; i < 4; ++i, v >>= 8)
+        p[i] = v & 0xFF;
+}
+
+uint16_t UWBProfile::crc16(const uint8_t* data, size_t len)
+{
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; ++i)
+    {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int b = 0; b < 8; ++b)
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+uwb::Status UWBProfile::load(UWBSession& sess, const uint8_t* data, size_t len, UWBVendorParamList* vendorParams)
+{
+    if (!data || len < HEADER_SIZE + CRC_SIZE || memcmp(data, "UWBP", 4) != 0)
+        return uwb::Status::INVALID_PARAM;
+    if (data[4] != VERSION)
+    {
+        UWBHAL.Log_E("profile: unsupported version %d", data[4]);
+        return uwb::Status::INVALID_PARAM;
+    }
+    size_t total = get16(&data[6]);
+    if (total < HEADER_SIZE + CRC_SIZE || total > len)
+        return uwb::Status::INVALID_PARAM;
+    size_t end = total - CRC_SIZE;
+    if (crc16(data, end) != get16(&data[end]))
+    {
+        UWBHAL.Log_E("profile: bad CRC");
+        return uwb::Status::INVALID_PARAM;
+    }
+
+    // check the sections first, the session is only touched by a valid profile
+    for (size_t o = HEADER_SIZE; o < end;)
+    {
+        if (o + 3 > end)
+            return uwb::Status::INVALID_PARAM;
+        uint8_t id = data[o];
+        size_t size = get16(&data[o + 1]);
+        if (o + 3 + size > end)
+            return uwb::Status::INVALID_PARAM;
+        if ((id == RANGING && size < RANGING_FIXED_SIZE) || (id == STS_IV && size != STS_IV_SIZE))
+            return uwb::Status::INVALID_PARAM;
+        o += 3 + size;
+    }
+
+    // the lists can still be full: load them into copies, handed over below
+    UWBAppParamList app = sess.appParams;
+    UWBVendorParamList vendor;
+    if (vendorParams)
+        vendor = *vendorParams;
+    for (size_t o = HEADER_SIZE; o < end;)
+    {
+        uint8_t id = data[o];
+        size_t size = get16(&data[o + 1]);
+        const uint8_t* p = &data[o + 3];
+        o += 3 + size;
+
+        if (id == APP && !app.load(p, size))
+            return uwb::Status::BUFFER_OVERFLOW;
+        if (id == VENDOR && vendorParams && !vendor.load(p, size))
+            return uwb::Status::BUFFER_OVERFLOW;
+    }
+
+    sess.sessionID(get32(&data[8]));
+    sess.sessionType((uwb::SessionType)data[12]);
+    sess.appParams = app;
+    if (vendorParams)
+        *vendorParams = vendor;
+
+    for (size_t o = HEADER_SIZE; o < end;)
+    {
+        uint8_t id = data[o];
+        size_t size = get16(&data[o + 1]);
+        const uint8_t* p = &data[o + 3];
+        o += 3 + size;
+
+        switch (id)
+        {
+        case RANGING:
+            sess.rangingParams.deviceRole((uwb::DeviceRole)p[0]);
+            sess.rangingParams.deviceType((uwb::DeviceType)p[1]);
+            sess.rangingParams.multiNodeMode((uwb::MultiNodeMode)p[2]);
+            sess.rangingParams.rangingRoundUsage((uwb::RangingMethod)p[3]);
+            sess.rangingParams.scheduledMode((uwb::ScheduledMode)p[4]);
+            sess.rangingParams.deviceMacAddr(&p[7], p[5] == 0 ? 2 : MAC_EXT_ADD_LEN);
+            sess.rangingParams.macAddrMode(p[5]);
+            sess.rangingParams.noOfControlees(p[6]);
+            sess.rangingParams.destinationMacAddr(&p[RANGING_FIXED_SIZE], size - RANGING_FIXED_SIZE);
+            break;
+        case STS_IV:
+            sess.staticStsIv(get16(p), &p[2]);
+            break;
+        default:
+            // APP and VENDOR are already loaded, others are written by a newer tool
+            break;
+        }
+    }
+    return uwb::Status::SUCCESS;
+}
+
+size_t UWBProfile::save(UWBSession& sess, uint8_t* out, size_t size, UWBVendorParamList* vendorParams)
+{
+    if (size < HEADER_SIZE + CRC_SIZE)
+        return 0;
+
+    memcpy(out, "UWBP", 4);
+    out[4] = VERSION;
+    out[5] = 0;
+    put32(&out[8], sess.sessionID());
+    out[12] = sess.sessionType();
+    size_t o = HEADER_SIZE;
+
+    // ranging params
+    UWBRangingParams& rp = sess.rangingParams;
+    size_t addrLen = rp.macAddrMode() == 0 ? 2 : MAC_EXT_ADD_LEN;
+    size_t dstLen = rp.noOfControlees() * addrLen;
+    if (dstLen > uwb::MAX_RESPONDERS * MAC_EXT_ADD_LEN)
+        dstLen = 0;
+    size_t rangingLen = RANGING_FIXED_SIZE + dstLen;
+    if (o + 3 + rangingLen > size - CRC_SIZE)
+        return 0;
+    out[o] = RANGING;
+    put16(&out[o + 1], rangingLen);
+    uint8_t* p = &out[o + 3];
+    p[0] = rp.deviceRole();
+    p[1] = rp.deviceType();
+    p[2] = rp.multiNodeMode();
+    p[3] = (uint8_t)rp.rangingRoundUsage();
+    p[4] = rp.scheduledMode();
+    p[5] = rp.macAddrMode();
+    p[6] = rp.noOfControlees();
+    memcpy(&p[7], rp.deviceMacAddr(), MAC_EXT_ADD_LEN);
+    memcpy(&p[RANGING_FIXED_SIZE], rp.destinationMacAddr(), dstLen);
+    o += 3 + rangingLen;
+
+    // parameter lists
+    for (int s = 0; s < 2; ++s)
+    {
+        if (s == 1 && !vendorParams)
+            break;
+        if (o + 3 > size - CRC_SIZE)
+            return 0;
+        size_t n = s == 0 ? sess.appParams.save(&out[o + 3], size - CRC_SIZE - o - 3)
+                          : vendorParams->save(&out[o + 3], size - CRC_SIZE - o - 3);
+        bool empty = s == 0 ? !sess.appParams.getSize() : !vendorParams->getSize();
+        if (!n && !empty)
+            return 0;
+        out[o] = s == 0 ? APP : VENDOR;
+        put16(&out[o + 1], n);
+        o += 3 + n;
+    }
+
+    uint16_t vendorId;
+    const uint8_t* iv = sess.staticStsIv(vendorId);
+    if (iv)
+    {
+        if (o + 3 + STS_IV_SIZE > size - CRC_SIZE)
+            return 0;
+        out[o] = STS_IV;
+        put16(&out[o + 1], STS_IV_SIZE);
+        put16(&out[o + 3], vendorId);
+        memcpy(&out[o + 5], iv, STS_IV_SIZE - 2);
+        o += 3 + STS_IV_SIZE;
+    }
+
+    put16(&out[6], o + CRC_SIZE);
+    put16(&out[o], crc16(out, o));
+    return o + CRC_SIZE;
+}
@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#ifndef UWBPROFILE_HPP
+#define UWBPROFILE_HPP
+
+#include "hal/uwb_types.hpp"
+
+class UWBSession;
+class UWBVendorParamList;
+
+/**
+ * @brief Binary session profile, see UWBSession::loadProfile()
+ *
+ * A profile holds a full session configuration so that tags can be
+ * provisioned with data instead of a firmware build. All fields are little
+ * endian:
+ *
+ *     offset  size
+ *     0       4     magic "UWBP"
+ *     4       1     format version, VERSION
+ *     5       1     reserved, 0
+ *     6       2     total length, CRC included
+ *     8       4     session ID
+ *     12      1     session type (uwb::SessionType)
+ *     13      ...   sections
+ *     len-2   2     CRC-16/CCITT-FALSE of all the previous bytes
+ *
+ * Every section is a 1 byte ID, a 2 bytes length and the payload:
+ *
+ *     RANGING   device role, device type, multi node mode, ranging method,
+ *               scheduled mode, MAC address mode, number of controlees,
+ *               device MAC (8 bytes), destination MACs (rest of the payload)
+ *     APP       app params as UCI TLVs (ID, length, value)
+ *     VENDOR    vendor params as UCI TLVs
+ *     STS_IV    vendor ID (2 bytes), static STS IV (6 bytes)
+ *
+ * Unknown sections are skipped, so newer profiles stay readable. The host
+ * tool in extras/uwbprofile builds profiles from a text description.
+ */
+class UWBProfile {
+public:
+    static const uint8_t VERSION = 1;
+    static const size_t HEADER_SIZE = 13;
+    static const size_t CRC_SIZE = 2;
+
+    enum Section : uint8_t {
+        RANGING = 0x01,
+        APP = 0x02,
+        VENDOR = 0x03,
+        STS_IV = 0x04
+    };
+
+    /**
+     * @brief configure a session from a profile, parsed in place
+     *
+     * array parameters point into the profile, which must outlive the session
+     *
+     * on failure neither the session nor vendorParams are changed
+     *
+     * @return uwb::Status::INVALID_PARAM if the profile is malformed or the CRC
+     * does not match, uwb::Status::BUFFER_OVERFLOW if a parameter list is full
+     */
+    static uwb::Status load(UWBSession& sess, const uint8_t* data, size_t len, UWBVendorParamList* vendorParams);
+
+    /**
+     * @brief write the configuration of a session as a profile
+     *
+     * @return size of the profile, 0 if out is too small
+     */
+    static size_t save(UWBSession& sess, uint8_t* out, size_t size, UWBVendorParamList* vendorParams);
+
+    static uint16_t crc16(const uint8_t* data, size_t len);
+};
+
+#endif /* UWBPROFILE_HPP */
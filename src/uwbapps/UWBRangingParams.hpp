@@ -370,6 +370,16 @@ public:
             memcpy(_ranging_params.dst_mac_addr, dstMacAddr.getData(), 8);
         }
     }
+    /**
+     * @brief Set the destination addresses from raw bytes, packed as the
+     * chip expects them (2 or 8 bytes each, see macAddrMode())
+     *
+     */
+    void destinationMacAddr(const uint8_t addrs[], size_t len) {
+        if (len > sizeof(_ranging_params.dst_mac_addr))
+            len = sizeof(_ranging_params.dst_mac_addr);
+        memcpy(_ranging_params.dst_mac_addr, addrs, len);
+    }
     void noOfControlees(uint8_t no_of_controlees) {
         if (no_of_controlees <= MAX_NUM_RESPONDERS) {
             _ranging_params.no_of_controlees = no_of_controlees;
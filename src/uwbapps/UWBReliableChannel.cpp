@@ -0,0 +1,382 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#include "Arduino.h"
+#include "UWBReliableChannel.hpp"
+
+#define INITIAL_RTO_MS  3000
+#define MIN_RTO_MS      100
+#define MAX_RTO_MS      10000
+
+static void put16(uint8_t* p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void put32(uint8_t* p, uint32_t v)
+{
+    for (int i = 0; i < 4; ++i, v >>= 8)
+        p[i] = v & 0xFF;
+}
+
+static uint16_t get16(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+UWBReliableChannel::UWBReliableChannel(UWBInBandDataTx& txSession, UWBInBandDataRx& rxSession)
+    : tx(txSession), rx(rxSession), state(IDLE), payload(nullptr), payloadLen(0), count(0),
+      base(0), nextNew(0), recoverUntil(0), txId(0), cwnd(2), cleanRun(0), retryLimit(10),
+      srtt(0), rttvar(0), rto(INITIAL_RTO_MS), lossAvg(0),
+      rxState(RX_NONE), rxBuffer(nullptr), rxSize(0), rxLength(0), rxStarted(false), rxId(0),
+      rxNext(0), rxBitmap(0), rxLast(-1), rxRefused(false), rxDone(false), ackPending(false)
+{
+    resetReport();
+}
+
+bool UWBReliableChannel::send(const uint8_t* data, uint32_t len)
+{
+    // rounded up without overflowing for lengths close to 4 GB
+    uint32_t fragments = len ? len / PAYLOAD + (len % PAYLOAD ? 1 : 0) : 1;
+    if (state == SENDING || (!data && len) || fragments > 0xFFFF)
+        return false;
+
+    payload = data;
+    payloadLen = len;
+    count = fragments;
+    base = 0;
+    nextNew = 0;
+    recoverUntil = 0;
+    cleanRun = 0;
+    txId++;
+    memset(window, 0, sizeof(window));
+    state = SENDING;
+    return true;
+}
+
+void UWBReliableChannel::receiveInto(uint8_t* buffer, uint32_t size)
+{
+    rxBuffer = buffer;
+    rxSize = size;
+    rxLength = 0;
+    rxState = buffer ? RX_READY : RX_NONE;
+}
+
+void UWBReliableChannel::poll()
+{
+    UWBInBandDataRx::Span span;
+    while (rx.peek(span))
+    {
+        received(span.data, span.len);
+        rx.release();
+    }
+
+    if (state == SENDING)
+    {
+        uint32_t now = millis();
+        uint8_t inFlight = 0;
+        bool timedOut = false;
+
+        for (uint16_t i = base; i < nextNew; ++i)
+        {
+            Fragment& f = frag(i);
+            if (f.acked || f.lost)
+                continue;
+            if (now - f.sentAt < rto)
+            {
+                inFlight++;
+                continue;
+            }
+            f.lost = true;
+            timedOut = true;
+            lossAvg = (lossAvg * 15 + 256) / 16;
+            if (i >= recoverUntil)
+            {
+                cwnd = cwnd > 1 ? cwnd / 2 : 1;
+                recoverUntil = nextNew;
+                cleanRun = 0;
+            }
+        }
+
+        if (timedOut)
+            rto = rto * 2 < MAX_RTO_MS ? rto * 2 : MAX_RTO_MS;
+
+        // the missing fragments first, then new ones
+        for (uint16_t i = base; i < nextNew && inFlight < cwnd && state == SENDING; ++i)
+        {
+            Fragment& f = frag(i);
+            if (!f.lost)
+                continue;
+            if (f.tries >= retryLimit)
+            {
+                UWBHAL.Log_W("reliable channel: payload %d given up", txId);
+                state = FAILED;
+                stats.failed++;
+                break;
+            }
+            if (!transmit(i, true))
+                break;
+            inFlight++;
+        }
+        while (state == SENDING && inFlight < cwnd && nextNew < count && nextNew < base + MAX_WINDOW)
+        {
+            if (!transmit(nextNew, false))
+                break;
+            nextNew++;
+            inFlight++;
+        }
+    }
+
+    if (ackPending)
+    {
+        uint8_t* p = tx.acquire();
+        if (p)
+        {
+            memset(p, 0, HEADER_SIZE);
+            writeAck(p);
+            tx.commit(HEADER_SIZE);
+            stats.acks++;
+        }
+    }
+    tx.poll();
+}
+
+bool UWBReliableChannel::transmit(uint16_t index, bool retransmission)
+{
+    uint8_t* p = tx.acquire();
+    if (!p)
+        return false;
+
+    uint32_t offset = (uint32_t)index * PAYLOAD;
+    uint32_t n = payloadLen - offset < PAYLOAD ? payloadLen - offset : PAYLOAD;
+    p[0] = DATA | (index + 1 == count ? LAST : 0);
+    p[1] = txId;
+    put16(&p[2], index);
+    writeAck(p);
+    memcpy(&p[HEADER_SIZE], &payload[offset], n);
+    tx.commit(HEADER_SIZE + n);
+
+    // the slot held fragment index - MAX_WINDOW before
+    Fragment& f = frag(index);
+    if (!retransmission)
+        memset(&f, 0, sizeof(f));
+    f.sentAt = millis();
+    f.tries++;
+    f.lost = false;
+    if (retransmission)
+        stats.retransmissions++;
+    else
+        stats.fragments++;
+    return true;
+}
+
+void UWBReliableChannel::writeAck(uint8_t* p)
+{
+    // every packet carries the receiver state
+    if (!rxStarted)
+    {
+        memset(&p[4], 0, 7);
+        return;
+    }
+    p[0] |= ACK | (rxRefused ? REFUSED : 0);
+    p[4] = rxId;
+    put16(&p[5], rxNext);
+    put32(&p[7], rxBitmap);
+    ackPending = false;
+}
+
+void UWBReliableChannel::received(const uint8_t* p, uint16_t len)
+{
+    if (len < HEADER_SIZE)
+        return;
+    if (p[0] & ACK)
+        acknowledged(p[4], get16(&p[5]), get32(&p[7]), p[0] & REFUSED);
+    if (p[0] & DATA)
+        data(p[1], get16(&p[2]), p[0] & LAST, &p[HEADER_SIZE], len - HEADER_SIZE);
+}
+
+void UWBReliableChannel::measureRtt(uint32_t sample)
+{
+    if (!srtt)
+    {
+        srtt = sample ? sample : 1;
+        rttvar = sample / 2;
+    }
+    else
+    {
+        uint32_t err = srtt > sample ? srtt - sample : sample - srtt;
+        rttvar = (3 * rttvar + err) / 4;
+        srtt = (7 * srtt + sample) / 8;
+    }
+    resetRto();
+}
+
+void UWBReliableChannel::resetRto()
+{
+    if (!srtt)
+        return;
+    rto = srtt + 4 * rttvar;
+    if (rto < MIN_RTO_MS)
+        rto = MIN_RTO_MS;
+    if (rto > MAX_RTO_MS)
+        rto = MAX_RTO_MS;
+}
+
+void UWBReliableChannel::acknowledged(uint8_t id, uint16_t next, uint32_t bitmap, bool refused)
+{
+    if (state != SENDING || id != txId || next > nextNew)
+        return;
+    if (refused)
+    {
+        UWBHAL.Log_W("reliable channel: payload %d refused by the peer", txId);
+        state = FAILED;
+        stats.failed++;
+        return;
+    }
+
+    int32_t highest = -1;
+    Fragment* newest = nullptr;
+    for (uint16_t i = base; i < nextNew; ++i)
+    {
+        bool got = i < next || (i > next && i - next - 1 < 32 && (bitmap >> (i - next - 1)) & 1);
+        Fragment& f = frag(i);
+        if (!got || f.acked)
+            continue;
+        f.acked = true;
+        if (!newest || (int32_t)(f.sentAt - newest->sentAt) >= 0)
+            newest = &f;
+        lossAvg = lossAvg * 15 / 16;
+        cleanRun++;
+        if (i > next)
+            highest = i;
+    }
+    // the ack was triggered by the last fragment sent, the older ones may have
+    // waited for it after a lost ack; Karn: no samples from retransmissions
+    if (newest && newest->tries == 1)
+        measureRtt(millis() - newest->sentAt);
+    if (next > base)
+        base = next;
+    // progress, undo the timeout backoff
+    if (cleanRun)
+        resetRto();
+
+    // a hole below a fragment that made it, and was sent before it, is a loss
+    for (int32_t i = base; i < highest; ++i)
+    {
+        Fragment& f = frag(i);
+        if (f.acked || f.lost || (int32_t)(f.sentAt - frag(highest).sentAt) > 0)
+            continue;
+        f.lost = true;
+        lossAvg = (lossAvg * 15 + 256) / 16;
+        if (i >= recoverUntil)
+        {
+            cwnd = cwnd > 1 ? cwnd / 2 : 1;
+            recoverUntil = nextNew;
+            cleanRun = 0;
+        }
+    }
+
+    if (cleanRun >= cwnd)
+    {
+        if (cwnd < MAX_WINDOW)
+            cwnd++;
+        cleanRun = 0;
+    }
+    if (base >= count)
+    {
+        state = DELIVERED;
+        stats.delivered++;
+    }
+}
+
+void UWBReliableChannel::data(uint8_t id, uint16_t index, bool last, const uint8_t* bytes, uint16_t len)
+{
+    if (!rxStarted || id != rxId)
+    {
+        // a new payload, only with a buffer to put it in
+        if (rxState != RX_READY)
+            return;
+        rxStarted = true;
+        rxId = id;
+        rxNext = 0;
+        rxBitmap = 0;
+        rxLast = -1;
+        rxRefused = false;
+        rxDone = false;
+    }
+    ackPending = true;
+
+    // already complete, the peer missed the ack
+    if (rxDone || rxRefused)
+        return;
+    if (index < rxNext || (index > rxNext && index - rxNext - 1 < 32 && (rxBitmap >> (index - rxNext - 1)) & 1))
+    {
+        stats.duplicates++;
+        return;
+    }
+    if (index > rxNext + MAX_WINDOW)
+        return;
+
+    uint32_t offset = (uint32_t)index * PAYLOAD;
+    if (offset + len > rxSize)
+    {
+        rxRefused = true;
+        return;
+    }
+    memcpy(&rxBuffer[offset], bytes, len);
+    if (last)
+    {
+        rxLast = index;
+        rxLength = offset + len;
+    }
+
+    if (index == rxNext)
+    {
+        rxNext++;
+        while (rxBitmap & 1)
+        {
+            rxBitmap >>= 1;
+            rxNext++;
+        }
+        rxBitmap >>= 1;
+    }
+    else
+        rxBitmap |= 1UL << (index - rxNext - 1);
+
+    if (rxLast >= 0 && rxNext > rxLast)
+    {
+        rxDone = true;
+        rxState = RX_COMPLETE;
+        stats.received++;
+    }
+}
+
+UWBReliableChannel::Report UWBReliableChannel::report() const
+{
+    Report rep = stats;
+    rep.window = cwnd;
+    rep.lossPercent = lossAvg * 100 / 256;
+    rep.rttMs = srtt;
+    rep.timeoutMs = rto;
+    return rep;
+}
+
+void UWBReliableChannel::resetReport()
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+void UWBReliableChannel::printReport() const
+{
+    Report rep = report();
+    UWBHAL.Log_I("reliable channel: %lu delivered, %lu failed, %lu received", rep.delivered, rep.failed, rep.received);
+    UWBHAL.Log_I("  %lu fragments, %lu retransmitted, %lu acks, %lu duplicates",
+                 rep.fragments, rep.retransmissions, rep.acks, rep.duplicates);
+    UWBHAL.Log_I("  window %d, loss %d%%, rtt %d ms, timeout %d ms", rep.window, rep.lossPercent, rep.rttMs, rep.timeoutMs);
+}
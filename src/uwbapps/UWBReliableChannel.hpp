@@ -0,0 +1,193 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#ifndef UWBRELIABLECHANNEL_HPP
+#define UWBRELIABLECHANNEL_HPP
+
+#include "UWBInbandDataTx.hpp"
+#include "UWBInbandDataRx.hpp"
+
+/**
+ * @brief Guaranteed delivery of payloads over in-band data, selective repeat
+ *
+ * In-band data is only carried from the controller to the controlee, so a
+ * channel joins two sessions: a UWBInBandDataTx towards the peer and a
+ * UWBInBandDataRx from it. Both ends run a channel, each one sending its
+ * payloads and acknowledging the peer's ones.
+ *
+ * Payloads are cut in fragments numbered within the payload. Every packet
+ * carries the receiver state of its sender: the next fragment expected and
+ * a bitmap of the MAX_WINDOW fragments after it already received. Acks thus
+ * ride on the reverse data when there is some, otherwise a packet without
+ * payload is sent. Only the fragments the bitmap shows missing, or not
+ * acknowledged within the retransmission timeout, are sent again.
+ *
+ * The window of fragments sent and not acknowledged starts at 2, grows by
+ * one for every window delivered without loss and halves when a loss is
+ * detected (at most once per window), so it follows the measured loss.
+ * The timeout follows the measured round trip time.
+ *
+ * Packet layout, little endian:
+ *
+ *     0   flags (DATA, LAST, ACK, REFUSED)
+ *     1   payload ID
+ *     2   fragment index (2 bytes)
+ *     4   acknowledged payload ID
+ *     5   next fragment expected (2 bytes)
+ *     7   bitmap of the fragments received after it (4 bytes)
+ *     11  data
+ *
+ * Both sessions' notifications must be passed on, and poll() called from loop():
+ *
+ *     UWBInBandDataTx tx(0x1111, me, peer);
+ *     UWBInBandDataRx rx(0x2222, me, peer);
+ *     UWBReliableChannel channel(tx, rx);
+ *
+ *     void txHandler(uwb::DataTransmit& ntf) { tx.dataTransmitted(ntf); }
+ *     void rxHandler(uwb::DataPacket& packet) { rx.dataReceived(packet); }
+ *     ...
+ *     channel.receiveInto(buffer, sizeof(buffer));
+ *     channel.send(config, configSize);     // config must stay valid until sent
+ *     void loop() { channel.poll(); }
+ */
+class UWBReliableChannel {
+public:
+    static const uint8_t MAX_WINDOW = 32;
+    static const uint8_t HEADER_SIZE = 11;
+    static const uint8_t PAYLOAD = uwb::MAX_APP_DATA_SIZE - HEADER_SIZE;
+
+    enum Flags : uint8_t {
+        DATA = 0x01,        // fragment index and data are valid
+        LAST = 0x02,        // last fragment of the payload
+        ACK = 0x04,         // acknowledgement fields are valid
+        REFUSED = 0x08      // the acknowledged payload does not fit the receiver's buffer
+    };
+
+    enum SendState : uint8_t {
+        IDLE,
+        SENDING,
+        DELIVERED,
+        FAILED
+    };
+
+    /**
+     * @brief statistics since the last resetReport()
+     *
+     */
+    struct Report {
+        uint32_t delivered;         // payloads acknowledged by the peer
+        uint32_t failed;            // payloads given up or refused
+        uint32_t fragments;         // first transmissions
+        uint32_t retransmissions;
+        uint32_t acks;              // packets sent without data
+        uint32_t received;          // payloads received
+        uint32_t duplicates;        // fragments received twice
+        uint8_t window;             // current window
+        uint8_t lossPercent;        // smoothed fragment loss
+        uint16_t rttMs;             // smoothed round trip time
+        uint16_t timeoutMs;         // current retransmission timeout
+    };
+
+    UWBReliableChannel(UWBInBandDataTx& tx, UWBInBandDataRx& rx);
+
+    /**
+     * @brief start sending a payload, not copied
+     *
+     * @param data must stay valid until sendState() is DELIVERED or FAILED
+     * @param len
+     * @return false if a payload is being sent
+     */
+    bool send(const uint8_t* data, uint32_t len);
+
+    SendState sendState() const { return state; }
+
+    /**
+     * @brief give up a payload after this many transmissions of a fragment
+     *
+     */
+    void maxRetries(uint8_t retries) { retryLimit = retries; }
+
+    /**
+     * @brief buffer for the next payload, also releases the previous one
+     *
+     * until a buffer is given the peer's fragments are not acknowledged, so
+     * that the peer waits
+     */
+    void receiveInto(uint8_t* buffer, uint32_t size);
+
+    /**
+     * @brief true if a payload is complete in the buffer
+     *
+     */
+    bool available() const { return rxState == RX_COMPLETE; }
+
+    uint32_t length() const { return available() ? rxLength : 0; }
+
+    /**
+     * @brief process the received packets and send, call it from loop()
+     *
+     */
+    void poll();
+
+    Report report() const;
+    void resetReport();
+    void printReport() const;
+
+private:
+    enum RxState : uint8_t { RX_NONE, RX_READY, RX_COMPLETE };
+
+    struct Fragment {
+        uint32_t sentAt;
+        uint8_t tries;
+        bool acked;
+        bool lost;
+    };
+
+    void received(const uint8_t* p, uint16_t len);
+    void acknowledged(uint8_t id, uint16_t next, uint32_t bitmap, bool refused);
+    void data(uint8_t id, uint16_t index, bool last, const uint8_t* bytes, uint16_t len);
+    bool transmit(uint16_t index, bool retransmission);
+    void writeAck(uint8_t* p);
+    void measureRtt(uint32_t sample);
+    void resetRto();
+    Fragment& frag(uint16_t index) { return window[index % MAX_WINDOW]; }
+
+    UWBInBandDataTx& tx;
+    UWBInBandDataRx& rx;
+
+    // sender
+    SendState state;
+    const uint8_t* payload;
+    uint32_t payloadLen;
+    uint16_t count;             // fragments of the payload
+    uint16_t base;              // lowest fragment not acknowledged
+    uint16_t nextNew;           // lowest fragment never sent
+    uint16_t recoverUntil;      // no window cut for losses below it
+    uint8_t txId;
+    uint8_t cwnd;
+    uint8_t cleanRun;           // fragments acknowledged since the window last changed
+    uint8_t retryLimit;
+    Fragment window[MAX_WINDOW];
+    uint32_t srtt;              // ms, 0 until measured
+    uint32_t rttvar;
+    uint32_t rto;
+    uint16_t lossAvg;           // loss in 1/256, smoothed
+
+    // receiver
+    RxState rxState;
+    uint8_t* rxBuffer;
+    uint32_t rxSize;
+    uint32_t rxLength;
+    bool rxStarted;
+    uint8_t rxId;               // payload being received, or the last one
+    uint16_t rxNext;            // next fragment expected
+    uint32_t rxBitmap;          // fragments rxNext+1... received
+    int32_t rxLast;             // index of the LAST fragment, -1 if not seen
+    bool rxRefused;
+    bool rxDone;                // rxId complete, only acknowledged again
+    bool ackPending;
+
+    Report stats;
+};
+
+#endif /* UWBRELIABLECHANNEL_HPP */
@@ -2,6 +2,8 @@
 // Copyright (c) 2025 Truesense Srl
 
 #include "UWBSession.hpp"
+#include "UWBParamValidator.hpp"
+#include "UWBProfile.hpp"
 
 
 UWBSession::UWBSession()
@@ -10,6 +12,8 @@ UWBSession::UWBSession()
     //sessID = 0;
     type = uwb::SessionType::RANGING;
     isActive = false;
+    paramValidator = nullptr;
+    hasStsIv = false;
 }
 
 
@@ -42,30 +46,13 @@ uwb::SessionType UWBSession::sessionType()
 
 uwb::Status UWBSession::init()
 {
-    uwb::Status res = uwb::Status::SUCCESS;
-    res= UWBHAL.sessionInit(sessID, type/*, sessID*/);
+    uwb::Status res = initSession();
     if (res != uwb::Status::SUCCESS)
-    {
-        UWBHAL.Log_E("could not init session");
         return res;
-    }
-    if (appParams.getSize())
-    {
-        res=UWBHAL.setAppConfigMultiple(sessID, appParams);
-        if (res != uwb::Status::SUCCESS)
-        {
-            UWBHAL.Log_E("could not set app params: %d", res);
-            return res;
-        }
-    }
-    else
-        UWBHAL.Log_E("no app params");
-    res=UWBHAL.setRangingParams(sessID, rangingParams);
+    res = sendAppParams();
     if (res != uwb::Status::SUCCESS)
-    {
-        UWBHAL.Log_E("could not set ranging params");
         return res;
-    }
+    res = sendRangingParams();
 
     // if(vendorParams.getSize())
     // {
@@ -82,6 +69,60 @@ uwb::Status UWBSession::init()
     return res;
 }
 
+uwb::Status UWBSession::initSession()
+{
+    uwb::Status res = uwb::Status::SUCCESS;
+    if (paramValidator)
+    {
+        res = paramValidator->validate(*this);
+        if (res != uwb::Status::SUCCESS)
+        {
+            paramValidator->printReport();
+            return res;
+        }
+    }
+    res= UWBHAL.sessionInit(sessID, type/*, sessID*/);
+    if (res != uwb::Status::SUCCESS)
+        UWBHAL.Log_E("could not init session");
+    return res;
+}
+
+uwb::Status UWBSession::sendAppParams()
+{
+    if (!appParams.getSize())
+    {
+        UWBHAL.Log_E("no app params");
+        return uwb::Status::SUCCESS;
+    }
+    // the session may be a copy, point array values to our own storage
+    appParams.rebase();
+    uwb::Status res=UWBHAL.setAppConfigMultiple(sessID, appParams);
+    if (res != uwb::Status::SUCCESS)
+    {
+        UWBHAL.Log_E("could not set app params: %d", res);
+        return res;
+    }
+    appParams.markClean();
+    return res;
+}
+
+uwb::Status UWBSession::sendRangingParams()
+{
+    uwb::Status res=UWBHAL.setRangingParams(sessID, rangingParams);
+    if (res != uwb::Status::SUCCESS)
+    {
+        UWBHAL.Log_E("could not set ranging params");
+        return res;
+    }
+    if (hasStsIv)
+    {
+        res = staticSts(stsVendorId, stsIv);
+        if (res != uwb::Status::SUCCESS)
+            UWBHAL.Log_E("could not set static STS IV");
+    }
+    return res;
+}
+
 uwb::Status UWBSession::deInit()
 {
     return UWBHAL.sessionDeinit(sessID);
@@ -110,6 +151,19 @@ uwb::Status UWBSession::staticSts(uint16_t vendorId, uint8_t *staticStsIv)
     return UWBHAL.setStaticSts(sessID, vendorId, stsIvVector);
 }
 
+void UWBSession::staticStsIv(uint16_t vendorId, const uint8_t* iv)
+{
+    stsVendorId = vendorId;
+    memcpy(stsIv, iv, sizeof(stsIv));
+    hasStsIv = true;
+}
+
+const uint8_t* UWBSession::staticStsIv(uint16_t& vendorId)
+{
+    vendorId = stsVendorId;
+    return hasStsIv ? stsIv : nullptr;
+}
+
 uwb::Status UWBSession::state(uint8_t& state)
 {
     return UWBHAL.getSessionState(sessID, state);
@@ -138,6 +192,21 @@ uwb::Status UWBSession::stop()
     return UWBHAL.stopRanging(sessID);
 }
 
+void UWBSession::validator(UWBParamValidator* validator)
+{
+    paramValidator = validator;
+}
+
+uwb::Status UWBSession::loadProfile(const uint8_t* profile, size_t len, UWBVendorParamList* vendorParams)
+{
+    return UWBProfile::load(*this, profile, len, vendorParams);
+}
+
+size_t UWBSession::saveProfile(uint8_t* out, size_t size, UWBVendorParamList* vendorParams)
+{
+    return UWBProfile::save(*this, out, size, vendorParams);
+}
+
 void UWBSession::applyDefaults()
 {
     appParams.sfdId(2);
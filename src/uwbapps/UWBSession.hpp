@@ -10,6 +10,8 @@
 #include "UWBAppParamList.hpp"
 #include "UWBVendorParamList.hpp"
 
+class UWBParamValidator;
+
 /**
  * @brief UWB Session wrapper class
  * A UWB (Ultra-Wideband) Session refers to a defined period during which two or
@@ -110,6 +112,7 @@ public:
      *
      */
     UWBSession();
+    virtual ~UWBSession() {}
     
     uint32_t sessionID();
     /**
@@ -135,9 +138,30 @@ public:
     /**
      * @brief sends the session configuration params and initializes the session
      *
+     * Runs initSession(), sendAppParams() and sendRangingParams() in turn.
+     * A preset may override it to check its own configuration first.
+     *
+     * @return uwb::Status::SUCCESS if OK
+     */
+    virtual uwb::Status init();
+    /**
+     * @brief first step of init(): runs the validator, if any, and inits the session
+     *
+     * @return uwb::Status::SUCCESS if OK
+     */
+    uwb::Status initSession();
+    /**
+     * @brief second step of init(): sends the app params
+     *
      * @return uwb::Status::SUCCESS if OK
      */
-    uwb::Status init();
+    uwb::Status sendAppParams();
+    /**
+     * @brief last step of init(): sends the ranging params and the static STS IV, if set
+     *
+     * @return uwb::Status::SUCCESS if OK
+     */
+    uwb::Status sendRangingParams();
     /**
      * @brief deinit the session
      */
@@ -222,6 +246,22 @@ public:
      * @return uint8_t
      */
     uwb::Status staticSts(uint16_t vendorId, uint8_t *staticStsIv);
+
+    /**
+     * @brief Set the Static STS IV sent by init(), after the ranging params
+     *
+     * @param vendorId
+     * @param iv 6 bytes
+     */
+    void staticStsIv(uint16_t vendorId, const uint8_t* iv);
+
+    /**
+     * @brief Get the Static STS IV sent by init()
+     *
+     * @param vendorId
+     * @return the 6 bytes IV, nullptr if not set
+     */
+    const uint8_t* staticStsIv(uint16_t& vendorId);
     /**
      * \brief Get Session State
      *
@@ -270,6 +310,38 @@ public:
      */
     void applyDefaults();
 
+    /**
+     * @brief Set a validator run by init() before any command is sent,
+     * init() fails with the validator status if a rule is violated
+     *
+     * @param validator nullptr (default) to skip the validation
+     */
+    void validator(UWBParamValidator* validator);
+
+    /**
+     * @brief Configure the session from a binary profile (see UWBProfile),
+     * e.g. stored in flash or received from a provisioning tool
+     *
+     * array parameters point into the profile, which must outlive the session
+     *
+     * @param profile
+     * @param len size of the profile in bytes
+     * @param vendorParams filled with the vendor params of the profile, if any
+     * @return uwb::Status::SUCCESS if OK, uwb::Status::INVALID_PARAM if the
+     * profile is malformed
+     */
+    uwb::Status loadProfile(const uint8_t* profile, size_t len, UWBVendorParamList* vendorParams = nullptr);
+
+    /**
+     * @brief Write the session configuration as a binary profile
+     *
+     * @param out
+     * @param size size of out
+     * @param vendorParams vendor params to save along, if any
+     * @return size of the profile, 0 if out is too small
+     */
+    size_t saveProfile(uint8_t* out, size_t size, UWBVendorParamList* vendorParams = nullptr);
+
     
   
     bool channel(uint8_t channel);
@@ -284,6 +356,10 @@ protected:
     
     uwb::SessionType type;
     bool isActive; // Indicates whether the session slot is in use
+    UWBParamValidator* paramValidator;
+    bool hasStsIv;
+    uint16_t stsVendorId;
+    uint8_t stsIv[6];
 };
 
 #endif // UWBSESSION_HPP
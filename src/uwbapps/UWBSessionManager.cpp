@@ -26,13 +26,12 @@ bool UWBSessionManager_::deleteSession(uint32_t sessionID)
 }
 bool UWBSessionManager_::addSession(UWBSession& sess)
 {
-    UWBSession *newSess= new UWBSession();
-    newSess->sessionID(sess.sessionID());
-    newSess->sessionType(sess.sessionType());
-    
     if(numSessions >= maxSessions)
         return false;
 
+    // keep a full copy, initAndStartAll() needs the session parameters
+    UWBSession *newSess= new UWBSession(sess);
+
     sessions[numSessions++]= newSess;//&sess;
     return true;
     
@@ -87,6 +86,91 @@ uwb::Status UWBSessionManager_::startSessions()
     return status;
 }
 
+uwb::Status UWBSessionManager_::bringUpStep(UWBSession& sess, BringUpResult::Stage stage)
+{
+    switch (stage)
+    {
+    case BringUpResult::INIT:
+        return sess.initSession();
+    case BringUpResult::APP_CONFIG:
+        return sess.sendAppParams();
+    case BringUpResult::RANGING_PARAMS:
+        return sess.sendRangingParams();
+    case BringUpResult::START:
+        return sess.start();
+    default:
+        return uwb::Status::INVALID_PARAM;
+    }
+}
+
+uwb::Status UWBSessionManager_::initAndStartAll(BringUpReport& report)
+{
+    uwb::Status status = uwb::Status::SUCCESS;
+    uint32_t begin = micros();
+
+    report.count = numSessions;
+    report.started = 0;
+    for (int i = 0; i < numSessions; ++i)
+    {
+        report.sessions[i].sessionID = sessions[i]->sessionID();
+        report.sessions[i].stage = BringUpResult::INIT;
+        report.sessions[i].status = uwb::Status::SUCCESS;
+        report.sessions[i].released = false;
+        memset(report.sessions[i].stageUs, 0, sizeof(report.sessions[i].stageUs));
+    }
+
+    // one stage at a time over all the sessions, the commands still run
+    // one after the other
+    int pending = numSessions;
+    while (pending)
+    {
+        pending = 0;
+        for (int i = 0; i < numSessions; ++i)
+        {
+            BringUpResult& res = report.sessions[i];
+            if (res.stage == BringUpResult::DONE || res.status != uwb::Status::SUCCESS)
+                continue;
+
+            uint32_t t0 = micros();
+            res.status = bringUpStep(*sessions[i], res.stage);
+            res.stageUs[res.stage] = micros() - t0;
+
+            if (res.status != uwb::Status::SUCCESS)
+            {
+                UWBHAL.Log_E("session %08X bring-up failed at stage %d: %d", res.sessionID, res.stage, res.status);
+                status = res.status;
+                // initialized on the chip, give the hardware session back
+                if (res.stage != BringUpResult::INIT)
+                    res.released = sessions[i]->deInit() == uwb::Status::SUCCESS;
+                continue;
+            }
+            res.stage = (BringUpResult::Stage)(res.stage + 1);
+            if (res.stage == BringUpResult::DONE)
+                report.started++;
+            else
+                pending++;
+        }
+    }
+    report.totalUs = micros() - begin;
+
+    UWBHAL.Log_I("bring-up: %d/%d sessions started, %lu us of UCI round trips", report.started, report.count, (unsigned long)report.totalUs);
+    for (int i = 0; i < report.count; ++i)
+    {
+        const BringUpResult& res = report.sessions[i];
+        UWBHAL.Log_I("  %08X status %d%s init %lu cfg %lu rng %lu start %lu", res.sessionID, res.status,
+                     res.released ? " (deinitialized)" : "",
+                     (unsigned long)res.stageUs[BringUpResult::INIT], (unsigned long)res.stageUs[BringUpResult::APP_CONFIG],
+                     (unsigned long)res.stageUs[BringUpResult::RANGING_PARAMS], (unsigned long)res.stageUs[BringUpResult::START]);
+    }
+    return status;
+}
+
+uwb::Status UWBSessionManager_::initAndStartAll()
+{
+    BringUpReport report;
+    return initAndStartAll(report);
+}
+
 uwb::Status UWBSessionManager_::stopSessions()
 {
     uwb::Status status=uwb::Status::SUCCESS;
@@ -7,12 +7,52 @@
 #include "UWBSession.hpp"
 #include <ArduinoBLE.h>
 #include "NearbySession.hpp"
+
+class UWBMultiTracker;
+
 /**
  * @brief Utility class to keep a list of sessions
  * 
  */
 class UWBSessionManager_ {
 public:
+    static const int maxSessions = 5;
+
+    /**
+     * @brief bring-up outcome for a single session, see initAndStartAll()
+     * 
+     * stage is the last step that was attempted for the session, status its
+     * result. stageUs holds the duration of every UCI round trip, in 
+     * microseconds (0 when the step was not reached or skipped). A session
+     * that fails after INIT is deinitialized, so that it does not hold one
+     * of the hardware sessions, released tells whether that succeeded.
+     */
+    struct BringUpResult {
+        enum Stage : uint8_t {
+            INIT = 0,
+            APP_CONFIG,
+            RANGING_PARAMS,
+            START,
+            DONE
+        };
+        uint32_t sessionID;
+        Stage stage;
+        uwb::Status status;
+        bool released;
+        uint32_t stageUs[DONE];
+    };
+
+    /**
+     * @brief result table filled by initAndStartAll()
+     * 
+     */
+    struct BringUpReport {
+        uint8_t count;          // number of valid entries in sessions[]
+        uint8_t started;        // sessions that reached DONE
+        uint32_t totalUs;       // wall time of the whole bring-up, the sum of the round trips
+        BringUpResult sessions[maxSessions];
+    };
+
     /**
      * @brief Construct a new UWBSessionManager_ object
      * 
@@ -36,6 +76,12 @@ public:
      */
     bool addSession(UWBSession& sess);
 
+    /**
+     * @brief not available, the copy kept here would not follow the controlee
+     * list: init() and start() the tracker directly
+     */
+    bool addSession(UWBMultiTracker& sess) = delete;
+
     /**
      * @brief Get the Session By ID 
      * 
@@ -65,6 +111,30 @@ public:
      */
     uwb::Status startSessions();
 
+    /**
+     * @brief initialises, configures and starts all sessions in the list
+     * 
+     * The bring-up of each session is split into its four UCI round trips
+     * (session init, app config, ranging params, start ranging), the same
+     * steps as UWBSession::init() and start(). The steps are issued stage by
+     * stage across the sessions, so every session reaches each state
+     * together instead of one session being fully built before the next is
+     * touched. A session that fails drops out without stalling the others,
+     * and is deinitialized if it got past INIT, so that a retry starts from
+     * a free hardware session.
+     * 
+     * This is not faster than init() and start() called session by session:
+     * the HAL calls block, one at a time, and the total time is the sum of
+     * the round trips. The report tells which step failed and what each
+     * round trip cost.
+     * 
+     * @param report optional, receives per-session status and timings
+     * @return uwb::Status::SUCCESS if every session started, otherwise the
+     * last error seen
+     */
+    uwb::Status initAndStartAll(BringUpReport& report);
+    uwb::Status initAndStartAll();
+
     /**
      * @brief stop all sessions in the list
      * 
@@ -76,9 +146,9 @@ public:
      * @brief utility method implemented in the NerabySessionManager
      * 
      * @param dev 
-     * @return NearbySession& 
+     * @return NearbySession*, nullptr if the device has no session
      */
-    virtual NearbySession& find(BLEDevice dev) {(void)dev; };
+    virtual NearbySession* find(BLEDevice dev) {(void)dev; return nullptr; };
     static UWBSessionManager_& getInstance();
 
 private:
@@ -88,7 +158,8 @@ private:
     void operator=(UWBSessionManager_ const &) = delete;
 
 protected:
-    static const int maxSessions = 5;
+    uwb::Status bringUpStep(UWBSession& sess, BringUpResult::Stage stage);
+
     int numSessions;
     UWBSession* sessions[maxSessions];
     UWBSession emptySession;
@@ -0,0 +1,259 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#include "UWBSessionScheduler.hpp"
+
+UWBSessionScheduler::UWBSessionScheduler(uint8_t hwSessions, uint32_t dwellMs, Policy policy)
+{
+    count = 0;
+    slots = hwSessions;
+    if (slots == 0 || slots > UWBSessionManager_::maxSessions)
+        slots = UWBSessionManager_::maxSessions;
+    dwell = dwellMs;
+    lastRotation = 0;
+    pol = policy;
+    running = false;
+}
+
+UWBSessionScheduler::~UWBSessionScheduler()
+{
+    end();
+    for (int i = 0; i < count; ++i)
+        delete entries[i].session;
+}
+
+bool UWBSessionScheduler::addSession(UWBSession& sess, uint8_t priority)
+{
+    if (count >= maxLogicalSessions)
+        return false;
+    for (int i = 0; i < count; ++i)
+    {
+        if (entries[i].session->sessionID() == sess.sessionID())
+            return false;
+    }
+
+    Entry& e = entries[count++];
+    // the copy is the cached configuration replayed at every swap-in
+    e.session = new UWBSession(sess);
+    e.priority = priority ? priority : 1;
+    e.active = false;
+    e.swaps = 0;
+    e.results = 0;
+    e.added = millis();
+    e.lastUpdate = e.added;
+    e.activeSince = 0;
+    e.activeMs = 0;
+    return true;
+}
+
+bool UWBSessionScheduler::removeSession(uint32_t sessionID)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        if (entries[i].session->sessionID() == sessionID)
+        {
+            if (entries[i].active)
+                swapOut(entries[i], millis());
+            delete entries[i].session;
+            for (int j = i; j < count - 1; ++j)
+                entries[j] = entries[j + 1];
+            count--;
+            return true;
+        }
+    }
+    return false;
+}
+
+uwb::Status UWBSessionScheduler::begin()
+{
+    running = true;
+    return rotate(millis());
+}
+
+void UWBSessionScheduler::poll()
+{
+    if (!running)
+        return;
+
+    uint32_t now = millis();
+    if (now - lastRotation < dwell)
+        return;
+
+    // nothing to rotate when every logical session fits in hardware
+    if (count <= slots)
+    {
+        lastRotation = now;
+        return;
+    }
+    rotate(now);
+}
+
+void UWBSessionScheduler::end()
+{
+    uint32_t now = millis();
+    for (int i = 0; i < count; ++i)
+    {
+        if (entries[i].active)
+            swapOut(entries[i], now);
+    }
+    running = false;
+}
+
+void UWBSessionScheduler::rangingNotified(uint32_t sessionHandle)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        if (entries[i].active && entries[i].session->sessionID() == sessionHandle)
+        {
+            entries[i].results++;
+            entries[i].lastUpdate = millis();
+            return;
+        }
+    }
+}
+
+uint32_t UWBSessionScheduler::score(const Entry& e, uint32_t now) const
+{
+    uint32_t waited = now - e.lastUpdate + 1;
+    if (pol == WEIGHTED)
+        return waited * e.priority;
+    return waited;
+}
+
+uint32_t UWBSessionScheduler::activeTime(const Entry& e, uint32_t now) const
+{
+    return e.activeMs + (e.active ? now - e.activeSince : 0);
+}
+
+bool UWBSessionScheduler::outranks(const Entry& a, const Entry& b, uint32_t now) const
+{
+    uint32_t sa = score(a, now);
+    uint32_t sb = score(b, now);
+    if (sa != sb)
+        return sa > sb;
+    // on a tie the running session stays, a swap costs a re-init
+    return a.active && !b.active;
+}
+
+uwb::Status UWBSessionScheduler::rotate(uint32_t now)
+{
+    uwb::Status status = uwb::Status::SUCCESS;
+    bool keep[maxLogicalSessions] = {false};
+    int picked = 0;
+
+    // the best sessions get a hardware session first: the waiting ones only
+    // with ROUND_ROBIN, active and waiting ranked together with WEIGHTED, so
+    // an active session is evicted only by a waiting one that outranks it
+    for (; picked < slots; ++picked)
+    {
+        int best = -1;
+        for (int i = 0; i < count; ++i)
+        {
+            if (keep[i] || (entries[i].active && pol != WEIGHTED))
+                continue;
+            if (best < 0 || outranks(entries[i], entries[best], now))
+                best = i;
+        }
+        if (best < 0)
+            break;
+        keep[best] = true;
+    }
+
+    // leftover hardware sessions keep the active sessions that ran the
+    // least, so that every one of them rotates out in turn
+    for (; picked < slots; ++picked)
+    {
+        int best = -1;
+        for (int i = 0; i < count; ++i)
+        {
+            if (!entries[i].active || keep[i])
+                continue;
+            if (best < 0 || activeTime(entries[i], now) < activeTime(entries[best], now))
+                best = i;
+        }
+        if (best < 0)
+            break;
+        keep[best] = true;
+    }
+
+    // release first, the chip would refuse the new ones otherwise
+    for (int i = 0; i < count; ++i)
+    {
+        if (entries[i].active && !keep[i])
+            swapOut(entries[i], now);
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        if (keep[i] && !entries[i].active)
+        {
+            uwb::Status res = swapIn(entries[i], now);
+            if (res != uwb::Status::SUCCESS)
+                status = res;
+        }
+    }
+
+    lastRotation = now;
+    return status;
+}
+
+uwb::Status UWBSessionScheduler::swapIn(Entry& e, uint32_t now)
+{
+    uwb::Status res = e.session->init();
+    if (res == uwb::Status::SUCCESS)
+        res = e.session->start();
+
+    if (res != uwb::Status::SUCCESS)
+    {
+        UWBHAL.Log_E("scheduler: session %08X swap-in failed: %d", e.session->sessionID(), res);
+        e.session->deInit();
+        // back of the queue, retried on a later rotation
+        e.lastUpdate = now;
+        return res;
+    }
+    e.active = true;
+    e.activeSince = now;
+    e.swaps++;
+    return res;
+}
+
+void UWBSessionScheduler::swapOut(Entry& e, uint32_t now)
+{
+    e.session->stop();
+    e.session->deInit();
+    e.active = false;
+    e.activeMs += now - e.activeSince;
+    if (pol == ROUND_ROBIN)
+        e.lastUpdate = now;
+}
+
+bool UWBSessionScheduler::stats(int index, Stats& stats)
+{
+    if (index < 0 || index >= count)
+        return false;
+
+    const Entry& e = entries[index];
+    uint32_t now = millis();
+    uint32_t elapsed = now - e.added;
+    uint32_t activeMs = activeTime(e, now);
+
+    stats.sessionID = e.session->sessionID();
+    stats.results = e.results;
+    stats.activeMs = activeMs;
+    stats.swaps = e.swaps;
+    stats.updateRateHz = elapsed ? (e.results * 1000.0f) / elapsed : 0;
+    stats.dutyCycle = elapsed ? (float)activeMs / elapsed : 0;
+    return true;
+}
+
+void UWBSessionScheduler::printReport()
+{
+    Stats st;
+    UWBHAL.Log_I("scheduler: %d logical sessions on %d hardware sessions, dwell %lu ms", count, slots, (unsigned long)dwell);
+    for (int i = 0; i < count; ++i)
+    {
+        stats(i, st);
+        UWBHAL.Log_I("  %08X %s results %lu swaps %u duty %d%% rate %d.%02d Hz", st.sessionID,
+                     entries[i].active ? "active " : "waiting", (unsigned long)st.results, st.swaps,
+                     (int)(st.dutyCycle * 100), (int)st.updateRateHz, (int)(st.updateRateHz * 100) % 100);
+    }
+}
@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#ifndef UWBSESSIONSCHEDULER_HPP
+#define UWBSESSIONSCHEDULER_HPP
+
+#include "UWBSession.hpp"
+#include "UWBSessionManager.hpp"
+
+/**
+ * @brief Time-slices a set of logical sessions over the hardware sessions
+ *
+ * The UWB chip can only keep a handful of sessions initialized at once
+ * (see uwb::Status::MAX_SESSIONS_EXCEEDED). When more peers than that need
+ * to be ranged with, the scheduler keeps every session configuration cached
+ * and rotates them on the available hardware sessions: every dwell period
+ * the sessions that ran are stopped and released, and the ones that waited
+ * the most are re-initialized by replaying their cached parameters.
+ *
+ * Two policies are available:
+ *
+ *     ROUND_ROBIN: the sessions that have been waiting the longest are
+ *     swapped in, and the free hardware sessions keep the active sessions
+ *     that ran the least, every session gets the same share of air time.
+ *
+ *     WEIGHTED: all the sessions, active and waiting, are ranked by
+ *     priority multiplied by staleness (time since their last ranging
+ *     result). An active session is swapped out only when a waiting one
+ *     outranks it, so important or outdated peers are served more often.
+ *
+ * Ranging results must be reported with rangingNotified() from the ranging
+ * callback, they are used for staleness and for the update rate report.
+ *
+ * Example:
+ *
+ *     UWBSessionScheduler scheduler(4, 2000);
+ *     scheduler.addSession(tracker1);
+ *     ...
+ *     scheduler.begin();
+ *
+ *     void loop() { scheduler.poll(); }
+ */
+class UWBSessionScheduler {
+public:
+    enum Policy {
+        ROUND_ROBIN,
+        WEIGHTED
+    };
+
+    static const int maxLogicalSessions = 16;
+
+    /**
+     * @brief per logical session statistics, see stats()
+     *
+     */
+    struct Stats {
+        uint32_t sessionID;
+        uint32_t results;       // ranging notifications received
+        uint32_t activeMs;      // total time spent on a hardware session
+        uint16_t swaps;         // times the session was swapped in
+        float updateRateHz;     // effective ranging update rate since added
+        float dutyCycle;        // share of time spent on a hardware session
+    };
+
+    /**
+     * @brief Construct a new UWBSessionScheduler object
+     *
+     * @param hwSessions number of hardware sessions to use, at most UWBSessionManager_::maxSessions
+     * @param dwellMs time each batch of sessions is kept running, in milliseconds
+     * @param policy rotation policy
+     */
+    UWBSessionScheduler(uint8_t hwSessions = UWBSessionManager_::maxSessions, uint32_t dwellMs = 1000, Policy policy = ROUND_ROBIN);
+    ~UWBSessionScheduler();
+
+    /**
+     * @brief add a logical session, its configuration is copied and cached
+     *
+     * @param sess fully configured session
+     * @param priority weight used by the WEIGHTED policy, 1 or more
+     * @return true on success
+     * @return false if the list is full or the ID is already scheduled
+     */
+    bool addSession(UWBSession& sess, uint8_t priority = 1);
+
+    /**
+     * @brief not available, the cached copy would not follow the controlee list
+     */
+    bool addSession(UWBMultiTracker& sess, uint8_t priority = 1) = delete;
+
+    /**
+     * @brief remove a logical session, stopping it if it is running
+     *
+     * @param sessionID
+     * @return true if found
+     */
+    bool removeSession(uint32_t sessionID);
+
+    /**
+     * @brief set the duty cycle period, in milliseconds
+     *
+     * @param ms
+     */
+    void dwellTime(uint32_t ms) { dwell = ms; }
+    uint32_t dwellTime(void) const { return dwell; }
+
+    void policy(Policy p) { pol = p; }
+    Policy policy(void) const { return pol; }
+
+    /**
+     * @brief start the first batch of sessions
+     *
+     * @return uwb::Status::SUCCESS if all the sessions swapped in started
+     */
+    uwb::Status begin();
+
+    /**
+     * @brief rotate the sessions when the dwell time expired, call it from loop()
+     *
+     */
+    void poll();
+
+    /**
+     * @brief stop and release every running session
+     *
+     */
+    void end();
+
+    /**
+     * @brief report a ranging notification, to be called from the ranging callback
+     *
+     * @param sessionHandle UWBRangingData::sessionHandle()
+     */
+    void rangingNotified(uint32_t sessionHandle);
+
+    /**
+     * @brief get the statistics of a logical session
+     *
+     * @param index 0 to size()-1
+     * @param stats
+     * @return true if index is valid
+     */
+    bool stats(int index, Stats& stats);
+
+    /**
+     * @brief log the update rate of every logical session
+     *
+     */
+    void printReport();
+
+    int size() const { return count; }
+
+private:
+    struct Entry {
+        UWBSession* session;
+        uint8_t priority;
+        bool active;
+        uint16_t swaps;
+        uint32_t results;
+        uint32_t added;         // time the session was added
+        uint32_t lastUpdate;    // last ranging result, or swap-out
+        uint32_t activeSince;
+        uint32_t activeMs;
+    };
+
+    UWBSessionScheduler(UWBSessionScheduler const &) = delete;
+    void operator=(UWBSessionScheduler const &) = delete;
+
+    uwb::Status rotate(uint32_t now);
+    uint32_t score(const Entry& e, uint32_t now) const;
+    bool outranks(const Entry& a, const Entry& b, uint32_t now) const;
+    uint32_t activeTime(const Entry& e, uint32_t now) const;
+    uwb::Status swapIn(Entry& e, uint32_t now);
+    void swapOut(Entry& e, uint32_t now);
+
+    Entry entries[maxLogicalSessions];
+    int count;
+    uint8_t slots;
+    uint32_t dwell;
+    uint32_t lastRotation;
+    Policy pol;
+    bool running;
+};
+
+#endif /* UWBSESSIONSCHEDULER_HPP */
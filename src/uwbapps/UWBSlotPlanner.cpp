@@ -0,0 +1,165 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#include "UWBSlotPlanner.hpp"
+
+// BPRF timings, in nanoseconds
+#define PREAMBLE_SYMBOL_NS      1018    // code length 31, 64 symbols by default
+#define PREAMBLE_SYMBOLS        64
+#define SFD_SYMBOLS             8
+#define STS_SEGMENT_NS          65641   // 64 x 512 chips
+#define PHR_NS                  19487   // 19 bits at 0.975 Mb/s
+#define PSDU_BYTES              64      // longest FiRa ranging message payload
+#define PSDU_BYTE_NS            1177    // 8 bits at 6.8 Mb/s, Reed-Solomon included
+
+// slots shorter than 1ms are not scheduled by FiRa devices
+#define MIN_SLOT_DURATION       1200
+// slot durations are rounded up to 0.1ms
+#define SLOT_GRANULARITY        120
+
+UWBSlotPlanner::UWBSlotPlanner(uint8_t controlees, uwb::RangingMethod method, uwb::RfFrameConfig frame, uint8_t stsSegments)
+{
+    numControlees = controlees;
+    rangingMethod = method;
+    frameConfig = frame;
+    segments = stsSegments;
+    turnaroundUs = 700;
+    spare = 0;
+    requestedMs = 0;
+}
+
+UWBSlotPlanner::Plan UWBSlotPlanner::reject(Plan& p, uwb::Status status, const char* error)
+{
+    p.status = status;
+    p.error = error;
+    return p;
+}
+
+uint16_t UWBSlotPlanner::frameAirtimeUs() const
+{
+    uint32_t ns = (PREAMBLE_SYMBOLS + SFD_SYMBOLS) * PREAMBLE_SYMBOL_NS;
+    ns += segments * STS_SEGMENT_NS;
+    // SP3 frames carry no PHR nor payload
+    if (frameConfig != uwb::RfFrameConfig::SP3)
+        ns += PHR_NS + PSDU_BYTES * PSDU_BYTE_NS;
+    return (ns + 999) / 1000;
+}
+
+UWBSlotPlanner::Plan UWBSlotPlanner::plan() const
+{
+    Plan p;
+    memset(&p, 0, sizeof(p));
+    p.controlSlot = p.pollSlot = p.finalSlot = p.reportSlot = NO_SLOT;
+    memset(p.responseSlot, NO_SLOT, sizeof(p.responseSlot));
+    memset(p.resultSlot, NO_SLOT, sizeof(p.resultSlot));
+    p.controlees = numControlees;
+
+    if (numControlees == 0 || numControlees > uwb::MAX_RESPONDERS)
+        return reject(p, uwb::Status::INVALID_RANGE, "controlees must be 1 to MAX_RESPONDERS");
+
+    bool doubleSided;
+    bool deferred;
+    switch (rangingMethod)
+    {
+    case uwb::RangingMethod::SS_TWR:
+        doubleSided = false;
+        deferred = true;
+        break;
+    case uwb::RangingMethod::DS_TWR:
+        doubleSided = true;
+        deferred = true;
+        break;
+    case uwb::RangingMethod::SS_TWR_NO_DEFER:
+        doubleSided = false;
+        deferred = false;
+        break;
+    case uwb::RangingMethod::DS_TWR_NO_DEFER:
+        doubleSided = true;
+        deferred = false;
+        break;
+    default:
+        return reject(p, uwb::Status::INVALID_PARAM, "only TWR methods are time scheduled");
+    }
+
+    if (frameConfig == uwb::RfFrameConfig::SP0)
+    {
+        if (segments != 0)
+            return reject(p, uwb::Status::INVALID_PARAM, "SP0 frames have no STS segments");
+    }
+    else if (frameConfig <= uwb::RfFrameConfig::SP3)
+    {
+        if (segments == 0 || segments > 4)
+            return reject(p, uwb::Status::INVALID_RANGE, "STS frames need 1 to 4 STS segments");
+    }
+    else
+        return reject(p, uwb::Status::INVALID_PARAM, "unknown RFRAME config");
+
+    if (frameConfig == uwb::RfFrameConfig::SP3 && !deferred)
+        return reject(p, uwb::Status::INVALID_PARAM, "SP3 frames cannot carry non-deferred results");
+
+    // lay the messages out in the order they are exchanged
+    uint16_t slot = 0;
+    p.controlSlot = slot++;
+    p.pollSlot = slot++;
+    for (int i = 0; i < numControlees; ++i)
+        p.responseSlot[i] = slot++;
+    if (doubleSided)
+        p.finalSlot = slot++;
+    if (deferred)
+    {
+        if (doubleSided)
+            p.reportSlot = slot++;
+        for (int i = 0; i < numControlees; ++i)
+            p.resultSlot[i] = slot++;
+    }
+    slot += spare;
+    if (slot > 0xFF)
+        return reject(p, uwb::Status::INVALID_RANGE, "too many slots per ranging round");
+    p.slotsPerRR = slot;
+
+    p.frameUs = frameAirtimeUs();
+    uint32_t duration = ((p.frameUs + turnaroundUs) * RSTU_PER_MS + 999) / 1000;
+    duration = (duration + SLOT_GRANULARITY - 1) / SLOT_GRANULARITY * SLOT_GRANULARITY;
+    if (duration < MIN_SLOT_DURATION)
+        duration = MIN_SLOT_DURATION;
+    if (duration > 0xFFFF)
+        return reject(p, uwb::Status::INVALID_RANGE, "turnaround too long for a slot");
+    p.slotDuration = duration;
+
+    uint32_t roundRstu = (uint32_t)p.slotsPerRR * p.slotDuration;
+    p.minRangingDuration = (roundRstu + RSTU_PER_MS - 1) / RSTU_PER_MS;
+    p.maxUpdateRateHz = 1000.0f / p.minRangingDuration;
+
+    if (requestedMs && requestedMs < p.minRangingDuration)
+        return reject(p, uwb::Status::INVALID_RANGE, "ranging duration shorter than the ranging round");
+    p.rangingDuration = requestedMs ? requestedMs : p.minRangingDuration;
+
+    p.status = uwb::Status::SUCCESS;
+    p.error = nullptr;
+    return p;
+}
+
+bool UWBSlotPlanner::apply(UWBAppParamList& params) const
+{
+    Plan p = plan();
+    if (p.status != uwb::Status::SUCCESS)
+    {
+        UWBHAL.Log_E("slot planner: %s", p.error);
+        return false;
+    }
+
+    bool ok = params.frameConfig(frameConfig);
+    ok = ok && params.stsSegments(segments);
+    ok = ok && params.noOfControlees(p.controlees);
+    ok = ok && params.slotPerRR(p.slotsPerRR);
+    ok = ok && params.slotDuration(p.slotDuration);
+    ok = ok && params.rangingDuration(p.rangingDuration);
+    if (!ok)
+    {
+        UWBHAL.Log_E("slot planner: parameter list full");
+        return false;
+    }
+    UWBHAL.Log_D("slot planner: %u slots of %u RSTU, round %u ms, max %d Hz", p.slotsPerRR, p.slotDuration,
+                 p.rangingDuration, (int)p.maxUpdateRateHz);
+    return true;
+}
@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Truesense Srl
+
+#ifndef UWBSLOTPLANNER_HPP
+#define UWBSLOTPLANNER_HPP
+
+#include "hal/uwb_hal.hpp"
+#include "UWBAppParamList.hpp"
+
+/**
+ * @brief Plans the slot schedule of a time-scheduled TWR session
+ *
+ * Given the number of controlees, the ranging method, the RFRAME config and
+ * the number of STS segments, the planner computes the slots needed by one
+ * ranging round (see the diagram in UWBAppParamList::rangingDuration()),
+ * the shortest slot that fits a frame plus the device turnaround time, and
+ * from there the shortest ranging round and the best update rate.
+ *
+ * Messages exchanged in a round with N controlees:
+ *
+ *     SS-TWR          RCM, Poll, N x Response, N x Measurement Report
+ *     SS-TWR no defer RCM, Poll, N x Response
+ *     DS-TWR          RCM, Poll, N x Response, Final, Report, N x Result
+ *     DS-TWR no defer RCM, Poll, N x Response, Final
+ *
+ * Impossible combinations (e.g. SP0 with STS segments, more controlees than
+ * uwb::MAX_RESPONDERS, a ranging duration shorter than the round) are
+ * rejected by plan() and never written to the parameters.
+ *
+ * Example:
+ *
+ *     UWBSlotPlanner planner(4, uwb::RangingMethod::DS_TWR, uwb::RfFrameConfig::SP3, 1);
+ *     if (!planner.apply(session.appParams))
+ *         Serial.println(planner.plan().error);
+ */
+class UWBSlotPlanner {
+public:
+    static const uint16_t RSTU_PER_MS = 1200;
+    static const uint8_t NO_SLOT = 0xFF;
+
+    /**
+     * @brief outcome of the planning
+     *
+     * slot indexes are 0-based positions in the ranging round, NO_SLOT when
+     * the message does not exist for the chosen method
+     */
+    struct Plan {
+        uwb::Status status;             // SUCCESS or INVALID_PARAM/INVALID_RANGE
+        const char* error;              // reason of the rejection, nullptr if OK
+        uint8_t controlees;
+        uint8_t slotsPerRR;
+        uint16_t slotDuration;          // RSTU
+        uint16_t frameUs;               // air time of the longest frame
+        uint16_t minRangingDuration;    // ms, shortest feasible round
+        uint16_t rangingDuration;       // ms, the one that will be configured
+        float maxUpdateRateHz;          // 1000 / minRangingDuration
+
+        uint8_t controlSlot;            // Ranging Control Message
+        uint8_t pollSlot;
+        uint8_t finalSlot;
+        uint8_t reportSlot;             // controller measurement report
+        uint8_t responseSlot[uwb::MAX_RESPONDERS];
+        uint8_t resultSlot[uwb::MAX_RESPONDERS];
+    };
+
+    /**
+     * @brief Construct a new UWBSlotPlanner object
+     *
+     * @param controlees number of controlees, 1 to uwb::MAX_RESPONDERS
+     * @param method SS_TWR, DS_TWR or their no-defer variants
+     * @param frame SP0, SP1 or SP3
+     * @param stsSegments 0 for SP0, 1 to 4 otherwise
+     */
+    UWBSlotPlanner(uint8_t controlees, uwb::RangingMethod method, uwb::RfFrameConfig frame, uint8_t stsSegments);
+
+    /**
+     * @brief time needed by the device between the end of a frame and the
+     * next slot (RX processing, TX preparation), in microseconds. Default 700
+     *
+     */
+    void turnaround(uint16_t us) { turnaroundUs = us; }
+
+    /**
+     * @brief extra slots appended to the round for retransmissions, default 0
+     *
+     */
+    void spareSlots(uint8_t slots) { spare = slots; }
+
+    /**
+     * @brief requested ranging duration in ms, 0 (default) for the shortest one
+     *
+     */
+    void rangingDuration(uint16_t ms) { requestedMs = ms; }
+
+    /**
+     * @brief compute the schedule
+     *
+     */
+    Plan plan() const;
+
+    /**
+     * @brief compute the schedule and write it in the app parameters
+     * (slots per RR, slot duration, ranging duration, number of controlees,
+     * RFRAME config and STS segments)
+     *
+     * @param params
+     * @return true if the schedule is feasible and was written
+     * @return false if the schedule was rejected (params left untouched) or
+     * the list is full
+     */
+    bool apply(UWBAppParamList& params) const;
+
+private:
+    static Plan reject(Plan& p, uwb::Status status, const char* error);
+    uint16_t frameAirtimeUs() const;
+
+    uint8_t numControlees;
+    uwb::RangingMethod rangingMethod;
+    uwb::RfFrameConfig frameConfig;
+    uint8_t segments;
+    uint16_t turnaroundUs;
+    uint8_t spare;
+    uint16_t requestedMs;
+};
+
+#endif /* UWBSLOTPLANNER_HPP */
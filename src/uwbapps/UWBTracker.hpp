@@ -4,6 +4,7 @@
 #include "hal/uwb_hal.hpp"
 #include "UWB.hpp"
 #include "UWBSession.hpp"
+#include "UWBPreset.hpp"
 
 
 class  UWBTracker:public UWBSession {
@@ -23,14 +24,8 @@ public:
 		rangingParams.rangingRoundUsage(uwb::RangingMethod::DS_TWR);
 
 
-		appParams.frameConfig(uwb::RfFrameConfig::SP3);
-		appParams.slotPerRR(25);
-		appParams.rangingDuration(200);
-		appParams.maxRetries(0);
-		appParams.sfdId(2);
-		appParams.preambleCodeIndex(10);
-		appParams.stsConfig(uwb::StsConfig::StaticSts);
-    	appParams.stsSegments(1);
+		//SP3, 25 slots, 200ms rounds, static STS, see UWBPreset.cpp
+		appParams.load(UWBPreset::tracker.data, UWBPreset::tracker.size);
 	}      		
 };
 
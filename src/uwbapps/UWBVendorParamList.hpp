@@ -11,17 +11,20 @@
 class UWBVendorParamList: public UWBAppParamsList<uwb::VendorAppConfig, 
                                                  uwb::VendorAppConfigId,
                                                  uwb::AppParamType,
-                                                 uwb::AppParamValue> 
+                                                 uwb::AppParamValue,
+                                                 16>
 {
 public:
     // Constructor
     UWBVendorParamList() : UWBAppParamsList<uwb::VendorAppConfig, 
                                                  uwb::VendorAppConfigId,
                                                  uwb::AppParamType,
-                                                 uwb::AppParamValue>() 
+                                                 uwb::AppParamValue,
+                                                 16>() 
     
     {
         
+        // copied into the list, the local array can go out of scope
         uint8_t antennaeConfigurationRx[] = { 1, 0x01, (1)};
         const uint8_t antennaeConfigurationRx_size = 3;
         uwb::VendorAppConfig antennaParam;